@@ -0,0 +1,179 @@
+// Benchmark for CompactNetlist::reorderForLocality.
+//
+// Builds a layered random netlist whose net names are unrelated to its
+// structure (as in real designs, where map order scatters neighbouring nets
+// across the metric arrays), then times all four SCOAP passes with the nets
+// in map order and after reordering, checks that both give the same metrics
+// per net, and reports cache misses where hardware counters are available.
+
+#include "CompactNetlist.h"
+#include "ScoapEngine.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Counts last-level cache misses of the calling thread; reports -1 where
+// perf events are not available.
+class CacheMissCounter {
+public:
+    CacheMissCounter() {
+#ifdef __linux__
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+    ~CacheMissCounter() {
+#ifdef __linux__
+        if (fd >= 0) close(fd);
+#endif
+    }
+    void start() {
+#ifdef __linux__
+        if (fd < 0) return;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+    long long stop() {
+#ifdef __linux__
+        if (fd < 0) return -1;
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        long long count = 0;
+        if (read(fd, &count, sizeof(count)) != sizeof(count)) return -1;
+        return count;
+#else
+        return -1;
+#endif
+    }
+
+private:
+    int fd = -1;
+};
+
+// `levels` layers of `width` gates with 2-4 inputs from the previous layer.
+// Names are random, so map order does not follow the structure.
+void buildNetlist(int levels, int width, unsigned seed, std::vector<Gate>& gates,
+                  NetMap& nets, std::vector<NetName>& primaryOutputs) {
+    static const char* types[] = {"and", "nand", "or", "nor", "xor", "not", "buf"};
+    std::mt19937 rng(seed);
+    auto randomName = [&]() {
+        std::string name = "n";
+        for (int i = 0; i < 12; ++i) name += static_cast<char>('a' + rng() % 26);
+        return name;
+    };
+    std::vector<NetName> previous;
+    for (int i = 0; i < width; ++i) {
+        const NetName name(randomName(), NetName::Scalar);
+        nets[name] = {name, "P", {}, {}, 0, INF, INF, INF, INF, INF, INF, false, false};
+        previous.push_back(name);
+    }
+    for (int level = 1; level <= levels; ++level) {
+        std::vector<NetName> current;
+        for (int i = 0; i < width; ++i) {
+            Gate g;
+            g.name = "g" + std::to_string(gates.size());
+            g.type = types[rng() % 7];
+            g.kind = gateTypeFromString(g.type);
+            g.output = NetName(randomName(), NetName::Scalar);
+            nets[g.output] = {g.output, "", {g.name}, {}, level, INF, INF, INF, INF, INF, INF, false, false};
+            const int arity = (g.kind == GateType::Not || g.kind == GateType::Buf) ? 1 : 2 + static_cast<int>(rng() % 3);
+            for (int k = 0; k < arity; ++k) {
+                // Mostly nearby nets of the previous layer, as in placed logic
+                const int j = (i + static_cast<int>(rng() % 64) - 32 + width) % width;
+                g.inputs.push_back(previous[j]);
+                nets[previous[j]].loads.push_back(g.name);
+            }
+            current.push_back(g.output);
+            gates.push_back(std::move(g));
+        }
+        previous.swap(current);
+    }
+    for (const auto& name : previous) {
+        nets[name].type = "O";
+        primaryOutputs.push_back(name);
+    }
+}
+
+struct Run {
+    double ms;
+    long long misses;
+    std::vector<uint32_t> metrics; // By map position, 6 per net
+};
+
+Run runPasses(const CompactNetlist& nl, CacheMissCounter& counter) {
+    ScoapEngine<uint32_t> engine(nl);
+    counter.start();
+    auto start = std::chrono::steady_clock::now();
+    engine.computeCombinationalControllability();
+    engine.computeSequentialControllability();
+    engine.computeCombinationalObservability();
+    engine.computeSequentialObservability();
+    Run run;
+    run.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    run.misses = counter.stop();
+    run.metrics.resize(nl.numNets() * 6);
+    for (size_t id = 0; id < nl.numNets(); ++id) {
+        uint32_t* m = &run.metrics[static_cast<size_t>(nl.netPosition[id]) * 6];
+        m[0] = engine.cc0[id]; m[1] = engine.cc1[id]; m[2] = engine.sc0[id];
+        m[3] = engine.sc1[id]; m[4] = engine.co[id]; m[5] = engine.so[id];
+    }
+    return run;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const int levels = argc > 1 ? std::atoi(argv[1]) : 50;
+    const int width = argc > 2 ? std::atoi(argv[2]) : 20000;
+    const int repeats = argc > 3 ? std::atoi(argv[3]) : 3;
+
+    std::vector<Gate> gates;
+    std::vector<FlipFlop> flipflops;
+    NetMap nets;
+    std::vector<NetName> primaryOutputs;
+    buildNetlist(levels, width, 4321u, gates, nets, primaryOutputs);
+    CompactNetlist mapOrder = CompactNetlist::build(gates, flipflops, nets, primaryOutputs);
+    CompactNetlist reordered = mapOrder;
+    reordered.reorderForLocality();
+
+    CacheMissCounter counter;
+    std::cout << "levels=" << levels << " width=" << width << " gates=" << mapOrder.numGates() << "\n";
+    std::cout << "order,best_ms,cache_misses\n";
+    bool ok = true;
+    std::vector<uint32_t> reference;
+    for (const CompactNetlist* nl : {&mapOrder, &reordered}) {
+        Run best{};
+        best.ms = 1e300;
+        for (int r = 0; r < repeats; ++r) {
+            Run run = runPasses(*nl, counter);
+            if (run.ms < best.ms) best = std::move(run);
+        }
+        if (reference.empty()) {
+            reference = best.metrics;
+        } else if (best.metrics != reference) {
+            std::cerr << "Metrics differ after reordering" << std::endl;
+            ok = false;
+        }
+        std::cout << (nl == &mapOrder ? "map" : "locality") << "," << best.ms << ","
+                  << (best.misses < 0 ? std::string("n/a") : std::to_string(best.misses)) << "\n";
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,124 @@
+// Benchmark for combinational observability on netlists with very wide gates.
+//
+// For each gate width it builds a layered random netlist of and/nand/or/nor/xor
+// gates, runs the engine's CO pass and a straightforward O(n^2) per-gate
+// reference, checks that both agree, and reports the time of each.
+
+#include "CompactNetlist.h"
+#include "GateKernels.h"
+#include "ScoapEngine.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+namespace {
+
+// Builds `levels` layers of `width` gates with `arity` inputs each, drawn from
+// the previous layer (the first layer reads the primary inputs).
+void buildWideNetlist(int levels, int width, int arity, unsigned seed,
+                      std::vector<Gate>& gates, NetMap& nets,
+                      std::vector<NetName>& primaryOutputs) {
+    static const char* types[] = {"and", "nand", "or", "nor", "xor"};
+    std::mt19937 rng(seed);
+    std::vector<NetName> previous;
+    for (int i = 0; i < width; ++i) {
+        const NetName name("pi" + std::to_string(i), NetName::Scalar);
+        nets[name] = {name, "P", {}, {}, 0, INF, INF, INF, INF, INF, INF, false, false};
+        previous.push_back(name);
+    }
+    for (int level = 1; level <= levels; ++level) {
+        std::vector<NetName> current;
+        for (int i = 0; i < width; ++i) {
+            Gate g;
+            g.name = "g" + std::to_string(level) + "_" + std::to_string(i);
+            g.type = types[rng() % 5];
+            g.kind = gateTypeFromString(g.type);
+            g.output = NetName("n" + std::to_string(level) + "_" + std::to_string(i), NetName::Scalar);
+            nets[g.output] = {g.output, "", {g.name}, {}, level, INF, INF, INF, INF, INF, INF, false, false};
+            for (int k = 0; k < arity; ++k) {
+                const NetName& inp = previous[rng() % previous.size()];
+                g.inputs.push_back(inp);
+                nets[inp].loads.push_back(g.name);
+            }
+            current.push_back(g.output);
+            gates.push_back(std::move(g));
+        }
+        previous.swap(current);
+    }
+    for (const auto& name : previous) {
+        nets[name].type = "O";
+        primaryOutputs.push_back(name);
+    }
+}
+
+// Reference CO: re-sums all other inputs for every input of every gate.
+template <typename T>
+std::vector<T> quadraticObservability(const CompactNetlist& nl, const std::vector<T>& cc0, const std::vector<T>& cc1) {
+    using M = Metric<T>;
+    std::vector<T> co(nl.numNets(), M::INF);
+    for (size_t n = 0; n < nl.numNets(); ++n) {
+        if (nl.netFlags[n] & CompactNetlist::PrimaryOutput) co[n] = 0;
+    }
+    for (size_t g = nl.numGates(); g-- > 0;) {
+        T coY = co[nl.gateOutput[g]];
+        if (coY == M::INF) continue;
+        const int32_t* in = nl.gateInputs.data() + nl.gateInputBegin[g];
+        const size_t n = nl.gateInputBegin[g + 1] - nl.gateInputBegin[g];
+        for (size_t i = 0; i < n; ++i) {
+            T sum = 0;
+            for (size_t j = 0; j < n; ++j) {
+                if (j == i) continue;
+                switch (nl.gateType[g]) {
+                case GateType::And: case GateType::Nand: sum = M::add(sum, cc1[in[j]]); break;
+                case GateType::Or: case GateType::Nor: sum = M::add(sum, cc0[in[j]]); break;
+                default: sum = M::add(sum, M::min(cc0[in[j]], cc1[in[j]])); break;
+                }
+            }
+            co[in[i]] = M::min(co[in[i]], M::add(M::add(coY, sum), 1));
+        }
+    }
+    return co;
+}
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const int levels = argc > 1 ? std::atoi(argv[1]) : 20;
+    const int width = argc > 2 ? std::atoi(argv[2]) : 2000;
+
+    std::cout << "levels=" << levels << " width=" << width << "\n";
+    std::cout << "arity,gates,engine_ms,quadratic_ms,speedup\n";
+    bool ok = true;
+    for (int arity : {32, 64, 128, 256}) {
+        std::vector<Gate> gates;
+        std::vector<FlipFlop> flipflops;
+        NetMap nets;
+        std::vector<NetName> primaryOutputs;
+        buildWideNetlist(levels, width, arity, 1234u + arity, gates, nets, primaryOutputs);
+        CompactNetlist nl = CompactNetlist::build(gates, flipflops, nets, primaryOutputs);
+
+        ScoapEngine<uint32_t> engine(nl);
+        engine.computeCombinationalControllability();
+
+        auto start = std::chrono::steady_clock::now();
+        engine.computeCombinationalObservability();
+        double engineMs = millisecondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        std::vector<uint32_t> reference = quadraticObservability(nl, engine.cc0, engine.cc1);
+        double quadraticMs = millisecondsSince(start);
+
+        if (reference != engine.co) {
+            std::cerr << "CO mismatch at arity " << arity << std::endl;
+            ok = false;
+        }
+        std::cout << arity << "," << nl.numGates() << "," << engineMs << ","
+                  << quadraticMs << "," << quadraticMs / engineMs << "\n";
+    }
+    return ok ? 0 : 1;
+}
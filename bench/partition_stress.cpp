@@ -0,0 +1,132 @@
+// Stress test for the out-of-core (partitioned) engine.
+//
+// Streams a synthetic layered netlist of 2-input gates with a bank of
+// D flip-flops into a PartitionedEngine without ever holding the netlist in
+// memory, computes all SCOAP metrics within the memory budget, and checks
+// the process's peak resident memory against a fixed limit. Small runs are
+// also checked against the same netlist evaluated as a single partition.
+
+#include "PartitionedEngine.h"
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+
+namespace {
+
+constexpr int32_t kWidth = 4096;      // Nets per layer
+constexpr int32_t kFlipFlops = 1024;
+
+// Generates `gates` gates in layers of kWidth. Each gate reads two nets of
+// the previous layer; the first layer reads primary inputs and flip-flop
+// outputs, and the flip-flops are fed from the last layer.
+template <typename T>
+void streamNetlist(PartitionedEngine<T>& engine, uint64_t gates, unsigned seed) {
+    static const GateType types[] = {GateType::And, GateType::Nand, GateType::Or, GateType::Nor, GateType::Xor};
+    std::mt19937 rng(seed);
+    const int32_t clk = engine.addNet(CompactNetlist::PrimaryInput);
+    std::vector<int32_t> previous;
+    for (int32_t i = 0; i < kWidth; ++i) previous.push_back(engine.addNet(CompactNetlist::PrimaryInput));
+    std::vector<int32_t> q;
+    for (int32_t i = 0; i < kFlipFlops; ++i) {
+        q.push_back(engine.addNet(CompactNetlist::FlipFlopOutput));
+        previous.push_back(q.back());
+    }
+
+    std::vector<int32_t> current;
+    uint32_t level = 0;
+    for (uint64_t g = 0; g < gates; ++level) {
+        const bool last = gates - g <= static_cast<uint64_t>(kWidth);
+        current.clear();
+        for (int32_t i = 0; i < kWidth && g < gates; ++i, ++g) {
+            engine.checkpoint();
+            const int32_t out = engine.addNet(last ? CompactNetlist::PrimaryOutput : 0);
+            const int32_t in[2] = {previous[rng() % previous.size()], previous[rng() % previous.size()]};
+            engine.addGate(level, types[rng() % 5], -1, -1, out, in, 2);
+            current.push_back(out);
+        }
+        previous.swap(current);
+    }
+    for (int32_t i = 0; i < kFlipFlops; ++i) {
+        engine.addFlipFlop(FlipFlopType::D, clk, q[i], previous[i % previous.size()], -1, -1, -1, -1);
+    }
+}
+
+// Peak resident set size in MB, or 0 where /proc is not available.
+double peakResidentMB() {
+    std::ifstream status("/proc/self/status");
+    std::string key;
+    while (status >> key) {
+        if (key == "VmHWM:") {
+            double kb = 0;
+            status >> kb;
+            return kb / 1024;
+        }
+        status.ignore(1 << 20, '\n');
+    }
+    return 0;
+}
+
+std::string scratchDirectory(const char* tag) {
+    return (std::filesystem::temp_directory_path() / (std::string("scoap_stress_") + tag)).string();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const uint64_t gates = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 50000000ull;
+    const double budgetMB = argc > 2 ? std::atof(argv[2]) : 512;
+    const double limitMB = argc > 3 ? std::atof(argv[3]) : 1024;
+    const size_t budget = static_cast<size_t>(budgetMB * 1024 * 1024);
+    const unsigned seed = 2024;
+
+    std::cout << "gates=" << gates << " budget_mb=" << budgetMB << " limit_mb=" << limitMB << std::endl;
+    auto start = std::chrono::steady_clock::now();
+    PartitionedEngine<uint32_t> engine(scratchDirectory("run"), budget);
+    streamNetlist(engine, gates, seed);
+    engine.finish();
+    const double buildSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    engine.computeAll();
+    const double computeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const double peak = peakResidentMB();
+    std::cout << "nets=" << engine.numNets() << " partitions=" << engine.numPartitions()
+              << " boundary_nets=" << engine.numBoundaryNets() << "\n"
+              << "build_s=" << buildSeconds << " compute_s=" << computeSeconds << " peak_rss_mb=" << peak << std::endl;
+
+    bool ok = true;
+    if (peak > limitMB) {
+        std::cerr << "Peak resident memory " << peak << " MB exceeds the limit of " << limitMB << " MB" << std::endl;
+        ok = false;
+    }
+
+    // Small runs: the partitioned results must equal a single partition's.
+    if (gates <= 2000000 && engine.numPartitions() > 1) {
+        PartitionedEngine<uint32_t> whole(scratchDirectory("whole"), size_t(1) << 40);
+        streamNetlist(whole, gates, seed);
+        whole.finish();
+        whole.computeAll();
+        std::vector<uint32_t> expected;
+        whole.forEachNet([&](int32_t, uint32_t cc0, uint32_t cc1, uint32_t sc0, uint32_t sc1, uint32_t co, uint32_t so) {
+            expected.insert(expected.end(), {cc0, cc1, sc0, sc1, co, so});
+        });
+        size_t i = 0;
+        engine.forEachNet([&](int32_t n, uint32_t cc0, uint32_t cc1, uint32_t sc0, uint32_t sc1, uint32_t co, uint32_t so) {
+            const uint32_t got[] = {cc0, cc1, sc0, sc1, co, so};
+            for (uint32_t v : got) {
+                if (ok && v != expected[i]) {
+                    std::cerr << "Metric mismatch at net " << n << std::endl;
+                    ok = false;
+                }
+                ++i;
+            }
+        });
+        std::cout << "verified against a single partition: " << (ok ? "ok" : "FAILED") << std::endl;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,223 @@
+#include "CellLibrary.h"
+#include "VerilogParser.h" // For ParsingException
+#include <algorithm>
+#include <bitset>
+#include <cctype>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+// Built-in cells. Pin order follows the usual standard-cell conventions.
+const char* kBuiltinCells = R"(
+cell mux2   a b s       : (a & !s) | (b & s)
+cell ao21   a1 a2 b     : (a1 & a2) | b
+cell ao22   a1 a2 b1 b2 : (a1 & a2) | (b1 & b2)
+cell aoi21  a1 a2 b     : !((a1 & a2) | b)
+cell aoi22  a1 a2 b1 b2 : !((a1 & a2) | (b1 & b2))
+cell aoi211 a1 a2 b c   : !((a1 & a2) | b | c)
+cell oa21   a1 a2 b     : (a1 | a2) & b
+cell oa22   a1 a2 b1 b2 : (a1 | a2) & (b1 | b2)
+cell oai21  a1 a2 b     : !((a1 | a2) & b)
+cell oai22  a1 a2 b1 b2 : !((a1 | a2) & (b1 | b2))
+cell oai211 a1 a2 b c   : !((a1 | a2) & b & c)
+cell tiehi              : 1
+cell tielo              : 0
+cell tie1               : 1
+cell tie0               : 0
+)";
+
+using TruthTable = std::bitset<1u << CellLibrary::kMaxPins>;
+
+std::string toLower(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return std::tolower(c); });
+    return s;
+}
+
+// Recursive-descent evaluator for cell functions. The expression is parsed
+// once into postfix form and then evaluated for every input minterm.
+class FunctionParser {
+public:
+    FunctionParser(const std::string& text, const std::vector<std::string>& pins)
+        : text(text), pins(pins) {}
+
+    TruthTable truthTable() {
+        parseOr();
+        skipSpace();
+        if (pos != text.size()) fail("unexpected '" + text.substr(pos, 1) + "'");
+
+        TruthTable table;
+        const uint32_t minterms = 1u << pins.size();
+        std::vector<bool> stack;
+        for (uint32_t m = 0; m < minterms; ++m) {
+            stack.clear();
+            for (int op : program) {
+                if (op >= 0) { stack.push_back((m >> op) & 1u); continue; }
+                if (op == kNot) { stack.back() = !stack.back(); continue; }
+                if (op == kZero || op == kOne) { stack.push_back(op == kOne); continue; }
+                bool b = stack.back(); stack.pop_back();
+                bool a = stack.back();
+                stack.back() = op == kAnd ? (a && b) : op == kOr ? (a || b) : (a != b);
+            }
+            table[m] = stack.back();
+        }
+        return table;
+    }
+
+private:
+    // Negative opcodes; non-negative entries push input pin values.
+    enum { kNot = -1, kAnd = -2, kOr = -3, kXor = -4, kZero = -5, kOne = -6 };
+
+    const std::string& text;
+    const std::vector<std::string>& pins;
+    size_t pos = 0;
+    std::vector<int> program;
+
+    [[noreturn]] void fail(const std::string& message) const {
+        throw ParsingException("Invalid cell function '" + text + "': " + message);
+    }
+    void skipSpace() {
+        while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) ++pos;
+    }
+    bool accept(char c) {
+        skipSpace();
+        if (pos < text.size() && text[pos] == c) { ++pos; return true; }
+        return false;
+    }
+    void parseOr() {
+        parseXor();
+        while (accept('|')) { parseXor(); program.push_back(kOr); }
+    }
+    void parseXor() {
+        parseAnd();
+        while (accept('^')) { parseAnd(); program.push_back(kXor); }
+    }
+    void parseAnd() {
+        parseUnary();
+        while (accept('&')) { parseUnary(); program.push_back(kAnd); }
+    }
+    void parseUnary() {
+        if (accept('!') || accept('~')) { parseUnary(); program.push_back(kNot); return; }
+        if (accept('(')) {
+            parseOr();
+            if (!accept(')')) fail("missing ')'");
+            return;
+        }
+        skipSpace();
+        size_t start = pos;
+        while (pos < text.size() && (std::isalnum(static_cast<unsigned char>(text[pos])) || text[pos] == '_')) ++pos;
+        std::string word = text.substr(start, pos - start);
+        if (word.empty()) fail("expected an operand");
+        if (word == "0" || word == "1") { program.push_back(word == "1" ? kOne : kZero); return; }
+        auto it = std::find(pins.begin(), pins.end(), toLower(word));
+        if (it == pins.end()) fail("unknown pin '" + word + "'");
+        program.push_back(static_cast<int>(it - pins.begin()));
+    }
+};
+
+// True if every minterm of the cube lies in the set.
+bool isImplicant(const TruthTable& set, int numPins, CellCube cube) {
+    const uint32_t minterms = 1u << numPins;
+    for (uint32_t m = 0; m < minterms; ++m) {
+        if ((m & cube.care) == cube.value && !set[m]) return false;
+    }
+    return true;
+}
+
+// All prime implicants of a function given by its truth table.
+std::vector<CellCube> primeImplicants(const TruthTable& set, int numPins) {
+    std::vector<CellCube> primes;
+    const uint32_t all = (1u << numPins) - 1;
+    for (uint32_t care = 0; care <= all; ++care) {
+        // Enumerate the values on the care bits as a sub-mask walk.
+        for (uint32_t value = care;; value = (value - 1) & care) {
+            CellCube cube{care, value};
+            if (isImplicant(set, numPins, cube)) {
+                bool prime = true;
+                for (uint32_t bits = care; bits && prime; bits &= bits - 1) {
+                    uint32_t bit = bits & (0u - bits);
+                    if (isImplicant(set, numPins, {care & ~bit, value & ~bit})) prime = false;
+                }
+                if (prime) primes.push_back(cube);
+            }
+            if (value == 0) break;
+        }
+    }
+    return primes;
+}
+
+} // namespace
+
+CellLibrary CellLibrary::builtin() {
+    CellLibrary library;
+    std::istringstream in(kBuiltinCells);
+    library.load(in, "<builtin>");
+    return library;
+}
+
+void CellLibrary::loadFromFile(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw ParsingException("Could not open cell library: " + filename);
+    }
+    load(file, filename);
+}
+
+void CellLibrary::load(std::istream& in, const std::string& source) {
+    std::string line;
+    int lineNumber = 0;
+    while (getline(in, line)) {
+        ++lineNumber;
+        line = line.substr(0, line.find('#'));
+        size_t colon = line.find(':');
+        std::istringstream header(line.substr(0, colon));
+        std::string keyword, name, pin;
+        if (!(header >> keyword)) continue;
+        if (keyword != "cell" || !(header >> name) || colon == std::string::npos) {
+            throw ParsingException(source + ":" + std::to_string(lineNumber) + ": expected 'cell <name> <pins...> : <function>'");
+        }
+        std::vector<std::string> pins;
+        while (header >> pin) pins.push_back(pin);
+        try {
+            addCell(name, pins, line.substr(colon + 1));
+        } catch (const ParsingException& e) {
+            throw ParsingException(source + ":" + std::to_string(lineNumber) + ": " + e.what());
+        }
+    }
+}
+
+void CellLibrary::addCell(const std::string& name, const std::vector<std::string>& pins, const std::string& function) {
+    if (pins.size() > static_cast<size_t>(kMaxPins)) {
+        throw ParsingException("Cell " + name + " has more than " + std::to_string(kMaxPins) + " input pins");
+    }
+    CellRule rule;
+    rule.name = toLower(name);
+    for (const auto& p : pins) rule.pins.push_back(toLower(p));
+
+    const int n = static_cast<int>(rule.pins.size());
+    const uint32_t minterms = 1u << n;
+    TruthTable on = FunctionParser(function, rule.pins).truthTable();
+    TruthTable off;
+    for (uint32_t m = 0; m < minterms; ++m) off[m] = !on[m];
+    rule.onSet = primeImplicants(on, n);
+    rule.offSet = primeImplicants(off, n);
+
+    for (int i = 0; i < n; ++i) {
+        TruthTable difference;
+        for (uint32_t m = 0; m < minterms; ++m) difference[m] = on[m] != on[m ^ (1u << i)];
+        rule.sensitize.push_back(primeImplicants(difference, n));
+    }
+
+    auto it = index.find(rule.name);
+    if (it != index.end()) {
+        rules[it->second] = std::move(rule);
+    } else {
+        index.emplace(rule.name, static_cast<int>(rules.size()));
+        rules.push_back(std::move(rule));
+    }
+}
+
+int CellLibrary::find(const std::string& name) const {
+    auto it = index.find(toLower(name));
+    return it == index.end() ? -1 : it->second;
+}
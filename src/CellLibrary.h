@@ -0,0 +1,64 @@
+#ifndef CELL_LIBRARY_H
+#define CELL_LIBRARY_H
+
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// A product term over the inputs of a cell: input p takes part if bit p of
+// `care` is set, and must then be at the value of bit p of `value`.
+struct CellCube {
+    uint32_t care;
+    uint32_t value;
+};
+
+// Exact SCOAP rules of a single-output cell, derived from its Boolean function.
+//
+// To set the output to v it suffices to satisfy the cheapest prime implicant
+// of the on-set (v = 1) or off-set (v = 0). To observe input i the other
+// inputs must satisfy the cheapest prime implicant of the Boolean difference
+// df/dx_i. Costs are sums of the controllabilities of the cube literals.
+struct CellRule {
+    std::string name;
+    std::vector<std::string> pins; // Input pins, in connection order after the output.
+    std::vector<CellCube> onSet;
+    std::vector<CellCube> offSet;
+    std::vector<std::vector<CellCube>> sensitize; // One cover per input pin.
+};
+
+// A collection of cell rules, looked up by cell type name (case-insensitive).
+//
+// Cells are described one per line as
+//     cell <name> <input pins...> : <function>
+// where the function uses the input pin names, the constants 0 and 1, and the
+// operators ! (or ~), &, ^ and |, in decreasing order of precedence, with
+// parentheses. Instances connect the output first, then the inputs in pin
+// order, like the Verilog primitives. '#' starts a comment.
+class CellLibrary {
+public:
+    // Maximum number of input pins of a cell.
+    static constexpr int kMaxPins = 8;
+
+    // The library of common cells (mux2, and-or-invert, or-and-invert, tie cells).
+    static CellLibrary builtin();
+
+    // Adds the cells from a description file. Throws ParsingException on errors.
+    void loadFromFile(const std::string& filename);
+    void load(std::istream& in, const std::string& source);
+
+    // Adds or replaces a cell. Throws ParsingException if the function is invalid.
+    void addCell(const std::string& name, const std::vector<std::string>& pins, const std::string& function);
+
+    // Returns the id of the named cell, or -1.
+    int find(const std::string& name) const;
+    const CellRule& rule(int id) const { return rules[id]; }
+    size_t size() const { return rules.size(); }
+
+private:
+    std::vector<CellRule> rules;
+    std::unordered_map<std::string, int> index; // Lower-case name -> rule id
+};
+
+#endif // CELL_LIBRARY_H
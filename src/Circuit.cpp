@@ -1,584 +1,1837 @@
-#include "Circuit.h"
-#include "VerilogParser.h" // For parsing functionality
-#include <iostream>
-#include <fstream>
-#include <numeric>
-#include <algorithm>
-#include <queue>
-#include <random>
-#include <cmath>
-
-// Main method to orchestrate the entire SCOAP calculation process.
-void Circuit::calculateAllScoapMetrics() {
-    std::cout << "Calculating net levels..." << std::endl;
-    calculateNetLevels();
-
-    std::cout << "Calculating combinational controllability (CC)..." << std::endl;
-    calculateCombinationalControllability();
-
-    std::cout << "Calculating sequential controllability (SC)..." << std::endl;
-    calculateSequentialControllability();
-
-    std::cout << "Calculating combinational observability (CO)..." << std::endl;
-    // Initialize POs for observability calculation
-    for (const auto& poName : primaryOutputs) {
-        if (nets.count(poName)) {
-            nets.at(poName).co = 0;
-        }
-    }
-    calculateCombinationalObservability();
-
-    std::cout << "Calculating sequential observability (SO)..." << std::endl;
-    // Initialize POs for sequential observability
-    for (const auto& poName : primaryOutputs) {
-        if (nets.count(poName)) {
-            nets.at(poName).so = 0; // PO is observable in 0 time steps
-        }
-    }
-    calculateSequentialObservability();
-    
-    std::cout << "SCOAP calculations complete." << std::endl;
-}
-
-// Loads the circuit structure from a Verilog file.
-bool Circuit::loadFromVerilog(const std::string& filename) {
-    std::cout << "Parsing Verilog file: " << filename << "..." << std::endl;
-    try {
-        VerilogParser::parseFile(filename, gates, flipflops, nets, primaryInputs, primaryOutputs);
-        std::cout << "Parsing complete. Found " << gates.size() << " gates and " << flipflops.size() << " flip-flops." << std::endl;
-        return true;
-    } catch (const std::exception& e) {
-        std::cerr << "Error during parsing: " << e.what() << std::endl;
-        return false;
-    }
-}
-
-// Assigns a topological level to each net. PIs and FF outputs are level 0.
-void Circuit::calculateNetLevels() {
-    std::queue<std::string> bfsQueue;
-    std::map<std::string, int> gateInputCounts;
-
-    for (const auto& gate : gates) {
-        gateInputCounts[gate.name] = gate.inputs.size();
-    }
-
-    for (auto& pair : nets) {
-        Net& net = pair.second;
-        if (net.type == "P" || net.drivenByFlipFlop) {
-            net.level = 0;
-            bfsQueue.push(net.name);
-        }
-    }
-
-    while (!bfsQueue.empty()) {
-        std::string currentNetName = bfsQueue.front();
-        bfsQueue.pop();
-
-        for (const auto& gateName : nets.at(currentNetName).loads) {
-            if (--gateInputCounts[gateName] == 0) {
-                Gate g = findGateByName(gateName);
-                if (g.name.empty()) continue;
-
-                int maxInLevel = 0;
-                for (const auto& inpName : g.inputs) {
-                    if(nets.count(inpName)) {
-                        maxInLevel = std::max(maxInLevel, nets.at(inpName).level);
-                    }
-                }
-                if(nets.count(g.output)) {
-                    nets.at(g.output).level = maxInLevel + 1;
-                    bfsQueue.push(g.output);
-                }
-            }
-        }
-    }
-}
-
-// Calculates CC0 and CC1 for all nets.
-void Circuit::calculateCombinationalControllability() {
-    for (auto& pair : nets) {
-        Net& net = pair.second;
-        if (net.type == "P" || net.drivenByFlipFlop) {
-            net.cc0 = 1;
-            net.cc1 = 1;
-        }
-    }
-
-    std::vector<Gate> topoGates = gates;
-    std::sort(topoGates.begin(), topoGates.end(), [&](const Gate& a, const Gate& b) {
-        if (!nets.count(a.output) || !nets.count(b.output)) return false;
-        return nets.at(a.output).level < nets.at(b.output).level;
-    });
-
-    for (const auto& g : topoGates) {
-        if (!nets.count(g.output)) continue;
-        
-        std::vector<int> inCC0, inCC1;
-        for (const auto& inp : g.inputs) {
-            if(nets.count(inp)) {
-                inCC0.push_back(nets.at(inp).cc0);
-                inCC1.push_back(nets.at(inp).cc1);
-            }
-        }
-
-        if (inCC0.empty() || inCC1.empty()) continue; // Skip gates with no connected inputs
-
-        int& out0 = nets.at(g.output).cc0;
-        int& out1 = nets.at(g.output).cc1;
-
-        if (g.type == "and") {
-            out0 = 1 + *std::min_element(inCC0.begin(), inCC0.end());
-            out1 = 1 + std::accumulate(inCC1.begin(), inCC1.end(), 0);
-        } else if (g.type == "nand") {
-            out0 = 1 + std::accumulate(inCC1.begin(), inCC1.end(), 0);
-            out1 = 1 + *std::min_element(inCC0.begin(), inCC0.end());
-        } else if (g.type == "or") {
-            out0 = 1 + std::accumulate(inCC0.begin(), inCC0.end(), 0);
-            out1 = 1 + *std::min_element(inCC1.begin(), inCC1.end());
-        } else if (g.type == "nor") {
-            out1 = 1 + std::accumulate(inCC0.begin(), inCC0.end(), 0);
-            out0 = 1 + *std::min_element(inCC1.begin(), inCC1.end());
-        } else if (g.type == "xor") {
-            out0 = 1 + std::min(inCC0[0] + inCC0[1], inCC1[0] + inCC1[1]);
-            out1 = 1 + std::min(inCC0[0] + inCC1[1], inCC1[0] + inCC0[1]);
-        } else if (g.type == "xnor") {
-            out1 = 1 + std::min(inCC0[0] + inCC0[1], inCC1[0] + inCC1[1]);
-            out0 = 1 + std::min(inCC0[0] + inCC1[1], inCC1[0] + inCC0[1]);
-        } else if (g.type == "not") {
-            out0 = 1 + inCC1[0];
-            out1 = 1 + inCC0[0];
-        } else if (g.type == "buf") {
-            out0 = 1 + inCC0[0];
-            out1 = 1 + inCC1[0];
-        }
-    }
-}
-
-// Calculates SC0 and SC1 for all nets using an iterative approach.
-void Circuit::calculateSequentialControllability() {
-    // Initialize SC for PIs
-    for (auto& pair : nets) {
-        if (pair.second.type == "P") {
-            pair.second.sc0 = 0;
-            pair.second.sc1 = 0;
-        }
-    }
-
-    bool changed;
-    do {
-        changed = false;
-
-        // Propagate through combinational logic
-        std::vector<Gate> topoGates = gates;
-        std::sort(topoGates.begin(), topoGates.end(), [&](const Gate& a, const Gate& b) {
-            if (!nets.count(a.output) || !nets.count(b.output)) return false;
-            return nets.at(a.output).level < nets.at(b.output).level;
-        });
-
-        for (const auto& g : topoGates) {
-             if (!nets.count(g.output)) continue;
-            
-            std::vector<int> inSC0, inSC1;
-            for (const auto& inp : g.inputs) {
-                if(nets.count(inp)) {
-                    inSC0.push_back(nets.at(inp).sc0);
-                    inSC1.push_back(nets.at(inp).sc1);
-                }
-            }
-            if (inSC0.empty() || inSC1.empty()) continue;
-
-            int new_sc0 = INF, new_sc1 = INF;
-            if (g.type == "and") {
-                new_sc0 = *std::min_element(inSC0.begin(), inSC0.end());
-                new_sc1 = std::accumulate(inSC1.begin(), inSC1.end(), 0);
-            } else if (g.type == "nand") {
-                new_sc0 = std::accumulate(inSC1.begin(), inSC1.end(), 0);
-                new_sc1 = *std::min_element(inSC0.begin(), inSC0.end());
-            } else if (g.type == "or") {
-                new_sc0 = std::accumulate(inSC0.begin(), inSC0.end(), 0);
-                new_sc1 = *std::min_element(inSC1.begin(), inSC1.end());
-            } else if (g.type == "nor") {
-                new_sc1 = std::accumulate(inSC0.begin(), inSC0.end(), 0);
-                new_sc0 = *std::min_element(inSC1.begin(), inSC1.end());
-            } else if (g.type == "not") {
-                new_sc0 = inSC1[0];
-                new_sc1 = inSC0[0];
-            } else if (g.type == "buf") {
-                new_sc0 = inSC0[0];
-                new_sc1 = inSC1[0];
-            }
-            
-            if (new_sc0 < nets.at(g.output).sc0) {
-                nets.at(g.output).sc0 = new_sc0;
-                changed = true;
-            }
-            if (new_sc1 < nets.at(g.output).sc1) {
-                nets.at(g.output).sc1 = new_sc1;
-                changed = true;
-            }
-        }
-        
-        // Propagate through flip-flops
-        for (const auto& ff : flipflops) {
-            if (!nets.count(ff.q) || !nets.count(ff.d) || !nets.count(ff.clk)) continue;
-
-            if (ff.type == "dff") {
-                int d_sc0 = nets.at(ff.d).sc0;
-                int d_sc1 = nets.at(ff.d).sc1;
-                int clk_sc0 = nets.at(ff.clk).sc0;
-                int clk_sc1 = nets.at(ff.clk).sc1;
-
-                int new_q_sc0 = d_sc0 + clk_sc0 + clk_sc1 + 1;
-                int new_q_sc1 = d_sc1 + clk_sc0 + clk_sc1 + 1;
-                
-                if (new_q_sc0 < nets.at(ff.q).sc0) {
-                    nets.at(ff.q).sc0 = new_q_sc0;
-                    changed = true;
-                }
-                if (new_q_sc1 < nets.at(ff.q).sc1) {
-                    nets.at(ff.q).sc1 = new_q_sc1;
-                    changed = true;
-                }
-            }
-            // Add logic for other FF types (T, JK, SR) if needed
-        }
-
-    } while (changed);
-}
-
-// Calculates CO for all nets.
-void Circuit::calculateCombinationalObservability() {
-    std::vector<Gate> revGates = gates;
-    std::sort(revGates.begin(), revGates.end(), [&](const Gate& a, const Gate& b) {
-        if (!nets.count(a.output) || !nets.count(b.output)) return false;
-        return nets.at(a.output).level > nets.at(b.output).level;
-    });
-
-    for (const auto& g : revGates) {
-        if (!nets.count(g.output)) continue;
-        int coY = nets.at(g.output).co;
-        if (coY == INF) continue;
-
-        for (size_t i = 0; i < g.inputs.size(); ++i) {
-            const std::string& inputNetName = g.inputs[i];
-            if (!nets.count(inputNetName)) continue;
-
-            int newCO = INF;
-            if (g.type == "and" || g.type == "nand") {
-                int sumCC1 = 0;
-                for (size_t j = 0; j < g.inputs.size(); ++j) {
-                    if (i == j) continue;
-                    sumCC1 += nets.at(g.inputs[j]).cc1;
-                }
-                newCO = coY + sumCC1 + 1;
-            } else if (g.type == "or" || g.type == "nor") {
-                int sumCC0 = 0;
-                for (size_t j = 0; j < g.inputs.size(); ++j) {
-                    if (i == j) continue;
-                    sumCC0 += nets.at(g.inputs[j]).cc0;
-                }
-                newCO = coY + sumCC0 + 1;
-            } else if (g.type == "not" || g.type == "buf") {
-                newCO = coY + 1;
-            } else if (g.type == "xor" || g.type == "xnor") {
-                 int other_idx = (i == 0) ? 1 : 0;
-                 if (g.inputs.size() == 2) {
-                    int other_cc0 = nets.at(g.inputs[other_idx]).cc0;
-                    int other_cc1 = nets.at(g.inputs[other_idx]).cc1;
-                    newCO = coY + std::min(other_cc0, other_cc1) + 1;
-                 }
-            }
-
-            if (newCO < nets.at(inputNetName).co) {
-                nets.at(inputNetName).co = newCO;
-            }
-        }
-    }
-}
-
-// Calculates SO for all nets.
-void Circuit::calculateSequentialObservability() {
-    // This is a complex calculation that typically requires iteration, similar to SC.
-    // For this refactoring, we will propagate the SO from the FF outputs backward.
-    bool changed;
-    do {
-        changed = false;
-        // Propagate SO from FF inputs to their Q outputs
-        for (const auto& ff : flipflops) {
-            if (!nets.count(ff.q) || !nets.count(ff.d) || !nets.count(ff.clk)) continue;
-
-            int q_so = nets.at(ff.q).so;
-            if (q_so == INF) continue;
-
-            if (ff.type == "dff") {
-                int clk_sc0 = nets.at(ff.clk).sc0;
-                int clk_sc1 = nets.at(ff.clk).sc1;
-                
-                int new_d_so = q_so + clk_sc0 + clk_sc1 + 1;
-
-                if (new_d_so < nets.at(ff.d).so) {
-                    nets.at(ff.d).so = new_d_so;
-                    changed = true;
-                }
-            }
-            // Add logic for other FF types if needed
-        }
-
-        // Propagate SO backward through combinational logic
-        std::vector<Gate> revGates = gates;
-        std::sort(revGates.begin(), revGates.end(), [&](const Gate& a, const Gate& b) {
-            if (!nets.count(a.output) || !nets.count(b.output)) return false;
-            return nets.at(a.output).level > nets.at(b.output).level;
-        });
-
-        for (const auto& g : revGates) {
-            if (!nets.count(g.output)) continue;
-            int soY = nets.at(g.output).so;
-            if (soY == INF) continue;
-
-            for (size_t i = 0; i < g.inputs.size(); ++i) {
-                const std::string& inputNetName = g.inputs[i];
-                if (!nets.count(inputNetName)) continue;
-                
-                int newSO = INF;
-                if (g.type == "and" || g.type == "nand") {
-                    int sumSC1 = 0;
-                    for (size_t j = 0; j < g.inputs.size(); ++j) {
-                        if (i == j) continue;
-                        sumSC1 += nets.at(g.inputs[j]).sc1;
-                    }
-                    newSO = soY + sumSC1;
-                } else if (g.type == "or" || g.type == "nor") {
-                     int sumSC0 = 0;
-                    for (size_t j = 0; j < g.inputs.size(); ++j) {
-                        if (i == j) continue;
-                        sumSC0 += nets.at(g.inputs[j]).sc0;
-                    }
-                    newSO = soY + sumSC0;
-                } else if (g.type == "not" || g.type == "buf") {
-                    newSO = soY;
-                }
-                
-                if (newSO < nets.at(inputNetName).so) {
-                    nets.at(inputNetName).so = newSO;
-                    changed = true;
-                }
-            }
-        }
-    } while(changed);
-}
-
-// Finds a gate by its instance name. Returns a dummy gate if not found.
-Gate Circuit::findGateByName(const std::string& name) const {
-    for (const auto& gate : gates) {
-        if (gate.name == name) return gate;
-    }
-    return Gate(); // Return an empty gate
-}
-
-// Generates and prints debug information to files.
-void Circuit::printDebugInfo(const std::string& outputDir) const {
-    std::cout << "Writing debug files to " << outputDir << "..." << std::endl;
-    printGatesToFile(outputDir + "/gates_info.txt");
-    printNetsToFile(outputDir + "/nets_info.txt");
-    detectFeedbackLoops();
-}
-
-// Detects combinational feedback loops.
-int Circuit::detectFeedbackLoops() const {
-    int feedbackCount = 0;
-    for (const auto& g : gates) {
-        if (!nets.count(g.output)) continue;
-        int outLevel = nets.at(g.output).level;
-        if (outLevel == -1) continue;
-
-        for (const auto& inp : g.inputs) {
-            if (nets.count(inp) && nets.at(inp).level > outLevel) {
-                std::cout << "Feedback detected: Gate " << g.name
-                          << ", Input " << inp << " (level " << nets.at(inp).level
-                          << ") -> Output " << g.output << " (level " << outLevel << ")" << std::endl;
-                feedbackCount++;
-                break;
-            }
-        }
-    }
-    if (feedbackCount > 0) {
-        std::cout << "Total feedback loops detected: " << feedbackCount << std::endl;
-    } else {
-        std::cout << "No combinational feedback loops detected." << std::endl;
-    }
-    return feedbackCount;
-}
-
-// Writes detailed gate information to a text file.
-void Circuit::printGatesToFile(const std::string& filepath) const {
-    std::ofstream ofs(filepath);
-    if (!ofs) {
-        std::cerr << "Error opening file: " << filepath << std::endl;
-        return;
-    }
-    ofs << "--- Gates Information ---\n\n";
-    for (const auto& g : gates) {
-        ofs << "Gate Name: " << g.name << "\n";
-        ofs << "Type: " << g.type << "\n";
-        if (nets.count(g.output)) {
-            ofs << "Level: " << nets.at(g.output).level << "\n";
-        }
-        ofs << "Output: " << g.output << "\n";
-        ofs << "Inputs: ";
-        for (const auto& inp : g.inputs) ofs << inp << " ";
-        ofs << "\n\n";
-    }
-    std::cout << "Wrote gate info to " << filepath << std::endl;
-}
-
-// Writes detailed net information to a text file.
-void Circuit::printNetsToFile(const std::string& filepath) const {
-    std::ofstream ofs(filepath);
-    if (!ofs) {
-        std::cerr << "Error opening file: " << filepath << std::endl;
-        return;
-    }
-    ofs << "--- Nets Information ---\n\n";
-    for (const auto& pair : nets) {
-        const Net& net = pair.second;
-        ofs << "Net Name: " << net.name << "\n";
-        ofs << "Type: " << (net.type.empty() ? "Wire" : net.type) << "\n";
-        ofs << "Level: " << net.level << "\n";
-        ofs << "Drivers: ";
-        if (net.drivenByFlipFlop) ofs << "(flipflop) ";
-        for (const auto& d : net.drivers) ofs << d << " ";
-        ofs << "\nLoads: ";
-        for (const auto& l : net.loads) ofs << l << " ";
-        ofs << "\nSCOAP Values:\n";
-        ofs << "  CC0: " << (net.cc0 == INF ? -1 : net.cc0) << ", CC1: " << (net.cc1 == INF ? -1 : net.cc1) << "\n";
-        ofs << "  SC0: " << (net.sc0 == INF ? -1 : net.sc0) << ", SC1: " << (net.sc1 == INF ? -1 : net.sc1) << "\n";
-        ofs << "  CO: " << (net.co == INF ? -1 : net.co) << ", SO: " << (net.so == INF ? -1 : net.so) << "\n\n";
-    }
-    std::cout << "Wrote net info to " << filepath << std::endl;
-}
-
-// Writes SCOAP results to a CSV file
-void Circuit::writeScoapResultsToCSV(const std::string& filepath) const {
-    std::ofstream ofs(filepath);
-    if (!ofs) {
-        std::cerr << "Error opening file: " << filepath << std::endl;
-        return;
-    }
-    ofs << "Net,CC0,CC1,SC0,SC1,CO,SO\n";
-    for (const auto& pair : nets) {
-        const Net& net = pair.second;
-        ofs << net.name << ","
-            << (net.cc0 == INF ? -1 : net.cc0) << ","
-            << (net.cc1 == INF ? -1 : net.cc1) << ","
-            << (net.sc0 == INF ? -1 : net.sc0) << ","
-            << (net.sc1 == INF ? -1 : net.sc1) << ","
-            << (net.co == INF ? -1 : net.co) << ","
-            << (net.so == INF ? -1 : net.so) << "\n";
-    }
-    std::cout << "Wrote SCOAP results to " << filepath << std::endl;
-}
-
-// Helper: Euclidean distance between two points in 6D
-static double scoap_distance(const std::vector<int>& a, const std::vector<int>& b) {
-    double sum = 0.0;
-    for (size_t i = 0; i < a.size(); ++i) {
-        double diff = static_cast<double>(a[i]) - static_cast<double>(b[i]);
-        sum += diff * diff;
-    }
-    return std::sqrt(sum);
-}
-
-// KMeans clustering on SCOAP metrics (CC0, CC1, SC0, SC1, CO, SO)
-void Circuit::runKMeansOnScoap(const std::string& outputFile, int k) const {
-    // Gather feature vectors (skip nets with -1/INF values)
-    std::vector<std::string> net_names;
-    std::vector<std::vector<int>> features;
-    for (const auto& pair : nets) {
-        const Net& net = pair.second;
-        if (net.cc0 == INF || net.cc1 == INF || net.sc0 == INF || net.sc1 == INF || net.co == INF || net.so == INF)
-            continue;
-        features.push_back({net.cc0, net.cc1, net.sc0, net.sc1, net.co, net.so});
-        net_names.push_back(net.name);
-    }
-    if (features.size() < static_cast<size_t>(k)) {
-        std::cerr << "Not enough nets for KMeans clustering." << std::endl;
-        return;
-    }
-    // KMeans++ initialization
-    std::vector<std::vector<int>> centroids;
-    std::vector<int> chosen;
-    std::mt19937 rng(42);
-    std::uniform_int_distribution<size_t> uni(0, features.size() - 1);
-    centroids.push_back(features[uni(rng)]);
-    for (int c = 1; c < k; ++c) {
-        std::vector<double> dists(features.size(), 1e9);
-        for (size_t i = 0; i < features.size(); ++i) {
-            for (const auto& centroid : centroids) {
-                double d = scoap_distance(features[i], centroid);
-                if (d < dists[i]) dists[i] = d;
-            }
-        }
-        double sum = 0.0;
-        for (double d : dists) sum += d;
-        std::uniform_real_distribution<double> dist(0, sum);
-        double r = dist(rng);
-        double acc = 0.0;
-        size_t next = 0;
-        for (size_t i = 0; i < dists.size(); ++i) {
-            acc += dists[i];
-            if (acc >= r) { next = i; break; }
-        }
-        centroids.push_back(features[next]);
-    }
-    // KMeans iterations
-    std::vector<int> assignments(features.size(), -1);
-    for (int iter = 0; iter < 100; ++iter) {
-        // Assignment step
-        bool changed = false;
-        for (size_t i = 0; i < features.size(); ++i) {
-            double best_dist = 1e9;
-            int best_c = -1;
-            for (int c = 0; c < k; ++c) {
-                double d = scoap_distance(features[i], centroids[c]);
-                if (d < best_dist) {
-                    best_dist = d;
-                    best_c = c;
-                }
-            }
-            if (assignments[i] != best_c) {
-                assignments[i] = best_c;
-                changed = true;
-            }
-        }
-        // Update step
-        std::vector<std::vector<double>> new_centroids(k, std::vector<double>(6, 0.0));
-        std::vector<int> counts(k, 0);
-        for (size_t i = 0; i < features.size(); ++i) {
-            int c = assignments[i];
-            for (int j = 0; j < 6; ++j) new_centroids[c][j] += features[i][j];
-            counts[c]++;
-        }
-        for (int c = 0; c < k; ++c) {
-            if (counts[c] == 0) continue;
-            for (int j = 0; j < 6; ++j) new_centroids[c][j] /= counts[c];
-        }
-        for (int c = 0; c < k; ++c) {
-            for (int j = 0; j < 6; ++j) centroids[c][j] = static_cast<int>(std::round(new_centroids[c][j]));
-        }
-        if (!changed) break;
-    }
-    // Write results
-    std::ofstream ofs(outputFile);
-    if (!ofs) {
-        std::cerr << "Error opening file: " << outputFile << std::endl;
-        return;
-    }
-    ofs << "Net,Cluster,CC0,CC1,SC0,SC1,CO,SO\n";
-    for (size_t i = 0; i < net_names.size(); ++i) {
-        ofs << net_names[i] << "," << assignments[i];
-        for (int v : features[i]) ofs << "," << v;
-        ofs << "\n";
-    }
-    std::cout << "Wrote KMeans clustering results to " << outputFile << std::endl;
-}
+#include "Circuit.h"
+#include "VerilogParser.h" // For parsing functionality
+#include "CompactNetlist.h"
+#include "ScoapEngine.h"
+#include "PartitionedEngine.h"
+#include "DistributedEngine.h"
+#include "ColumnarWriter.h"
+#include "TrojanFeatures.h"
+#include "GateGraph.h"
+#include "MetricStats.h"
+#include "TaskGraph.h"
+#include "ThreadPool.h"
+#include <iostream>
+#include <fstream>
+#include <numeric>
+#include <algorithm>
+#include <unordered_map>
+#include <random>
+#include <cmath>
+#include <chrono>
+#include <sstream>
+#include <filesystem>
+#include <atomic>
+#include <string_view>
+#include <cstdlib>
+#include <cstdint>
+
+// Main method to orchestrate the entire SCOAP calculation process.
+void Circuit::calculateAllScoapMetrics() {
+    std::cout << "Calculating net levels..." << std::endl;
+    const GateGraph graph = gateGraph();
+    calculateNetLevels(graph);
+    if (!combinationalLoops.empty()) {
+        std::cout << "Found " << combinationalLoops.size()
+                  << " combinational loop(s); evaluating each to a local fixpoint." << std::endl;
+    }
+
+    std::cout << "Identifying clock and reset networks..." << std::endl;
+    identifyClockNetworks(graph);
+
+    static int Net::*const metrics[] = {&Net::cc0, &Net::cc1, &Net::sc0, &Net::sc1, &Net::co, &Net::so};
+    CacheKey key;
+    converged = true;
+    if (!cacheDirectory.empty() || !checkpointFile.empty()) key = cacheKey();
+    if (!cacheDirectory.empty()) {
+        std::vector<int32_t> cached;
+        if (explainNets.empty() && ResultCache(cacheDirectory).load(key, nets.size(), cached)) {
+            size_t i = 0;
+            for (auto& pair : nets) {
+                for (int Net::*metric : metrics) pair.second.*metric = cached[i++];
+            }
+            std::cout << "Loaded SCOAP results from cache (" << key.hex() << ")." << std::endl;
+            return;
+        }
+    }
+
+    CompactNetlist netlist = CompactNetlist::build(gates, flipflops, nets, primaryOutputs, &cellLibrary);
+    if (scanAll || !scanFlipFlops.empty()) {
+        const size_t before = netlist.numFlipFlops();
+        netlist.applyScan(scanMask(scanAll, scanFlipFlops));
+        std::cout << "Scan mode: " << before - netlist.numFlipFlops() << " of " << before
+                  << " flip-flops configured as pseudo primary inputs/outputs." << std::endl;
+    }
+    netlist.reorderForLocality();
+    if (memoryBudget > 0) {
+        if (metricBits == 16) {
+            runPartitionedEngine<uint16_t>(netlist);
+        } else {
+            runPartitionedEngine<uint32_t>(netlist);
+        }
+    } else if (workers > 1) {
+        if (metricBits == 16) {
+            runDistributedEngine<uint16_t>(netlist);
+        } else {
+            runDistributedEngine<uint32_t>(netlist);
+        }
+    } else if (metricBits == 16) {
+        runScoapEngine<uint16_t>(netlist, key);
+    } else {
+        runScoapEngine<uint32_t>(netlist, key);
+    }
+
+    // Partial results are not cached.
+    if (!cacheDirectory.empty() && converged) {
+        std::vector<int32_t> results;
+        results.reserve(nets.size() * 6);
+        for (const auto& pair : nets) {
+            for (int Net::*metric : metrics) results.push_back(pair.second.*metric);
+        }
+        if (!ResultCache(cacheDirectory).store(key, results)) {
+            std::cerr << "Warning: could not write the result cache in " << cacheDirectory << std::endl;
+        }
+    }
+    std::cout << "SCOAP calculations complete." << std::endl;
+}
+
+// Key of the result cache: the tool version, the options that change the
+// metrics (metric width, scan cells, cell rules) and the netlist structure,
+// independent of declaration and instance order. Gate instance names do not
+// affect the metrics and are left out, as are flip-flop names unless scan
+// cells are chosen by name. Inputs of the symmetric primitives are sorted.
+CacheKey Circuit::cacheKey() const {
+    StructuralHasher h;
+    h.field("version").field(ResultCache::ToolVersion).endRecord();
+    h.field("bits").field(static_cast<uint64_t>(metricBits)).field(scanAll).endRecord();
+    for (const auto& name : scanFlipFlops) h.field("scan").field(name).endRecord();
+    for (size_t id = 0; id < cellLibrary.size(); ++id) {
+        const CellRule& rule = cellLibrary.rule(static_cast<int>(id));
+        h.field("cell").field(rule.name);
+        for (const auto& pin : rule.pins) h.field(pin);
+        for (const auto* cover : {&rule.onSet, &rule.offSet}) {
+            h.field(cover->size());
+            for (const CellCube& c : *cover) h.field(c.care).field(c.value);
+        }
+        for (const auto& cover : rule.sensitize) {
+            h.field(cover.size());
+            for (const CellCube& c : cover) h.field(c.care).field(c.value);
+        }
+        h.endRecord();
+    }
+    for (const auto& pair : nets) h.field("net").field(pair.first).field(pair.second.type).endRecord();
+    std::vector<const NetName*> inputs;
+    for (const auto& gate : gates) {
+        inputs.clear();
+        for (const auto& inp : gate.inputs) inputs.push_back(&inp);
+        if (gate.kind != GateType::Unknown && gate.kind != GateType::Cell) {
+            std::sort(inputs.begin(), inputs.end(), [](const NetName* a, const NetName* b) { return *a < *b; });
+        }
+        h.field("gate").field(gate.type).field(gate.output).field(inputs.size());
+        for (const NetName* inp : inputs) h.field(*inp);
+        h.endRecord();
+    }
+    for (const auto& ff : flipflops) {
+        h.field("ff").field(ff.type).field(scanFlipFlops.empty() ? std::string() : ff.name);
+        for (const NetName* pin : {&ff.clk, &ff.q, &ff.d, &ff.t, &ff.j, &ff.k, &ff.s, &ff.r, &ff.en, &ff.set, &ff.rst}) h.field(*pin);
+        h.endRecord();
+    }
+    return h.key();
+}
+
+// Runs all four SCOAP passes with T-wide metric storage and copies the
+// results back into the net map. `key` identifies the analysis in the
+// checkpoint.
+template <typename T>
+void Circuit::runScoapEngine(const CompactNetlist& netlist, const CacheKey& key) {
+    using M = Metric<T>;
+    ScoapEngine<T> engine(netlist);
+    engine.recordTrace = !explainNets.empty();
+    engine.deadline = deadline;
+
+    // The checkpoint holds SC0, SC1 and SO in net map order.
+    const Checkpoint checkpoint(checkpointFile);
+    auto saveCheckpoint = [&] {
+        std::vector<int32_t> values(3 * netlist.numNets());
+        for (size_t id = 0; id < netlist.numNets(); ++id) {
+            int32_t* v = &values[3 * static_cast<size_t>(netlist.netPosition[id])];
+            v[0] = M::toInt(engine.sc0[id]);
+            v[1] = M::toInt(engine.sc1[id]);
+            v[2] = M::toInt(engine.so[id]);
+        }
+        if (!checkpoint.store(key, values)) {
+            std::cerr << "Warning: could not write the checkpoint " << checkpointFile << std::endl;
+        }
+    };
+    auto lastSave = std::chrono::steady_clock::now();
+    if (!checkpointFile.empty()) {
+        std::vector<int32_t> values;
+        if (checkpoint.load(key, netlist.numNets(), values)) {
+            for (size_t id = 0; id < netlist.numNets(); ++id) {
+                const int32_t* v = &values[3 * static_cast<size_t>(netlist.netPosition[id])];
+                engine.sc0[id] = M::fromInt(v[0]);
+                engine.sc1[id] = M::fromInt(v[1]);
+                engine.so[id] = M::fromInt(v[2]);
+            }
+            std::cout << "Resuming SC and SO from the checkpoint " << checkpointFile << "." << std::endl;
+        }
+        engine.onRound = [&] {
+            const auto now = std::chrono::steady_clock::now();
+            if (now - lastSave < std::chrono::minutes(1)) return;
+            saveCheckpoint();
+            lastSave = now;
+        };
+    }
+
+    // SC and CO both only read CC, so they run concurrently; SO needs both.
+    // With a time budget, CO runs before SC, so that CC and CO are complete
+    // before the iterated passes start.
+    const bool timeBudget = deadline != std::chrono::steady_clock::time_point::max();
+    bool scConverged = true, soConverged = true;
+    TaskGraph passes;
+    const auto cc = passes.add("CC", [&] {
+        std::cout << "Calculating combinational controllability (CC)..." << std::endl;
+        engine.computeCombinationalControllability();
+        return true;
+    });
+    const auto co = passes.add("CO", [&] {
+        std::cout << "Calculating combinational observability (CO)..." << std::endl;
+        engine.computeCombinationalObservability();
+        return true;
+    }, {cc});
+    const auto sc = passes.add("SC", [&] {
+        std::cout << "Calculating sequential controllability (SC)..." << std::endl;
+        scConverged = engine.computeSequentialControllability();
+        return true;
+    }, timeBudget ? std::vector<TaskGraph::Task>{cc, co} : std::vector<TaskGraph::Task>{cc});
+    passes.add("SO", [&] {
+        std::cout << "Calculating sequential observability (SO)..." << std::endl;
+        soConverged = engine.computeSequentialObservability();
+        return true;
+    }, {sc, co});
+    passes.run(pool(), 2);
+
+    converged = scConverged && soConverged;
+    if (!converged) {
+        std::cerr << "Warning: the time budget ran out before " << (scConverged ? "SO" : "SC and SO")
+                  << " converged; the values are upper bounds of the final ones." << std::endl;
+    }
+    if (!checkpointFile.empty()) {
+        saveCheckpoint();
+        std::cout << "Saved the progress of SC and SO to the checkpoint " << checkpointFile << "." << std::endl;
+    }
+
+    if (engine.cappedLoops > 0) {
+        std::cerr << "Warning: " << engine.cappedLoops
+                  << " combinational loop evaluation(s) stopped before reaching a fixpoint." << std::endl;
+    }
+
+    std::vector<Net*> byId = netsById(netlist);
+    for (size_t id = 0; id < byId.size(); ++id) {
+        Net& net = *byId[id];
+        net.cc0 = M::toInt(engine.cc0[id]);
+        net.cc1 = M::toInt(engine.cc1[id]);
+        net.sc0 = M::toInt(engine.sc0[id]);
+        net.sc1 = M::toInt(engine.sc1[id]);
+        net.co = M::toInt(engine.co[id]);
+        net.so = M::toInt(engine.so[id]);
+    }
+    if (engine.recordTrace) printExplanations(engine, netlist, byId);
+}
+
+// Prints the cheapest justification of CC0 and CC1 and the cheapest
+// propagation path of CO of every net given to explainNet().
+template <typename T>
+void Circuit::printExplanations(const ScoapEngine<T>& engine, const CompactNetlist& netlist, const std::vector<Net*>& byId) const {
+    using M = Metric<T>;
+    using TraceMetric = typename ScoapEngine<T>::TraceMetric;
+    static const char* metricNames[] = {"CC0", "CC1", "CO"};
+    for (const auto& name : explainNets) {
+        const NetName net(name);
+        int32_t id = -1;
+        for (size_t n = 0; n < byId.size() && id < 0; ++n) {
+            if (byId[n]->name == net) id = static_cast<int32_t>(n);
+        }
+        if (id < 0) {
+            std::cerr << "Cannot explain unknown net: " << name << std::endl;
+            continue;
+        }
+        for (TraceMetric metric : {TraceMetric::CC0, TraceMetric::CC1, TraceMetric::CO}) {
+            const auto path = engine.trace(id, metric);
+            std::cout << metricNames[static_cast<int>(metric)] << " of " << name << ":" << std::endl;
+            for (const auto& step : path) {
+                const T value = step.metric == TraceMetric::CO ? engine.co[step.net]
+                              : step.metric == TraceMetric::CC1 ? engine.cc1[step.net] : engine.cc0[step.net];
+                std::cout << "  " << byId[step.net]->name << " " << metricNames[static_cast<int>(step.metric)] << "=";
+                if (value == M::INF) std::cout << "INF"; else std::cout << M::toInt(value);
+                const uint8_t flags = netlist.netFlags[step.net];
+                if (step.by >= 0) {
+                    const Gate& g = gates[netlist.gateSource[step.by]];
+                    std::cout << (step.metric == TraceMetric::CO ? " observed through " : " set by ") << g.type << " " << g.name;
+                } else if (step.by <= -2) {
+                    std::cout << " through a clock tree " << (netlist.clockTree[-2 - step.by].inverted ? "inverter" : "buffer");
+                } else if (value == M::INF) {
+                    std::cout << (step.metric == TraceMetric::CO ? " (not observable)" : " (not controllable)");
+                } else if (step.metric == TraceMetric::CO) {
+                    std::cout << ((flags & CompactNetlist::PrimaryOutput) ? " (primary output)" : " (scan cell input)");
+                } else {
+                    std::cout << ((flags & CompactNetlist::PrimaryInput) ? " (primary input)"
+                                  : (flags & CompactNetlist::PseudoInput) ? " (scan cell output)" : " (flip-flop output)");
+                }
+                std::cout << std::endl;
+            }
+        }
+    }
+}
+
+namespace {
+
+// Heap bytes of a string beyond the object itself (short strings are stored
+// inline).
+size_t stringBytes(const std::string& s) {
+    return s.capacity() > 15 ? s.capacity() + 1 : 0;
+}
+
+size_t stringsBytes(const std::vector<std::string>& v) {
+    size_t bytes = v.capacity() * sizeof(std::string);
+    for (const auto& s : v) bytes += stringBytes(s);
+    return bytes;
+}
+
+// Net names own no heap memory; their base names are interned once.
+template <typename T>
+size_t vectorBytes(const std::vector<T>& v) {
+    return v.capacity() * sizeof(T);
+}
+
+} // namespace
+
+// An estimate of the memory held by the parsed netlist: the gates,
+// flip-flops and nets with their strings, the nodes of the net map and the
+// interned base names of the nets.
+size_t Circuit::netlistBytes() const {
+    constexpr size_t mapNode = 32; // Tree node links and color
+    size_t bytes = gates.capacity() * sizeof(Gate) + flipflops.capacity() * sizeof(FlipFlop);
+    for (const auto& gate : gates) {
+        bytes += stringBytes(gate.name) + stringBytes(gate.type) + vectorBytes(gate.inputs);
+    }
+    for (const auto& ff : flipflops) bytes += stringBytes(ff.type) + stringBytes(ff.name);
+    for (const auto& pair : nets) {
+        bytes += mapNode + sizeof(pair) + stringBytes(pair.second.type)
+               + stringsBytes(pair.second.drivers) + stringsBytes(pair.second.loads);
+    }
+    return bytes + vectorBytes(primaryInputs) + vectorBytes(primaryOutputs) + NetName::internedBytes();
+}
+
+// The nets indexed by CompactNetlist net id.
+std::vector<Net*> Circuit::netsById(const CompactNetlist& netlist) {
+    std::vector<Net*> byPosition;
+    byPosition.reserve(nets.size());
+    for (auto& pair : nets) byPosition.push_back(&pair.second);
+    std::vector<Net*> byId(netlist.numNets());
+    for (size_t id = 0; id < byId.size(); ++id) byId[id] = byPosition[netlist.netPosition[id]];
+    return byId;
+}
+
+// Runs the SCOAP passes out of core: the netlist is written to partitions
+// in a scratch directory and evaluated one partition at a time, so that the
+// engine stays within the memory budget.
+template <typename T>
+void Circuit::runPartitionedEngine(CompactNetlist& netlist) {
+    // Only the SCOAP passes run out of core; the parsed netlist and its
+    // compact form are in memory until the partitions are written.
+    const size_t resident = netlistBytes() + netlist.memoryBytes();
+    if (resident > memoryBudget) {
+        std::cerr << "Warning: the parsed netlist holds about " << resident / (1024 * 1024)
+                  << " MB in memory, more than the memory budget of " << memoryBudget / (1024 * 1024)
+                  << " MB; the budget only bounds the SCOAP passes." << std::endl;
+    }
+    const std::string dir = (std::filesystem::temp_directory_path()
+                             / ("scoap_partitions_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()))).string();
+    PartitionedEngine<T> engine(dir, memoryBudget, &cellLibrary);
+
+    std::vector<Net*> byId = netsById(netlist);
+    std::vector<int32_t> storageId;
+    engine.addNetlist(netlist, storageId);
+    netlist = CompactNetlist(); // Only the partitions are needed from here on
+    engine.finish();
+    std::cout << "Partitioned the netlist into " << engine.numPartitions() << " partition(s) with "
+              << engine.numBoundaryNets() << " boundary net(s)." << std::endl;
+    const size_t engineBytes = engine.boundaryBytes() + 2 * engine.partitionBytes();
+    if (engineBytes > memoryBudget) {
+        std::cerr << "Warning: the boundary nets and two partitions need " << engineBytes
+                  << " bytes; the memory budget of " << memoryBudget << " bytes will be exceeded." << std::endl;
+    }
+
+    std::cout << "Calculating SCOAP metrics partition by partition..." << std::endl;
+    engine.computeAll();
+    if (engine.cappedLoops > 0) {
+        std::cerr << "Warning: " << engine.cappedLoops
+                  << " combinational loop evaluation(s) stopped before reaching a fixpoint." << std::endl;
+    }
+
+    // Storage ids are in build order; map them back to the nets.
+    std::vector<Net*> byStorage(engine.numNets(), nullptr);
+    for (size_t id = 0; id < byId.size(); ++id) byStorage[storageId[id]] = byId[id];
+    using M = Metric<T>;
+    engine.forEachNet([&](int32_t n, T cc0, T cc1, T sc0, T sc1, T co, T so) {
+        Net& net = *byStorage[n];
+        net.cc0 = M::toInt(cc0);
+        net.cc1 = M::toInt(cc1);
+        net.sc0 = M::toInt(sc0);
+        net.sc1 = M::toInt(sc1);
+        net.co = M::toInt(co);
+        net.so = M::toInt(so);
+    });
+}
+
+// Runs the SCOAP passes in worker processes that each own one partition of
+// the netlist, exchanging boundary metrics through shared memory.
+template <typename T>
+void Circuit::runDistributedEngine(const CompactNetlist& netlist) {
+    DistributedEngine<T> engine(netlist, workers);
+    engine.bindToNumaNodes = bindNumaNodes;
+    std::cout << "Calculating SCOAP metrics in " << engine.numPartitions() << " worker processes ("
+              << engine.numBoundaryNets() << " boundary nets)..." << std::endl;
+    engine.computeAll();
+    std::cout << "Rounds to converge: CC " << engine.rounds[0] << ", SC " << engine.rounds[1]
+              << ", CO " << engine.rounds[2] << ", SO " << engine.rounds[3] << "." << std::endl;
+    if (engine.cappedLoops > 0) {
+        std::cerr << "Warning: " << engine.cappedLoops
+                  << " combinational loop evaluation(s) stopped before reaching a fixpoint." << std::endl;
+    }
+
+    using M = Metric<T>;
+    std::vector<Net*> byId = netsById(netlist);
+    for (size_t id = 0; id < byId.size(); ++id) {
+        Net& net = *byId[id];
+        net.cc0 = M::toInt(engine.cc0()[id]);
+        net.cc1 = M::toInt(engine.cc1()[id]);
+        net.sc0 = M::toInt(engine.sc0()[id]);
+        net.sc1 = M::toInt(engine.sc1()[id]);
+        net.co = M::toInt(engine.co()[id]);
+        net.so = M::toInt(engine.so()[id]);
+    }
+}
+
+bool Circuit::setMetricWidth(int bits) {
+    if (bits != 16 && bits != 32) return false;
+    metricBits = bits;
+    return true;
+}
+
+bool Circuit::setMemoryBudget(double megabytes) {
+    if (!(megabytes > 0)) return false;
+    memoryBudget = static_cast<size_t>(megabytes * 1024 * 1024);
+    return true;
+}
+
+bool Circuit::setTimeBudget(double seconds) {
+    if (!(seconds > 0)) return false;
+    deadline = std::chrono::steady_clock::now()
+             + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+    return true;
+}
+
+bool Circuit::setWorkers(int count, bool bindNuma) {
+    if (count < 1) return false;
+    workers = count;
+    bindNumaNodes = bindNuma;
+    return true;
+}
+
+// Loads additional cell rules.
+bool Circuit::loadCellLibrary(const std::string& filename) {
+    try {
+        cellLibrary.loadFromFile(filename);
+        std::cout << "Loaded cell library " << filename << " (" << cellLibrary.size() << " cells)." << std::endl;
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Error loading cell library: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+// Reads whitespace-separated names, one group per non-empty line. '#' starts a comment.
+static bool readNameLines(const std::string& filename, std::vector<std::vector<std::string>>& lines) {
+    std::ifstream file(filename);
+    if (!file.is_open()) return false;
+    std::string line;
+    while (getline(file, line)) {
+        std::istringstream words(line.substr(0, line.find('#')));
+        std::vector<std::string> names;
+        std::string name;
+        while (words >> name) names.push_back(name);
+        if (!names.empty()) lines.push_back(std::move(names));
+    }
+    return true;
+}
+
+bool Circuit::setScanMode(const std::string& spec) {
+    scanFlipFlops.clear();
+    scanAll = spec == "all";
+    if (scanAll) return true;
+    std::vector<std::vector<std::string>> lines;
+    if (!readNameLines(spec, lines)) {
+        std::cerr << "Error opening scan list: " << spec << std::endl;
+        return false;
+    }
+    for (const auto& names : lines) scanFlipFlops.insert(names.begin(), names.end());
+    return true;
+}
+
+// Marks the flip-flops (by index) that are scanned.
+std::vector<uint8_t> Circuit::scanMask(bool all, const std::set<std::string>& names) const {
+    std::vector<uint8_t> mask(flipflops.size(), all ? 1 : 0);
+    size_t found = 0;
+    for (size_t i = 0; i < flipflops.size() && !all; ++i) {
+        if (names.count(flipflops[i].name)) {
+            mask[i] = 1;
+            ++found;
+        }
+    }
+    if (!all && found < names.size()) {
+        std::cerr << "Warning: " << names.size() - found << " scan flip-flop name(s) not found in the design." << std::endl;
+    }
+    return mask;
+}
+
+// Loads the circuit structure from a Verilog file.
+bool Circuit::loadFromVerilog(const std::string& filename) {
+    std::cout << "Parsing Verilog file: " << filename << "..." << std::endl;
+    try {
+        VerilogParser::parseFile(filename, gates, flipflops, nets, primaryInputs, primaryOutputs);
+        std::cout << "Parsing complete. Found " << gates.size() << " gates and " << flipflops.size() << " flip-flops." << std::endl;
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Error during parsing: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+ThreadPool& Circuit::pool() const {
+    return threadPool ? *threadPool : ThreadPool::shared();
+}
+
+// The gates in net ids, which follow map order.
+GateGraph Circuit::gateGraph() const {
+    std::unordered_map<NetName, int32_t> netId;
+    netId.reserve(nets.size());
+    for (const auto& pair : nets) netId.emplace(pair.first, static_cast<int32_t>(netId.size()));
+
+    // Input and output net ids of every gate (looked up in parallel).
+    GateGraph graph;
+    graph.numNets = nets.size();
+    graph.kind.resize(gates.size());
+    graph.inputBegin.assign(gates.size() + 1, 0);
+    for (size_t g = 0; g < gates.size(); ++g) {
+        graph.kind[g] = gates[g].kind;
+        graph.inputBegin[g + 1] = graph.inputBegin[g] + static_cast<uint32_t>(gates[g].inputs.size());
+    }
+    graph.inputNet.assign(graph.inputBegin.back(), -1);
+    graph.outputNet.assign(gates.size(), -1);
+    pool().parallelChunks(gates.size(), [&](size_t first, size_t last, unsigned) {
+        for (size_t g = first; g < last; ++g) {
+            auto out = netId.find(gates[g].output);
+            if (out != netId.end()) graph.outputNet[g] = out->second;
+            uint32_t i = graph.inputBegin[g];
+            for (const auto& inp : gates[g].inputs) {
+                auto it = netId.find(inp);
+                if (it != netId.end()) graph.inputNet[i] = it->second;
+                ++i;
+            }
+        }
+    });
+    return graph;
+}
+
+// Assigns a topological level to each net and gate (see levelizeGates).
+// PIs, FF outputs and undriven nets are level 0. Each loop is recorded in
+// combinationalLoops.
+void Circuit::calculateNetLevels(const GateGraph& graph) {
+    GateLevels levels = levelizeGates(graph, pool());
+    levelBegin = std::move(levels.levelBegin);
+    levelGates = std::move(levels.levelGates);
+    netDriver = std::move(levels.netDriver);
+    combinationalLoops.assign(levels.numLoops, {});
+    for (size_t g = 0; g < gates.size(); ++g) {
+        Gate& gate = gates[g];
+        gate.level = levels.gateLevel[g];
+        gate.loop = levels.gateLoop[g];
+        if (gate.loop >= 0) combinationalLoops[gate.loop].push_back(gate.output);
+    }
+    for (auto& loopNets : combinationalLoops) {
+        std::sort(loopNets.begin(), loopNets.end());
+        loopNets.erase(std::unique(loopNets.begin(), loopNets.end()), loopNets.end());
+    }
+
+    size_t id = 0;
+    for (auto& pair : nets) pair.second.level = levels.netLevel[id++];
+}
+
+// Marks the nets that only carry clocks and asynchronous set/reset signals to
+// flip-flops (see findClockNetworks).
+void Circuit::identifyClockNetworks(const GateGraph& graph) {
+    // Flip-flop pin uses per net: control uses (clock, set, reset) and data uses.
+    std::unordered_map<NetName, int> controlUses, dataUses;
+    for (const auto& ff : flipflops) {
+        for (const NetName* pin : {&ff.clk, &ff.set, &ff.rst}) {
+            if (!pin->empty()) ++controlUses[*pin];
+        }
+        for (const NetName* pin : {&ff.d, &ff.t, &ff.j, &ff.k, &ff.s, &ff.r, &ff.en}) {
+            if (!pin->empty()) ++dataUses[*pin];
+        }
+    }
+    std::vector<uint8_t> excluded, controlUse;
+    std::vector<int> netLevel;
+    excluded.reserve(nets.size());
+    controlUse.reserve(nets.size());
+    netLevel.reserve(nets.size());
+    for (const auto& pair : nets) {
+        excluded.push_back(pair.second.type == "O" || dataUses.count(pair.first));
+        controlUse.push_back(controlUses.count(pair.first) > 0);
+        netLevel.push_back(pair.second.level);
+    }
+
+    size_t buffers = 0, marked = 0;
+    const std::vector<uint8_t> clock = findClockNetworks(graph, netLevel, excluded, controlUse, buffers);
+    size_t id = 0;
+    for (auto& pair : nets) {
+        pair.second.clockNetwork = clock[id++];
+        marked += pair.second.clockNetwork;
+    }
+    std::cout << "Found " << marked << " clock/reset network net(s) with " << buffers << " buffer(s)/inverter(s)." << std::endl;
+}
+
+// Generates and prints debug information to files.
+void Circuit::printDebugInfo(const std::string& outputDir) const {
+    std::cout << "Writing debug files to " << outputDir << "..." << std::endl;
+    printGatesToFile(outputDir + "/gates_info.txt");
+    printNetsToFile(outputDir + "/nets_info.txt");
+    printLoopsToFile(outputDir + "/loops_info.txt");
+}
+
+// Writes the member nets of every combinational loop to a text file.
+void Circuit::printLoopsToFile(const std::string& filepath) const {
+    std::ofstream ofs(filepath);
+    if (!ofs) {
+        std::cerr << "Error opening file: " << filepath << std::endl;
+        return;
+    }
+    ofs << "--- Combinational Loops ---\n\n";
+    for (size_t i = 0; i < combinationalLoops.size(); ++i) {
+        const auto& loopNets = combinationalLoops[i];
+        ofs << "Loop " << i << " (" << loopNets.size() << " nets):";
+        for (const auto& n : loopNets) ofs << " " << n;
+        ofs << "\n";
+    }
+    if (combinationalLoops.empty()) {
+        std::cout << "No combinational feedback loops detected." << std::endl;
+    } else {
+        std::cout << "Wrote " << combinationalLoops.size() << " combinational loop(s) to " << filepath << std::endl;
+    }
+}
+
+// Writes detailed gate information to a text file.
+void Circuit::printGatesToFile(const std::string& filepath) const {
+    std::ofstream ofs(filepath);
+    if (!ofs) {
+        std::cerr << "Error opening file: " << filepath << std::endl;
+        return;
+    }
+    ofs << "--- Gates Information ---\n\n";
+    for (const auto& g : gates) {
+        ofs << "Gate Name: " << g.name << "\n";
+        ofs << "Type: " << g.type << "\n";
+        if (nets.count(g.output)) {
+            ofs << "Level: " << nets.at(g.output).level << "\n";
+        }
+        ofs << "Output: " << g.output << "\n";
+        ofs << "Inputs: ";
+        for (const auto& inp : g.inputs) ofs << inp << " ";
+        ofs << "\n\n";
+    }
+    std::cout << "Wrote gate info to " << filepath << std::endl;
+}
+
+// Writes detailed net information to a text file.
+void Circuit::printNetsToFile(const std::string& filepath) const {
+    std::ofstream ofs(filepath);
+    if (!ofs) {
+        std::cerr << "Error opening file: " << filepath << std::endl;
+        return;
+    }
+    ofs << "--- Nets Information ---\n\n";
+    for (const auto& pair : nets) {
+        const Net& net = pair.second;
+        ofs << "Net Name: " << net.name << "\n";
+        ofs << "Type: " << (net.type.empty() ? "Wire" : net.type) << (net.clockNetwork ? " (clock/reset network)" : "") << "\n";
+        ofs << "Level: " << net.level << "\n";
+        ofs << "Drivers: ";
+        if (net.drivenByFlipFlop) ofs << "(flipflop) ";
+        for (const auto& d : net.drivers) ofs << d << " ";
+        ofs << "\nLoads: ";
+        for (const auto& l : net.loads) ofs << l << " ";
+        ofs << "\nSCOAP Values:\n";
+        ofs << "  CC0: " << (net.cc0 == INF ? -1 : net.cc0) << ", CC1: " << (net.cc1 == INF ? -1 : net.cc1) << "\n";
+        ofs << "  SC0: " << (net.sc0 == INF ? -1 : net.sc0) << ", SC1: " << (net.sc1 == INF ? -1 : net.sc1) << "\n";
+        ofs << "  CO: " << (net.co == INF ? -1 : net.co) << ", SO: " << (net.so == INF ? -1 : net.so) << "\n\n";
+    }
+    std::cout << "Wrote net info to " << filepath << std::endl;
+}
+
+// Writes SCOAP results to a CSV file
+void Circuit::writeScoapResultsToCSV(const std::string& filepath) const {
+    std::ofstream ofs(filepath);
+    if (!ofs) {
+        std::cerr << "Error opening file: " << filepath << std::endl;
+        return;
+    }
+    ofs << "Net,CC0,CC1,SC0,SC1,CO,SO\n";
+    for (const auto& pair : nets) {
+        const Net& net = pair.second;
+        ofs << net.name << ","
+            << (net.cc0 == INF ? -1 : net.cc0) << ","
+            << (net.cc1 == INF ? -1 : net.cc1) << ","
+            << (net.sc0 == INF ? -1 : net.sc0) << ","
+            << (net.sc1 == INF ? -1 : net.sc1) << ","
+            << (net.co == INF ? -1 : net.co) << ","
+            << (net.so == INF ? -1 : net.so) << "\n";
+    }
+    std::cout << "Wrote SCOAP results to " << filepath << std::endl;
+}
+
+// Returns the data pins of a flip-flop (d | t | j, k | s, r).
+static std::vector<NetName> dataPins(const FlipFlop& ff) {
+    switch (ff.kind) {
+    case FlipFlopType::D:  return {ff.d};
+    case FlipFlopType::T:  return {ff.t};
+    case FlipFlopType::JK: return {ff.j, ff.k};
+    case FlipFlopType::SR: return {ff.s, ff.r};
+    case FlipFlopType::Unknown: break;
+    }
+    return {};
+}
+
+// Writes every net as one row of the columnar export: name, hierarchy scope,
+// level, type, FF-driven and clock flags, driver/fanin/fanout counts, the
+// type of the first driver and the six metrics (-1 for INF). Fanin counts
+// the input pins of the net's drivers (data pins for a flip-flop's Q) and
+// fanout the gate and flip-flop pins it feeds.
+bool Circuit::writeColumnarExport(const std::string& filepath) const {
+    const size_t n = nets.size();
+    std::unordered_map<NetName, uint32_t> position;
+    position.reserve(n);
+    for (const auto& pair : nets) position.emplace(pair.first, static_cast<uint32_t>(position.size()));
+    std::vector<uint32_t> drivers(n, 0), fanin(n, 0), fanout(n, 0);
+    std::vector<const std::string*> driverType(n, nullptr);
+    auto addDriver = [&](const NetName& net, const std::string& type, size_t inputs) {
+        auto it = position.find(net);
+        if (it == position.end()) return;
+        if (drivers[it->second]++ == 0) driverType[it->second] = &type;
+        fanin[it->second] += static_cast<uint32_t>(inputs);
+    };
+    auto addLoad = [&](const NetName& net) {
+        auto it = position.find(net);
+        if (it != position.end()) ++fanout[it->second];
+    };
+    for (const auto& gate : gates) {
+        addDriver(gate.output, gate.type, gate.inputs.size());
+        for (const auto& inp : gate.inputs) addLoad(inp);
+    }
+    for (const auto& ff : flipflops) {
+        size_t connected = 0;
+        for (const auto& pin : dataPins(ff)) connected += !pin.empty();
+        addDriver(ff.q, ff.type, connected);
+        for (const NetName* pin : {&ff.clk, &ff.d, &ff.t, &ff.j, &ff.k, &ff.s, &ff.r, &ff.en, &ff.set, &ff.rst}) {
+            if (!pin->empty()) addLoad(*pin);
+        }
+    }
+
+    // Scope: the hierarchical prefix of a flattened name, up to the last '/'
+    // or '.'. A bit index holds neither, so it is a prefix of the base name.
+    auto scopeOf = [](const NetName& name) {
+        const std::string_view base = name.base();
+        const size_t cut = base.find_last_of("/.");
+        return cut == std::string_view::npos ? std::string_view() : base.substr(0, cut);
+    };
+    uint64_t nameBytes = 0, scopeBytes = 0, driverBytes = 0;
+    for (const auto& pair : nets) {
+        nameBytes += pair.first.size();
+        scopeBytes += scopeOf(pair.first).size();
+    }
+    for (const std::string* type : driverType) driverBytes += type ? type->size() : 0;
+
+    using Type = ColumnarWriter::Type;
+    ColumnarWriter writer(filepath, n);
+    if (!writer.isOpen()) {
+        std::cerr << "Error opening file: " << filepath << std::endl;
+        return false;
+    }
+    writer.addColumn("name", Type::Utf8, nameBytes);
+    writer.addColumn("scope", Type::Utf8, scopeBytes);
+    writer.addColumn("level", Type::Int32);
+    writer.addColumn("type", Type::UInt8);
+    writer.addColumn("ff_driven", Type::UInt8);
+    writer.addColumn("clock_network", Type::UInt8);
+    writer.addColumn("drivers", Type::UInt32);
+    writer.addColumn("fanin", Type::UInt32);
+    writer.addColumn("fanout", Type::UInt32);
+    writer.addColumn("driver_type", Type::Utf8, driverBytes);
+    static const char* metricNames[] = {"cc0", "cc1", "sc0", "sc1", "co", "so"};
+    for (const char* name : metricNames) writer.addColumn(name, Type::Int32);
+
+    // Utf8 columns: offsets, then bytes.
+    auto writeStrings = [&](auto&& size, auto&& value) {
+        writer.beginColumn();
+        uint64_t offset = 0;
+        writer.putOffset(0);
+        size_t i = 0;
+        for (const auto& pair : nets) writer.putOffset(offset += size(pair.first, i++));
+        i = 0;
+        for (const auto& pair : nets) {
+            const auto s = value(pair.first, i++);
+            writer.putBytes(s.data(), s.size());
+        }
+    };
+    auto writeViews = [&](auto&& value) {
+        writeStrings([&](const NetName& name, size_t i) { return value(name, i).size(); }, value);
+    };
+    auto writeNets = [&](auto&& put) {
+        writer.beginColumn();
+        size_t i = 0;
+        for (const auto& pair : nets) put(pair.second, i++);
+    };
+    // Bit names are spelled out here, one at a time.
+    writeStrings([](const NetName& name, size_t) { return name.size(); },
+                 [](const NetName& name, size_t) { return name.str(); });
+    writeViews([&](const NetName& name, size_t) { return scopeOf(name); });
+    writeNets([&](const Net& net, size_t) { writer.putInt32(net.level); });
+    writeNets([&](const Net& net, size_t) { writer.putUInt8(net.type == "P" ? 1 : net.type == "O" ? 2 : 0); });
+    writeNets([&](const Net& net, size_t) { writer.putUInt8(net.drivenByFlipFlop); });
+    writeNets([&](const Net& net, size_t) { writer.putUInt8(net.clockNetwork); });
+    writeNets([&](const Net&, size_t i) { writer.putUInt32(drivers[i]); });
+    writeNets([&](const Net&, size_t i) { writer.putUInt32(fanin[i]); });
+    writeNets([&](const Net&, size_t i) { writer.putUInt32(fanout[i]); });
+    writeViews([&](const NetName&, size_t i) {
+        return driverType[i] ? std::string_view(*driverType[i]) : std::string_view();
+    });
+    for (int Net::*metric : {&Net::cc0, &Net::cc1, &Net::sc0, &Net::sc1, &Net::co, &Net::so}) {
+        writeNets([&](const Net& net, size_t) { writer.putInt32(net.*metric == INF ? -1 : net.*metric); });
+    }
+    if (!writer.finish()) {
+        std::cerr << "Error writing file: " << filepath << std::endl;
+        return false;
+    }
+    std::cout << "Wrote columnar export to " << filepath << std::endl;
+    return true;
+}
+
+// Writes the distributions of the six metrics in one parallel pass over the
+// nets: scoap_stats.csv (count, INF count, min, quantiles, max and mean of
+// the finite values, over all nets, per level and per driver type) and
+// scoap_histogram.csv (finite values in power-of-two bins, and INF).
+bool Circuit::writeMetricStatistics(const std::string& outputDir) const {
+    const std::string statsFile = outputDir + "/scoap_stats.csv";
+    const std::string histogramFile = outputDir + "/scoap_histogram.csv";
+    std::ofstream statsOut(statsFile);
+    std::ofstream histogramOut(histogramFile);
+    if (!statsOut || !histogramOut) {
+        std::cerr << "Error opening statistics files in " << outputDir << std::endl;
+        return false;
+    }
+    auto start = std::chrono::steady_clock::now();
+
+    // Group of each net: the type of its first driving gate (found during
+    // levelization), else flip-flop, input or undriven.
+    std::vector<std::string> groupNames = {"flip-flop", "input", "undriven"};
+    std::vector<uint32_t> gateGroup(gates.size());
+    std::unordered_map<std::string_view, uint32_t> groupIds;
+    const std::string* lastType = nullptr;
+    for (size_t g = 0; g < gates.size(); ++g) {
+        const std::string& type = gates[g].type;
+        if (lastType && *lastType == type) {
+            gateGroup[g] = gateGroup[g - 1];
+            continue;
+        }
+        auto id = groupIds.emplace(type, static_cast<uint32_t>(groupNames.size()));
+        if (id.second) groupNames.push_back(type);
+        gateGroup[g] = id.first->second;
+        lastType = &type;
+    }
+    std::vector<const Net*> list;
+    list.reserve(nets.size());
+    for (const auto& pair : nets) list.push_back(&pair.second);
+
+    std::vector<MetricStats> partial(pool().concurrency());
+    pool().parallelChunks(list.size(), [&](size_t first, size_t last, unsigned t) {
+        for (size_t i = first; i < last; ++i) {
+            const Net& net = *list[i];
+            const int values[] = {net.cc0, net.cc1, net.sc0, net.sc1, net.co, net.so};
+            const uint32_t group = i < netDriver.size() && netDriver[i] >= 0 ? gateGroup[netDriver[i]]
+                                 : net.drivenByFlipFlop ? 0 : net.type == "P" ? 1 : 2;
+            partial[t].add(net.level, group, values, INF);
+        }
+    });
+    MetricStats stats;
+    for (const auto& p : partial) stats.merge(p);
+
+    static const char* metricNames[] = {"CC0", "CC1", "SC0", "SC1", "CO", "SO"};
+    statsOut << "Group,Key,Metric,Nets,Inf,Min,P10,P50,P90,P99,Max,Mean\n";
+    auto writeSummaries = [&](const char* groupName, const std::string& key, const MetricStats::Summaries& s) {
+        for (int m = 0; m < MetricStats::NumMetrics; ++m) {
+            const QuantileSketch& q = s[m].finite;
+            const uint64_t total = q.count() + s[m].inf;
+            if (total == 0) continue;
+            statsOut << groupName << "," << key << "," << metricNames[m] << "," << total << "," << s[m].inf;
+            if (q.count() == 0) {
+                statsOut << ",-1,-1,-1,-1,-1,-1,-1\n";
+                continue;
+            }
+            statsOut << "," << q.min() << "," << q.quantile(0.1) << "," << q.quantile(0.5) << "," << q.quantile(0.9)
+                     << "," << q.quantile(0.99) << "," << q.max() << "," << q.mean() << "\n";
+        }
+    };
+    const MetricStats::Summaries total = stats.total();
+    writeSummaries("all", "*", total);
+    for (size_t l = 0; l < stats.byLevel.size(); ++l) writeSummaries("level", std::to_string(l), stats.byLevel[l]);
+    for (size_t g = 0; g < stats.byGroup.size(); ++g) writeSummaries("driver", groupNames[g], stats.byGroup[g]);
+
+    histogramOut << "Metric,Low,High,Nets\n";
+    for (int m = 0; m < MetricStats::NumMetrics; ++m) {
+        const auto bins = total[m].finite.log2Histogram();
+        for (size_t b = 0; b < bins.size(); ++b) {
+            if (bins[b] == 0) continue;
+            const uint64_t low = b == 0 ? 0 : uint64_t(1) << (b - 1);
+            const uint64_t high = b == 0 ? 0 : (uint64_t(1) << b) - 1;
+            histogramOut << metricNames[m] << "," << low << "," << high << "," << bins[b] << "\n";
+        }
+        if (total[m].inf > 0) histogramOut << metricNames[m] << ",-1,-1," << total[m].inf << "\n";
+    }
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Wrote metric statistics to " << statsFile << " and " << histogramFile << " (" << ms << " ms)" << std::endl;
+    return true;
+}
+
+// Writes the unscanned flip-flops ranked by scan benefit: scanning makes Q a
+// pseudo-PI (SC0 = SC1 = 0) and the data pins pseudo-POs (SO = 0), so the
+// benefit is SC0(Q) + SC1(Q) + the SO of the data pins. Flip-flops with an
+// INF term (benefit -1) come first.
+void Circuit::writeScanRanking(const std::string& filepath) const {
+    struct Candidate {
+        const FlipFlop* ff;
+        int sc0, sc1, soData;
+        long long benefit; // -1 if any term is INF
+    };
+    std::vector<Candidate> candidates;
+    for (const auto& ff : flipflops) {
+        if (scanAll || scanFlipFlops.count(ff.name) || !nets.count(ff.q)) continue;
+        const Net& q = nets.at(ff.q);
+        Candidate c{&ff, q.sc0, q.sc1, 0, 0};
+        for (const auto& pin : dataPins(ff)) {
+            const int so = nets.count(pin) ? nets.at(pin).so : INF;
+            c.soData = (so == INF || c.soData == INF) ? INF : c.soData + so;
+        }
+        const bool unreachable = c.sc0 == INF || c.sc1 == INF || c.soData == INF;
+        c.benefit = unreachable ? -1 : static_cast<long long>(c.sc0) + c.sc1 + c.soData;
+        candidates.push_back(c);
+    }
+    std::stable_sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        if ((a.benefit < 0) != (b.benefit < 0)) return a.benefit < 0;
+        return a.benefit > b.benefit;
+    });
+
+    std::ofstream ofs(filepath);
+    if (!ofs) {
+        std::cerr << "Error opening file: " << filepath << std::endl;
+        return;
+    }
+    ofs << "FlipFlop,Q,SC0,SC1,SO_Data,Benefit\n";
+    for (const auto& c : candidates) {
+        ofs << c.ff->name << "," << c.ff->q << ","
+            << (c.sc0 == INF ? -1 : c.sc0) << ","
+            << (c.sc1 == INF ? -1 : c.sc1) << ","
+            << (c.soData == INF ? -1 : c.soData) << ","
+            << c.benefit << "\n";
+    }
+    std::cout << "Wrote scan ranking of " << candidates.size() << " flip-flops to " << filepath << std::endl;
+}
+
+// Evaluates each scan set on a copy of the same netlist. The word "all" in a
+// set selects every flip-flop and "none" selects none.
+bool Circuit::evaluateScanSets(const std::string& setsFile, const std::string& outputFile) {
+    std::vector<std::vector<std::string>> sets;
+    if (!readNameLines(setsFile, sets)) {
+        std::cerr << "Error opening scan sets: " << setsFile << std::endl;
+        return false;
+    }
+    std::ofstream ofs(outputFile);
+    if (!ofs) {
+        std::cerr << "Error opening file: " << outputFile << std::endl;
+        return false;
+    }
+    std::cout << "Evaluating " << sets.size() << " scan sets..." << std::endl;
+    auto start = std::chrono::steady_clock::now();
+    CompactNetlist base = CompactNetlist::build(gates, flipflops, nets, primaryOutputs, &cellLibrary);
+    base.reorderForLocality();
+    if (metricBits == 16) {
+        writeScanSetSummaries<uint16_t>(base, sets, ofs);
+    } else {
+        writeScanSetSummaries<uint32_t>(base, sets, ofs);
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Wrote scan set summaries to " << outputFile << " (" << ms << " ms)" << std::endl;
+    return true;
+}
+
+// Runs all SCOAP passes for each scan set and writes one summary row per set:
+// the nets that cannot be controlled or observed, and the mean finite SC and
+// SO. Clock/reset network nets are left out, as in the K-Means features.
+template <typename T>
+void Circuit::writeScanSetSummaries(const CompactNetlist& base, const std::vector<std::vector<std::string>>& sets, std::ostream& out) const {
+    using M = Metric<T>;
+    std::vector<uint8_t> dataNet(base.numNets());
+    for (size_t n = 0; n < base.numNets(); ++n) dataNet[n] = !(base.netFlags[n] & CompactNetlist::ClockNetwork);
+
+    out << "Set,ScannedFlipFlops,UncontrollableNets,UnobservableNets,MeanSC,MeanSO\n";
+    for (size_t i = 0; i < sets.size(); ++i) {
+        const bool all = std::find(sets[i].begin(), sets[i].end(), "all") != sets[i].end();
+        std::set<std::string> names(sets[i].begin(), sets[i].end());
+        names.erase("all");
+        names.erase("none");
+
+        CompactNetlist netlist = base;
+        netlist.applyScan(scanMask(all, names));
+        ScoapEngine<T> engine(netlist);
+        engine.computeCombinationalControllability();
+        engine.computeSequentialControllability();
+        engine.computeCombinationalObservability();
+        engine.computeSequentialObservability();
+
+        size_t uncontrollable = 0, unobservable = 0, controllable = 0, observable = 0;
+        double scSum = 0.0, soSum = 0.0;
+        for (size_t n = 0; n < netlist.numNets(); ++n) {
+            if (!dataNet[n]) continue;
+            if (engine.sc0[n] == M::INF || engine.sc1[n] == M::INF) {
+                ++uncontrollable;
+            } else {
+                scSum += (static_cast<double>(engine.sc0[n]) + engine.sc1[n]) / 2.0;
+                ++controllable;
+            }
+            if (engine.so[n] == M::INF) {
+                ++unobservable;
+            } else {
+                soSum += engine.so[n];
+                ++observable;
+            }
+        }
+        out << i << "," << base.numFlipFlops() - netlist.numFlipFlops() << ","
+            << uncontrollable << "," << unobservable << ","
+            << (controllable ? scSum / controllable : 0.0) << ","
+            << (observable ? soSum / observable : 0.0) << "\n";
+    }
+}
+
+// Groups the flip-flops by clock domain (the root of their clock net's
+// buffer/inverter tree), computes SC/SO per domain and finds the flip-flop
+// data pins reached from another domain. Writes clock_domains.csv and
+// cdc_nets.csv to outputDir. Requires calculated metrics.
+bool Circuit::writeClockDomainReport(const std::string& outputDir) {
+    std::ofstream domainsOut(outputDir + "/clock_domains.csv");
+    std::ofstream crossingsOut(outputDir + "/cdc_nets.csv");
+    if (!domainsOut || !crossingsOut) {
+        std::cerr << "Error opening clock domain report files in " << outputDir << std::endl;
+        return false;
+    }
+    CompactNetlist base = CompactNetlist::build(gates, flipflops, nets, primaryOutputs, &cellLibrary);
+    if (scanAll || !scanFlipFlops.empty()) base.applyScan(scanMask(scanAll, scanFlipFlops));
+    base.reorderForLocality();
+    if (metricBits == 16) {
+        writeClockDomains<uint16_t>(base, domainsOut, crossingsOut);
+    } else {
+        writeClockDomains<uint32_t>(base, domainsOut, crossingsOut);
+    }
+    std::cout << "Wrote clock domain reports to " << outputDir << "." << std::endl;
+    return true;
+}
+
+template <typename T>
+void Circuit::writeClockDomains(const CompactNetlist& base, std::ostream& domainsOut, std::ostream& crossingsOut) {
+    using M = Metric<T>;
+    const std::vector<Net*> byId = netsById(base);
+
+    // Domain of each flip-flop: the root of its clock net, found by walking
+    // up through buffers and inverters (inside or outside clock networks).
+    std::vector<int32_t> treeParent(base.numNets(), -1);
+    std::vector<uint8_t> drivers(base.numNets(), 0);
+    auto addDriver = [&](int32_t net, int32_t parent) {
+        treeParent[net] = ++drivers[net] == 1 ? parent : -1;
+        drivers[net] = std::min<uint8_t>(drivers[net], 2);
+    };
+    for (const ClockTreeEdge& e : base.clockTree) addDriver(e.net, e.parent);
+    for (const GateBatch& b : base.batches) {
+        const bool buffer = (b.type == GateType::Buf || b.type == GateType::Not) && b.arity == 1 && b.loop < 0;
+        for (uint32_t g = b.begin; g < b.end; ++g) addDriver(base.gateOutput[g], buffer ? base.gateInputs[base.gateInputBegin[g]] : -1);
+    }
+    std::vector<int32_t> domainRoot;
+    std::unordered_map<int32_t, int32_t> domainOf;
+    std::vector<int32_t> ffDomain(base.numFlipFlops());
+    std::vector<std::vector<size_t>> domainFlipFlops;
+    for (size_t f = 0; f < base.numFlipFlops(); ++f) {
+        int32_t root = base.ffClk[f];
+        while (treeParent[root] >= 0) root = treeParent[root];
+        auto inserted = domainOf.emplace(root, static_cast<int32_t>(domainRoot.size()));
+        if (inserted.second) {
+            domainRoot.push_back(root);
+            domainFlipFlops.emplace_back();
+        }
+        ffDomain[f] = inserted.first->second;
+        domainFlipFlops[ffDomain[f]].push_back(f);
+    }
+    const size_t numDomains = domainRoot.size();
+    std::cout << "Found " << numDomains << " clock domain(s)." << std::endl;
+
+    // Clock domain crossings: propagate the set of domains whose flip-flops
+    // reach each net through combinational logic, then check the data pins.
+    const size_t words = (numDomains + 63) / 64;
+    std::vector<uint64_t> reach(base.numNets() * words, 0);
+    for (size_t f = 0; f < base.numFlipFlops(); ++f) {
+        reach[base.ffQ[f] * words + ffDomain[f] / 64] |= uint64_t(1) << (ffDomain[f] % 64);
+    }
+    auto propagate = [&](const GateBatch& b) {
+        bool changed = false;
+        for (uint32_t g = b.begin; g < b.end; ++g) {
+            uint64_t* out = &reach[base.gateOutput[g] * words];
+            for (uint32_t i = base.gateInputBegin[g]; i < base.gateInputBegin[g + 1]; ++i) {
+                const uint64_t* in = &reach[base.gateInputs[i] * words];
+                for (size_t w = 0; w < words; ++w) {
+                    if (in[w] & ~out[w]) {
+                        out[w] |= in[w];
+                        changed = true;
+                    }
+                }
+            }
+        }
+        return changed;
+    };
+    for (uint32_t bi = 0; bi < base.batches.size(); ++bi) {
+        const GateBatch& b = base.batches[bi];
+        if (b.loop < 0) {
+            propagate(b);
+            continue;
+        }
+        const GateLoop& loop = base.loops[b.loop];
+        bool changed;
+        do {
+            changed = false;
+            for (uint32_t lb = loop.batchBegin; lb < loop.batchEnd; ++lb) changed |= propagate(base.batches[lb]);
+        } while (changed);
+        bi = loop.batchEnd - 1;
+    }
+
+    std::vector<size_t> crossingsInto(numDomains, 0);
+    crossingsOut << "Net,FlipFlop,ToDomain,FromDomains,CC0,CC1,SC0,SC1,CO,SO\n";
+    for (size_t f = 0; f < base.numFlipFlops(); ++f) {
+        for (int32_t pin : {base.ffIn0[f], base.ffIn1[f], base.ffEn[f]}) {
+            if (pin < 0) continue;
+            std::string from;
+            for (size_t d = 0; d < numDomains; ++d) {
+                if (static_cast<int32_t>(d) == ffDomain[f] || !(reach[pin * words + d / 64] >> (d % 64) & 1)) continue;
+                from += (from.empty() ? "" : " ") + byId[domainRoot[d]]->name.str();
+            }
+            if (from.empty()) continue;
+            ++crossingsInto[ffDomain[f]];
+            const Net& net = *byId[pin];
+            auto value = [](int v) { return v == INF ? -1 : v; };
+            crossingsOut << net.name << "," << flipflops[base.ffSource[f]].name << ","
+                         << byId[domainRoot[ffDomain[f]]]->name << "," << from << ","
+                         << value(net.cc0) << "," << value(net.cc1) << "," << value(net.sc0) << ","
+                         << value(net.sc1) << "," << value(net.co) << "," << value(net.so) << "\n";
+        }
+    }
+
+    // Per-domain SC/SO: the flip-flops of other domains are cut like scan
+    // cells, so the values count cycles of this domain's clock only. The
+    // domains are independent and run in parallel on the thread pool.
+    struct DomainSummary {
+        T maxSc = 0, maxSo = 0;
+        double scSum = 0.0, soSum = 0.0;
+        size_t controllable = 0, observable = 0;
+    };
+    std::vector<DomainSummary> summaries(numDomains);
+    std::atomic<size_t> nextDomain{0};
+    auto worker = [&](unsigned) {
+        for (size_t d; (d = nextDomain.fetch_add(1)) < numDomains;) {
+            std::vector<uint8_t> cut(flipflops.size(), 0);
+            for (size_t f = 0; f < base.numFlipFlops(); ++f) {
+                if (ffDomain[f] != static_cast<int32_t>(d)) cut[base.ffSource[f]] = 1;
+            }
+            CompactNetlist netlist = base;
+            netlist.applyScan(cut);
+            ScoapEngine<T> engine(netlist);
+            engine.computeCombinationalControllability();
+            engine.computeSequentialControllability();
+            engine.computeCombinationalObservability();
+            engine.computeSequentialObservability();
+
+            DomainSummary& s = summaries[d];
+            for (size_t f = 0; f < netlist.numFlipFlops(); ++f) {
+                const int32_t q = netlist.ffQ[f];
+                if (engine.sc0[q] != M::INF && engine.sc1[q] != M::INF) {
+                    s.maxSc = std::max({s.maxSc, engine.sc0[q], engine.sc1[q]});
+                    s.scSum += (static_cast<double>(engine.sc0[q]) + engine.sc1[q]) / 2.0;
+                    ++s.controllable;
+                }
+                for (int32_t pin : {netlist.ffIn0[f], netlist.ffIn1[f]}) {
+                    if (pin < 0 || engine.so[pin] == M::INF) continue;
+                    s.maxSo = std::max(s.maxSo, engine.so[pin]);
+                    s.soSum += engine.so[pin];
+                    ++s.observable;
+                }
+            }
+        }
+    };
+    pool().parallel(static_cast<unsigned>(std::min<size_t>(numDomains, pool().concurrency())), worker);
+
+    domainsOut << "Domain,FlipFlops,ControllableFlipFlops,MaxSC,MeanSC,ObservableDataPins,MaxSO,MeanSO,CrossingsIn\n";
+    for (size_t d = 0; d < numDomains; ++d) {
+        const DomainSummary& s = summaries[d];
+        domainsOut << byId[domainRoot[d]]->name << "," << domainFlipFlops[d].size() << ","
+                   << s.controllable << "," << M::toInt(s.maxSc) << ","
+                   << (s.controllable ? s.scSum / s.controllable : 0.0) << ","
+                   << s.observable << "," << M::toInt(s.maxSo) << ","
+                   << (s.observable ? s.soSum / s.observable : 0.0) << "," << crossingsInto[d] << "\n";
+    }
+}
+
+// Computes the neighborhood features of every net (see TrojanFeatures),
+// clusters them and writes one row per net with its cluster and outlier
+// score. Requires calculated metrics.
+bool Circuit::writeTrojanFeatures(const std::string& filepath, int hops) {
+    std::ofstream ofs(filepath);
+    if (!ofs) {
+        std::cerr << "Error opening file: " << filepath << std::endl;
+        return false;
+    }
+    CompactNetlist base = CompactNetlist::build(gates, flipflops, nets, primaryOutputs, &cellLibrary);
+    if (scanAll || !scanFlipFlops.empty()) base.applyScan(scanMask(scanAll, scanFlipFlops));
+    base.reorderForLocality();
+    const std::vector<Net*> byId = netsById(base);
+    std::vector<int> cc0(byId.size()), cc1(byId.size()), co(byId.size());
+    for (size_t id = 0; id < byId.size(); ++id) {
+        cc0[id] = byId[id]->cc0;
+        cc1[id] = byId[id]->cc1;
+        co[id] = byId[id]->co;
+    }
+    TrojanFeatures features(base, cc0, cc1, co);
+    features.hops = hops;
+    features.compute(pool());
+    features.score(3);
+
+    std::vector<int32_t> idAt(byId.size());
+    for (size_t id = 0; id < byId.size(); ++id) idAt[base.netPosition[id]] = static_cast<int32_t>(id);
+    ofs << "Net";
+    for (const char* name : TrojanFeatures::columnNames) ofs << "," << name;
+    ofs << ",Cluster,OutlierScore\n";
+    for (int32_t id : idAt) {
+        ofs << byId[id]->name;
+        for (int c = 0; c < TrojanFeatures::NumColumns; ++c) ofs << "," << features.value(id, static_cast<TrojanFeatures::Column>(c));
+        ofs << "," << features.cluster(id) << "," << features.outlierScore(id) << "\n";
+    }
+    std::cout << "Wrote trojan features (" << hops << "-hop neighborhoods) to " << filepath << std::endl;
+    return true;
+}
+
+namespace {
+
+// A gate or flip-flop instance of one circuit, for the diff merge.
+struct Instance {
+    const std::string* name;
+    const Gate* gate;
+    const FlipFlop* ff;
+    const std::string& type() const { return gate ? gate->type : ff->type; }
+    const NetName& driven() const { return gate ? gate->output : ff->q; }
+    bool sameAs(const Instance& other) const {
+        if (gate && other.gate) return gate->type == other.gate->type && gate->output == other.gate->output && gate->inputs == other.gate->inputs;
+        if (ff && other.ff) {
+            return ff->type == other.ff->type && ff->clk == other.ff->clk && ff->q == other.ff->q && ff->d == other.ff->d
+                && ff->t == other.ff->t && ff->j == other.ff->j && ff->k == other.ff->k && ff->s == other.ff->s
+                && ff->r == other.ff->r && ff->en == other.ff->en && ff->set == other.ff->set && ff->rst == other.ff->rst;
+        }
+        return false;
+    }
+    // The input connections in pin order (unused flip-flop pins are empty).
+    std::vector<const NetName*> inputPins() const {
+        std::vector<const NetName*> pins;
+        if (gate) {
+            for (const auto& in : gate->inputs) pins.push_back(&in);
+        } else {
+            for (const NetName* pin : {&ff->clk, &ff->d, &ff->t, &ff->j, &ff->k, &ff->s, &ff->r, &ff->en, &ff->set, &ff->rst}) pins.push_back(pin);
+        }
+        return pins;
+    }
+    // Like sameAs, with the nets of `other` renamed by `toGolden`.
+    template <typename ToGolden>
+    bool sameAs(const Instance& other, ToGolden toGolden) const {
+        if (type() != other.type() || driven() != toGolden(other.driven())) return false;
+        const auto pins = inputPins(), otherPins = other.inputPins();
+        if (pins.size() != otherPins.size()) return false;
+        for (size_t p = 0; p < pins.size(); ++p) {
+            if (*pins[p] != (otherPins[p]->empty() ? *otherPins[p] : toGolden(*otherPins[p]))) return false;
+        }
+        return true;
+    }
+    // Orders instances of one kind by declaration.
+    const void* declared() const { return gate ? static_cast<const void*>(gate) : static_cast<const void*>(ff); }
+    // Primitives whose inputs may be connected in any order.
+    bool symmetric() const { return gate && gate->kind >= GateType::And && gate->kind <= GateType::Xnor; }
+};
+
+// Instances sorted by name, referring to the circuit's own strings.
+std::vector<Instance> sortedInstances(const std::vector<Gate>& gates, const std::vector<FlipFlop>& flipflops) {
+    std::vector<Instance> instances;
+    instances.reserve(gates.size() + flipflops.size());
+    for (const auto& g : gates) instances.push_back({&g.name, &g, nullptr});
+    for (const auto& ff : flipflops) instances.push_back({&ff.name, nullptr, &ff});
+    std::sort(instances.begin(), instances.end(), [](const Instance& a, const Instance& b) { return *a.name < *b.name; });
+    return instances;
+}
+
+void writeMetrics(std::ostream& out, const Net* net) {
+    for (int Net::*metric : {&Net::cc0, &Net::cc1, &Net::sc0, &Net::sc1, &Net::co, &Net::so}) {
+        out << ",";
+        if (net) out << (net->*metric == INF ? -1 : net->*metric);
+    }
+}
+
+// The largest difference between the metrics of two nets, or -1 if a metric
+// became or stopped being INF.
+long long metricShift(const Net& golden, const Net& suspect) {
+    long long shift = 0;
+    for (int Net::*metric : {&Net::cc0, &Net::cc1, &Net::sc0, &Net::sc1, &Net::co, &Net::so}) {
+        const int a = golden.*metric, b = suspect.*metric;
+        if ((a == INF) != (b == INF)) return -1;
+        if (a != INF) shift = std::max<long long>(shift, std::abs(static_cast<long long>(a) - b));
+    }
+    return shift;
+}
+
+template <typename Name>
+void writeNetRow(std::ostream& out, const char* kind, const Name& name, const Net* gn, const Net* sn) {
+    out << kind << "," << name << ",";
+    writeMetrics(out, gn);
+    writeMetrics(out, sn);
+    out << ",";
+    if (gn && sn) out << metricShift(*gn, *sn);
+    out << "\n";
+}
+
+// One side of the structural matching: the nets and instances the name
+// merge left unmatched, with the driver of each such net.
+struct Leftovers {
+    std::vector<const Net*> nets;          // Sorted by name
+    std::vector<const Instance*> instances;
+    std::vector<const Instance*> drivers;  // Parallel to `nets`; null for inputs and undriven nets
+    std::vector<int64_t> inputPosition;    // Parallel to `nets`; position in the input port list, or -1
+    std::vector<char> namedDriver;         // Parallel to `nets`; the driver's name is on both sides
+    std::vector<int64_t> netMatch;         // Index of the matched net on the other side, or -1
+    std::vector<int64_t> instanceMatch;
+    std::vector<char> instanceChanged;     // Matched by the driven net only
+
+    int64_t find(const NetName& name) const {
+        auto it = std::lower_bound(nets.begin(), nets.end(), name, [](const Net* n, const NetName& v) { return n->name < v; });
+        return it != nets.end() && (*it)->name == name ? it - nets.begin() : -1;
+    }
+    void index(const std::vector<Instance>& all, const std::vector<NetName>& primaryInputs) {
+        drivers.assign(nets.size(), nullptr);
+        inputPosition.assign(nets.size(), -1);
+        for (size_t p = 0; p < primaryInputs.size(); ++p) {
+            const int64_t n = find(primaryInputs[p]);
+            if (n >= 0) inputPosition[n] = static_cast<int64_t>(p);
+        }
+        netMatch.assign(nets.size(), -1);
+        instanceMatch.assign(instances.size(), -1);
+        instanceChanged.assign(instances.size(), 0);
+        namedDriver.assign(nets.size(), 0);
+        for (const auto& inst : all) {
+            const int64_t n = find(inst.driven());
+            if (n < 0) continue;
+            drivers[n] = &inst;
+            namedDriver[n] = !std::binary_search(instances.begin(), instances.end(), &inst,
+                                                 [](const Instance* a, const Instance* b) { return *a->name < *b->name; });
+        }
+    }
+};
+
+uint64_t hashKey(const std::vector<int64_t>& key) {
+    uint64_t h = key.size();
+    for (int64_t v : key) h ^= static_cast<uint64_t>(v) + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+    return h;
+}
+
+// Nets or instances of both sides grouped by an integer signature. Groups
+// are found by the hash of the signature and told apart by comparing it.
+struct SignatureGroups {
+    struct Group {
+        std::vector<int64_t> key;
+        std::vector<size_t> members[2]; // Golden, suspect
+        bool touched = false;
+    };
+    std::vector<Group> groups;
+    std::unordered_map<uint64_t, std::vector<uint32_t>> byHash;
+    std::vector<uint32_t> touched; // Groups whose members changed
+
+    uint32_t find(const std::vector<int64_t>& key) {
+        auto& bucket = byHash[hashKey(key)];
+        for (uint32_t g : bucket) {
+            if (groups[g].key == key) return g;
+        }
+        bucket.push_back(static_cast<uint32_t>(groups.size()));
+        groups.push_back({key, {}, false});
+        return bucket.back();
+    }
+    void touch(uint32_t g) {
+        if (groups[g].touched) return;
+        groups[g].touched = true;
+        touched.push_back(g);
+    }
+};
+
+// The connections of one side's leftover nets in ids, resolved once. A pin
+// refers to a net as its golden id (its position in the golden net map) if
+// both sides have the net by name, as -2 - n for leftover net n of the side,
+// whose golden id is known once it is matched, or as -1 if unused.
+struct SideIndex {
+    Leftovers* left;
+    bool isGolden;
+    std::vector<uint32_t> pinBegin{0}; // Input pins of the driver of each net
+    std::vector<int64_t> pins;
+    std::vector<int64_t> driverType;   // Interned type of the driver, or -1
+    std::vector<int64_t> driverName;   // Interned name of a driver both sides have, or -1
+    std::vector<std::vector<uint32_t>> readers; // Nets whose driver reads each net
+    std::vector<int64_t> group;        // Signature group of each unmatched net, or -1
+    std::vector<uint32_t> slot;        // Position in the group's members
+};
+
+constexpr int64_t Unresolved = INT64_MIN;
+
+// Pairs the leftovers of the name merge by structure, so that a renamed net
+// or instance is reported as one rename instead of a removal and an
+// addition. Primary inputs are compared by their position in the port
+// list, other nets by the type of their driver and the golden ids of its
+// inputs, where a suspect net has the golden id it matched by name or in
+// an earlier round. A net whose inputs are not all matched yet matches the
+// output of the driver of the same name, which breaks flip-flop feedback.
+// Each round matches every net whose signature occurs equally often on both
+// sides; driven nets with the same signature (e.g. parallel fanout buffers)
+// are paired in declaration order. The rounds go on until nothing new
+// matches, walking renamed cones level by level. Names are resolved to ids
+// once; the groups persist between rounds, and a round only recomputes the
+// signatures of the readers of the nets matched in the round before and
+// only checks the groups whose members changed.
+// Instances are then paired by type and all connections, and what is still
+// left by the net they drive (a renamed and changed instance).
+void matchByStructure(const NetMap& goldenNets, Leftovers& golden, Leftovers& suspect) {
+    std::unordered_map<NetName, int64_t> goldenId;
+    goldenId.reserve(goldenNets.size());
+    for (const auto& pair : goldenNets) goldenId.emplace(pair.first, static_cast<int64_t>(goldenId.size()));
+    std::vector<int64_t> goldenLeftId(golden.nets.size());
+    for (size_t n = 0; n < golden.nets.size(); ++n) goldenLeftId[n] = goldenId.at(golden.nets[n]->name);
+    std::unordered_map<std::string, int64_t> strings;
+    auto intern = [&](const std::string& text) {
+        return strings.emplace(text, static_cast<int64_t>(strings.size())).first->second;
+    };
+
+    SideIndex sides[2] = {{&golden, true}, {&suspect, false}};
+    auto pinOf = [&](const SideIndex& side, const NetName& net) -> int64_t {
+        if (net.empty()) return -1;
+        const int64_t n = side.left->find(net);
+        if (n >= 0) return -2 - n;
+        auto it = goldenId.find(net);
+        return it == goldenId.end() ? -1 : it->second;
+    };
+    // The golden id of a pin, or Unresolved while its net is not matched.
+    auto resolve = [&](const SideIndex& side, int64_t pin) -> int64_t {
+        if (pin >= -1) return pin;
+        const int64_t n = -2 - pin, match = side.left->netMatch[n];
+        if (match < 0) return Unresolved;
+        return goldenLeftId[side.isGolden ? n : match];
+    };
+    for (SideIndex& side : sides) {
+        const Leftovers& left = *side.left;
+        const size_t numNets = left.nets.size();
+        side.driverType.assign(numNets, -1);
+        side.driverName.assign(numNets, -1);
+        side.readers.resize(numNets);
+        side.group.assign(numNets, -1);
+        side.slot.assign(numNets, 0);
+        for (size_t n = 0; n < numNets; ++n) {
+            if (const Instance* driver = left.drivers[n]) {
+                side.driverType[n] = intern(driver->type());
+                if (left.namedDriver[n]) side.driverName[n] = intern(*driver->name);
+                for (const NetName* pin : driver->inputPins()) {
+                    const int64_t p = pinOf(side, *pin);
+                    side.pins.push_back(p);
+                    if (p <= -2) side.readers[-2 - p].push_back(static_cast<uint32_t>(n));
+                }
+            }
+            side.pinBegin.push_back(static_cast<uint32_t>(side.pins.size()));
+        }
+    }
+
+    // The signature of an unmatched net; false if it has none yet.
+    auto netSignature = [&](const SideIndex& side, size_t n, std::vector<int64_t>& key) {
+        const Leftovers& left = *side.left;
+        key.clear();
+        if (left.drivers[n]) {
+            key.push_back(0);
+            key.push_back(side.driverType[n]);
+            bool resolved = true;
+            for (uint32_t p = side.pinBegin[n]; p < side.pinBegin[n + 1] && resolved; ++p) {
+                const int64_t id = resolve(side, side.pins[p]);
+                resolved = id != Unresolved;
+                key.push_back(id);
+            }
+            if (resolved) {
+                if (left.drivers[n]->symmetric()) std::sort(key.begin() + 2, key.end());
+                return true;
+            }
+            if (side.driverName[n] < 0) return false;
+            key.assign({1, side.driverName[n]});
+        } else if (left.inputPosition[n] >= 0) {
+            key.assign({2, left.inputPosition[n]});
+        } else {
+            key.assign({3});
+        }
+        return true;
+    };
+
+    SignatureGroups groups;
+    auto leave = [&](int s, size_t n) {
+        SideIndex& side = sides[s];
+        if (side.group[n] < 0) return;
+        auto& members = groups.groups[side.group[n]].members[s];
+        const size_t last = members.back();
+        members[side.slot[n]] = last;
+        side.slot[last] = side.slot[n];
+        members.pop_back();
+        groups.touch(static_cast<uint32_t>(side.group[n]));
+        side.group[n] = -1;
+    };
+    std::vector<size_t> dirty[2];
+    std::vector<uint8_t> queued[2];
+    for (int s = 0; s < 2; ++s) {
+        dirty[s].resize(sides[s].left->nets.size());
+        std::iota(dirty[s].begin(), dirty[s].end(), 0);
+        queued[s].assign(dirty[s].size(), 1);
+    }
+    std::vector<int64_t> key;
+    while (!dirty[0].empty() || !dirty[1].empty()) {
+        for (int s = 0; s < 2; ++s) {
+            SideIndex& side = sides[s];
+            for (size_t n : dirty[s]) {
+                queued[s][n] = 0;
+                if (side.left->netMatch[n] >= 0) continue;
+                const int64_t g = netSignature(side, n, key) ? static_cast<int64_t>(groups.find(key)) : -1;
+                if (g == side.group[n]) continue;
+                leave(s, n);
+                if (g < 0) continue;
+                auto& members = groups.groups[g].members[s];
+                side.group[n] = g;
+                side.slot[n] = static_cast<uint32_t>(members.size());
+                members.push_back(n);
+                groups.touch(static_cast<uint32_t>(g));
+            }
+            dirty[s].clear();
+        }
+
+        std::vector<uint32_t> touched;
+        touched.swap(groups.touched);
+        for (uint32_t g : touched) {
+            SignatureGroups::Group& group = groups.groups[g];
+            group.touched = false;
+            std::vector<size_t> gs = group.members[0], ss = group.members[1];
+            if (gs.empty() || gs.size() != ss.size()) continue;
+            if (gs.size() > 1 && group.key[0] > 1) continue; // Several undriven nets
+            for (auto* members : {&gs, &ss}) {
+                const Leftovers& side = members == &gs ? golden : suspect;
+                std::sort(members->begin(), members->end(), [&](size_t a, size_t b) {
+                    return side.drivers[a]->declared() < side.drivers[b]->declared();
+                });
+            }
+            for (size_t k = 0; k < gs.size(); ++k) {
+                golden.netMatch[gs[k]] = static_cast<int64_t>(ss[k]);
+                suspect.netMatch[ss[k]] = static_cast<int64_t>(gs[k]);
+            }
+            for (int s = 0; s < 2; ++s) {
+                for (size_t n : s == 0 ? gs : ss) {
+                    sides[s].group[n] = -1;
+                    for (uint32_t reader : sides[s].readers[n]) {
+                        if (queued[s][reader]) continue;
+                        queued[s][reader] = 1;
+                        dirty[s].push_back(reader);
+                    }
+                }
+            }
+            group.members[0].clear();
+            group.members[1].clear();
+        }
+    }
+
+    // Instances: first by type and all connections, then by the driven net.
+    for (bool byDrivenNet : {false, true}) {
+        SignatureGroups instanceGroups;
+        for (int s = 0; s < 2; ++s) {
+            const SideIndex& side = sides[s];
+            const Leftovers& left = *side.left;
+            for (size_t i = 0; i < left.instances.size(); ++i) {
+                if (left.instanceMatch[i] >= 0) continue;
+                const Instance& inst = *left.instances[i];
+                const int64_t driven = resolve(side, pinOf(side, inst.driven()));
+                if (driven == Unresolved) continue;
+                key.clear();
+                if (!byDrivenNet) {
+                    key.push_back(intern(inst.type()));
+                    bool resolved = true;
+                    for (const NetName* pin : inst.inputPins()) {
+                        const int64_t id = resolve(side, pinOf(side, *pin));
+                        resolved &= id != Unresolved;
+                        key.push_back(id);
+                    }
+                    if (!resolved) continue;
+                    if (inst.symmetric()) std::sort(key.begin() + 1, key.end());
+                }
+                key.push_back(driven);
+                instanceGroups.groups[instanceGroups.find(key)].members[s].push_back(i);
+            }
+        }
+        for (const auto& group : instanceGroups.groups) {
+            if (group.members[0].size() != 1 || group.members[1].size() != 1) continue;
+            const size_t g = group.members[0][0], s = group.members[1][0];
+            golden.instanceMatch[g] = static_cast<int64_t>(s);
+            suspect.instanceMatch[s] = static_cast<int64_t>(g);
+            golden.instanceChanged[g] = byDrivenNet;
+        }
+    }
+}
+
+} // namespace
+
+// Compares this (suspect) circuit with a golden one, both with calculated
+// metrics. Nets and instances are merged by name in one pass over the
+// sorted net maps and name-sorted instance lists, so nothing is joined or
+// copied. Reports nets in both whose metrics differ by more than
+// `threshold` or became (or stopped being) INF, and instances in both that
+// changed (type or connections). What is left on either side is paired by
+// structure (see matchByStructure) into renamed nets and instances; the
+// rest is reported as added and removed.
+bool Circuit::writeNetlistDiff(const Circuit& golden, const std::string& filepath, int threshold) const {
+    std::ofstream ofs(filepath);
+    if (!ofs) {
+        std::cerr << "Error opening file: " << filepath << std::endl;
+        return false;
+    }
+    ofs << "Kind,Name,Type,GoldenCC0,GoldenCC1,GoldenSC0,GoldenSC1,GoldenCO,GoldenSO,"
+           "SuspectCC0,SuspectCC1,SuspectSC0,SuspectSC1,SuspectCO,SuspectSO,MaxShift\n";
+    Leftovers goldenLeft, suspectLeft;
+    size_t shiftedNets = 0;
+    auto g = golden.nets.begin();
+    auto s = nets.begin();
+    while (g != golden.nets.end() || s != nets.end()) {
+        const bool inGolden = g != golden.nets.end() && (s == nets.end() || g->first <= s->first);
+        const bool inSuspect = s != nets.end() && (g == golden.nets.end() || s->first <= g->first);
+        if (inGolden && inSuspect) {
+            const long long shift = metricShift(g->second, s->second);
+            if (shift < 0 || shift > threshold) {
+                writeNetRow(ofs, "ShiftedNet", s->second.name, &g->second, &s->second);
+                ++shiftedNets;
+            }
+        } else if (inGolden) {
+            goldenLeft.nets.push_back(&g->second);
+        } else {
+            suspectLeft.nets.push_back(&s->second);
+        }
+        if (inGolden) ++g;
+        if (inSuspect) ++s;
+    }
+
+    size_t changedInstances = 0;
+    std::vector<std::pair<const Instance*, const Instance*>> differing; // Same name, checked after renames
+    const std::vector<Instance> goldenInstances = sortedInstances(golden.gates, golden.flipflops);
+    const std::vector<Instance> suspectInstances = sortedInstances(gates, flipflops);
+    const std::string emptyMetrics(12, ',');
+    size_t i = 0, j = 0;
+    while (i < goldenInstances.size() || j < suspectInstances.size()) {
+        const Instance* gi = i < goldenInstances.size() ? &goldenInstances[i] : nullptr;
+        const Instance* si = j < suspectInstances.size() ? &suspectInstances[j] : nullptr;
+        if (gi && si && *gi->name == *si->name) {
+            if (!gi->sameAs(*si)) differing.push_back({gi, si});
+            ++i;
+            ++j;
+        } else if (gi && (!si || *gi->name < *si->name)) {
+            goldenLeft.instances.push_back(gi);
+            ++i;
+        } else {
+            suspectLeft.instances.push_back(si);
+            ++j;
+        }
+    }
+
+    goldenLeft.index(goldenInstances, golden.primaryInputs);
+    suspectLeft.index(suspectInstances, primaryInputs);
+    matchByStructure(golden.nets, goldenLeft, suspectLeft);
+    // Instances that only differ by renamed nets are not changed.
+    auto toGolden = [&](const NetName& net) -> const NetName& {
+        const int64_t n = suspectLeft.find(net);
+        return n >= 0 && suspectLeft.netMatch[n] >= 0 ? goldenLeft.nets[suspectLeft.netMatch[n]]->name : net;
+    };
+    for (const auto& [gi, si] : differing) {
+        if (gi->sameAs(*si, toGolden)) continue;
+        ofs << "ChangedInstance," << *si->name << "," << gi->type() << "->" << si->type() << emptyMetrics << ",\n";
+        ++changedInstances;
+    }
+    size_t renamedNets = 0, renamedInstances = 0;
+    for (size_t n = 0; n < goldenLeft.nets.size(); ++n) {
+        if (goldenLeft.netMatch[n] < 0) continue;
+        const Net* sn = suspectLeft.nets[goldenLeft.netMatch[n]];
+        writeNetRow(ofs, "RenamedNet", goldenLeft.nets[n]->name.str() + "->" + sn->name.str(), goldenLeft.nets[n], sn);
+        ++renamedNets;
+    }
+    for (size_t n = 0; n < goldenLeft.instances.size(); ++n) {
+        if (goldenLeft.instanceMatch[n] < 0) continue;
+        const Instance* gi = goldenLeft.instances[n];
+        const Instance* si = suspectLeft.instances[goldenLeft.instanceMatch[n]];
+        const bool changed = goldenLeft.instanceChanged[n];
+        ofs << (changed ? "ChangedInstance," : "RenamedInstance,") << *gi->name << "->" << *si->name << ","
+            << gi->type();
+        if (changed) ofs << "->" << si->type();
+        ofs << emptyMetrics << ",\n";
+        ++(changed ? changedInstances : renamedInstances);
+    }
+    size_t addedNets = 0, removedNets = 0, addedInstances = 0, removedInstances = 0;
+    for (const Leftovers* side : {&goldenLeft, &suspectLeft}) {
+        const bool isGolden = side == &goldenLeft;
+        for (size_t n = 0; n < side->nets.size(); ++n) {
+            if (side->netMatch[n] >= 0) continue;
+            writeNetRow(ofs, isGolden ? "RemovedNet" : "AddedNet", side->nets[n]->name,
+                        isGolden ? side->nets[n] : nullptr, isGolden ? nullptr : side->nets[n]);
+            ++(isGolden ? removedNets : addedNets);
+        }
+        for (size_t n = 0; n < side->instances.size(); ++n) {
+            if (side->instanceMatch[n] >= 0) continue;
+            ofs << (isGolden ? "RemovedInstance," : "AddedInstance,") << *side->instances[n]->name << ","
+                << side->instances[n]->type() << emptyMetrics << ",\n";
+            ++(isGolden ? removedInstances : addedInstances);
+        }
+    }
+    std::cout << "Netlist diff: " << addedNets << " added, " << removedNets << " removed, " << renamedNets
+              << " renamed and " << shiftedNets << " shifted nets; " << addedInstances << " added, "
+              << removedInstances << " removed, " << renamedInstances << " renamed and " << changedInstances
+              << " changed instances. Written to " << filepath << std::endl;
+    return true;
+}
+
+// Helper: Euclidean distance between two points in 6D
+static double scoap_distance(const std::vector<int>& a, const std::vector<int>& b) {
+    double sum = 0.0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        double diff = static_cast<double>(a[i]) - static_cast<double>(b[i]);
+        sum += diff * diff;
+    }
+    return std::sqrt(sum);
+}
+
+// KMeans clustering on SCOAP metrics (CC0, CC1, SC0, SC1, CO, SO)
+void Circuit::runKMeansOnScoap(const std::string& outputFile, int k) const {
+    // Gather feature vectors (skip clock/reset networks and nets with -1/INF values)
+    std::vector<NetName> net_names;
+    std::vector<std::vector<int>> features;
+    for (const auto& pair : nets) {
+        const Net& net = pair.second;
+        if (net.clockNetwork) continue;
+        if (net.cc0 == INF || net.cc1 == INF || net.sc0 == INF || net.sc1 == INF || net.co == INF || net.so == INF)
+            continue;
+        features.push_back({net.cc0, net.cc1, net.sc0, net.sc1, net.co, net.so});
+        net_names.push_back(net.name);
+    }
+    if (features.size() < static_cast<size_t>(k)) {
+        std::cerr << "Not enough nets for KMeans clustering." << std::endl;
+        return;
+    }
+    // KMeans++ initialization
+    std::vector<std::vector<int>> centroids;
+    std::vector<int> chosen;
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<size_t> uni(0, features.size() - 1);
+    centroids.push_back(features[uni(rng)]);
+    for (int c = 1; c < k; ++c) {
+        std::vector<double> dists(features.size(), 1e9);
+        for (size_t i = 0; i < features.size(); ++i) {
+            for (const auto& centroid : centroids) {
+                double d = scoap_distance(features[i], centroid);
+                if (d < dists[i]) dists[i] = d;
+            }
+        }
+        double sum = 0.0;
+        for (double d : dists) sum += d;
+        std::uniform_real_distribution<double> dist(0, sum);
+        double r = dist(rng);
+        double acc = 0.0;
+        size_t next = 0;
+        for (size_t i = 0; i < dists.size(); ++i) {
+            acc += dists[i];
+            if (acc >= r) { next = i; break; }
+        }
+        centroids.push_back(features[next]);
+    }
+    // KMeans iterations
+    std::vector<int> assignments(features.size(), -1);
+    for (int iter = 0; iter < 100; ++iter) {
+        // Assignment step
+        bool changed = false;
+        for (size_t i = 0; i < features.size(); ++i) {
+            double best_dist = 1e9;
+            int best_c = -1;
+            for (int c = 0; c < k; ++c) {
+                double d = scoap_distance(features[i], centroids[c]);
+                if (d < best_dist) {
+                    best_dist = d;
+                    best_c = c;
+                }
+            }
+            if (assignments[i] != best_c) {
+                assignments[i] = best_c;
+                changed = true;
+            }
+        }
+        // Update step
+        std::vector<std::vector<double>> new_centroids(k, std::vector<double>(6, 0.0));
+        std::vector<int> counts(k, 0);
+        for (size_t i = 0; i < features.size(); ++i) {
+            int c = assignments[i];
+            for (int j = 0; j < 6; ++j) new_centroids[c][j] += features[i][j];
+            counts[c]++;
+        }
+        for (int c = 0; c < k; ++c) {
+            if (counts[c] == 0) continue;
+            for (int j = 0; j < 6; ++j) new_centroids[c][j] /= counts[c];
+        }
+        for (int c = 0; c < k; ++c) {
+            for (int j = 0; j < 6; ++j) centroids[c][j] = static_cast<int>(std::round(new_centroids[c][j]));
+        }
+        if (!changed) break;
+    }
+    // Write results
+    std::ofstream ofs(outputFile);
+    if (!ofs) {
+        std::cerr << "Error opening file: " << outputFile << std::endl;
+        return;
+    }
+    ofs << "Net,Cluster,CC0,CC1,SC0,SC1,CO,SO\n";
+    for (size_t i = 0; i < net_names.size(); ++i) {
+        ofs << net_names[i] << "," << assignments[i];
+        for (int v : features[i]) ofs << "," << v;
+        ofs << "\n";
+    }
+    std::cout << "Wrote KMeans clustering results to " << outputFile << std::endl;
+}
@@ -1,48 +1,173 @@
-#ifndef CIRCUIT_H
-#define CIRCUIT_H
-
-#include "DataStructures.h"
-
-// The main class to represent and analyze the digital circuit.
-// It encapsulates all gates, flip-flops, and nets, along with
-// the logic to calculate testability metrics.
-class Circuit {
-public:
-    // Constructor
-    Circuit() = default;
-
-    // Main orchestration methods
-    bool loadFromVerilog(const std::string& filename);
-    void calculateAllScoapMetrics();
-    void printDebugInfo(const std::string& outputDir) const;
-
-    // Public accessors
-    const std::map<std::string, Net>& getNets() const { return nets; }
-
-    // New methods
-    void writeScoapResultsToCSV(const std::string& filepath) const;
-    void runKMeansOnScoap(const std::string& outputFile, int k = 3) const;
-
-private:
-    // Circuit elements
-    std::vector<Gate> gates;
-    std::vector<FlipFlop> flipflops;
-    std::map<std::string, Net> nets;
-    std::vector<std::string> primaryInputs;
-    std::vector<std::string> primaryOutputs;
-
-    // Helper methods for internal calculations
-    Gate findGateByName(const std::string& name) const;
-    void calculateNetLevels();
-    void calculateCombinationalControllability();
-    void calculateSequentialControllability();
-    void calculateCombinationalObservability();
-    void calculateSequentialObservability();
-
-    // Helper methods for diagnostics and output
-    int detectFeedbackLoops() const;
-    void printGatesToFile(const std::string& filepath) const;
-    void printNetsToFile(const std::string& filepath) const;
-};
-
-#endif // CIRCUIT_H
+#ifndef CIRCUIT_H
+#define CIRCUIT_H
+
+#include "DataStructures.h"
+#include "CellLibrary.h"
+#include "ResultCache.h"
+#include <chrono>
+
+struct CompactNetlist;
+struct GateGraph;
+class ThreadPool;
+template <typename T> class ScoapEngine;
+
+// The main class to represent and analyze the digital circuit.
+// It encapsulates all gates, flip-flops, and nets, along with
+// the logic to calculate testability metrics.
+class Circuit {
+public:
+    // Constructor
+    Circuit() = default;
+
+    // Main orchestration methods
+    bool loadFromVerilog(const std::string& filename);
+    void calculateAllScoapMetrics();
+
+    // Selects the width of the metric storage used during calculation (16 or 32 bits).
+    // 16-bit storage halves the memory of the metric arrays; values that do not fit
+    // saturate and are reported as INF.
+    bool setMetricWidth(int bits);
+
+    // Runs the metric calculation out of core within a memory budget (in MB),
+    // for netlists whose engine arrays do not fit in memory.
+    bool setMemoryBudget(double megabytes);
+
+    // Runs the metric calculation in `count` local worker processes, each
+    // evaluating one partition of the netlist. Results are identical. With
+    // bindNuma, the workers are spread over the NUMA nodes.
+    bool setWorkers(int count, bool bindNuma = false);
+
+    // Stops iterating the sequential passes (SC, SO) `seconds` from now. CC
+    // and CO are always completed first; SC and SO are then upper bounds of
+    // their final values. Requires the in-memory engine.
+    bool setTimeBudget(double seconds);
+
+    // Saves the progress of the sequential passes to `filename` every minute
+    // and at the end of the calculation, and resumes from it if it holds a
+    // snapshot of the same netlist and options. Empty disables it. Requires
+    // the in-memory engine.
+    void setCheckpoint(const std::string& filename) { checkpointFile = filename; }
+
+    // False if the time budget ran out before SC and SO converged.
+    bool metricsConverged() const { return converged; }
+
+    // Looks up and stores the metrics in an on-disk cache in `directory`,
+    // keyed by a structural hash of the netlist and the options.
+    void setResultCache(const std::string& directory) { cacheDirectory = directory; }
+
+    // Runs the parallel work of the calculation and of the reports (the
+    // passes, the loops over nets and gates, the clock domains) on `pool`
+    // instead of ThreadPool::shared(). The pool must outlive its use.
+    void setThreadPool(ThreadPool& pool) { threadPool = &pool; }
+
+    // Prints the cheapest justification (CC0, CC1) and propagation (CO)
+    // paths of a net when the metrics are calculated. Requires the
+    // in-memory engine.
+    void explainNet(const std::string& name) { explainNets.push_back(name); }
+
+    // Adds the cell rules from a cell description file to the built-in library.
+    bool loadCellLibrary(const std::string& filename);
+
+    // Configures flip-flops as scan cells (pseudo primary inputs/outputs):
+    // "all", or a file listing flip-flop instance names.
+    bool setScanMode(const std::string& spec);
+    void printDebugInfo(const std::string& outputDir) const;
+
+    // Public accessors
+    const NetMap& getNets() const { return nets; }
+    size_t numLevels() const { return levelBegin.empty() ? 0 : levelBegin.size() - 1; }
+    // Indices into the gate list of the gates at `level` (1-based), after
+    // the metrics have been calculated.
+    std::vector<int32_t> gatesAtLevel(size_t level) const {
+        return {levelGates.begin() + levelBegin[level - 1], levelGates.begin() + levelBegin[level]};
+    }
+
+    // New methods
+    void writeScoapResultsToCSV(const std::string& filepath) const;
+    void runKMeansOnScoap(const std::string& outputFile, int k = 3) const;
+
+    // Writes every net with its level, type, flags, driver/fanin/fanout
+    // counts and metrics in the binary columnar layout of ColumnarWriter.
+    bool writeColumnarExport(const std::string& filepath) const;
+
+    // Writes the distributions of the metrics over all nets, per level and
+    // per driver type (scoap_stats.csv), and their histograms
+    // (scoap_histogram.csv), computed with mergeable quantile sketches.
+    bool writeMetricStatistics(const std::string& outputDir) const;
+
+    // Ranks the flip-flops that are not scanned by the SC/SO they would
+    // remove if they were (requires calculated metrics).
+    void writeScanRanking(const std::string& filepath) const;
+
+    // Evaluates every scan set in a file (one set of flip-flop names per
+    // line) and writes a testability summary per set.
+    bool evaluateScanSets(const std::string& setsFile, const std::string& outputFile);
+
+    // Groups the flip-flops by clock domain and writes per-domain SC/SO
+    // (clock_domains.csv) and the clock domain crossings (cdc_nets.csv).
+    bool writeClockDomainReport(const std::string& outputDir);
+
+    // Writes the structural neighborhood features of every net within
+    // `hops` gates, with a K-Means cluster and outlier score per net.
+    bool writeTrojanFeatures(const std::string& filepath, int hops);
+
+    // Compares this (suspect) circuit with a golden version of the design,
+    // both with calculated metrics: added/removed/renamed nets and
+    // instances, changed instances, and nets whose metrics shifted by more
+    // than `threshold`. Renames are found by structure.
+    bool writeNetlistDiff(const Circuit& golden, const std::string& filepath, int threshold) const;
+
+private:
+    // Circuit elements
+    std::vector<Gate> gates;
+    std::vector<FlipFlop> flipflops;
+    NetMap nets;
+    std::vector<NetName> primaryInputs;
+    std::vector<NetName> primaryOutputs;
+    int metricBits = 32;
+    size_t memoryBudget = 0; // Bytes; 0 runs the in-memory engine
+    int workers = 1;
+    bool bindNumaNodes = false;
+    std::string cacheDirectory; // Empty: no result cache
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    std::string checkpointFile; // Empty: no checkpoint
+    ThreadPool* threadPool = nullptr; // Null: ThreadPool::shared()
+    bool converged = true;
+    std::vector<std::string> explainNets;
+    CellLibrary cellLibrary = CellLibrary::builtin();
+    std::vector<uint32_t> levelBegin; // Gates of level l are levelGates[levelBegin[l - 1] .. levelBegin[l])
+    std::vector<int32_t> levelGates;
+    std::vector<int32_t> netDriver; // First gate driving each net (in map order), or -1
+    std::vector<std::vector<NetName>> combinationalLoops; // Member nets of each loop, indexed by Gate::loop
+    bool scanAll = false;
+    std::set<std::string> scanFlipFlops; // Instance names of scanned flip-flops
+
+    // Helper methods for internal calculations
+    ThreadPool& pool() const;
+    GateGraph gateGraph() const;
+    void calculateNetLevels(const GateGraph& graph);
+    void identifyClockNetworks(const GateGraph& graph);
+    template <typename T>
+    void runScoapEngine(const CompactNetlist& netlist, const CacheKey& key);
+    template <typename T>
+    void printExplanations(const ScoapEngine<T>& engine, const CompactNetlist& netlist, const std::vector<Net*>& byId) const;
+    template <typename T>
+    void runPartitionedEngine(CompactNetlist& netlist);
+    template <typename T>
+    void runDistributedEngine(const CompactNetlist& netlist);
+    std::vector<Net*> netsById(const CompactNetlist& netlist);
+    CacheKey cacheKey() const;
+    size_t netlistBytes() const;
+    std::vector<uint8_t> scanMask(bool all, const std::set<std::string>& names) const;
+    template <typename T>
+    void writeClockDomains(const CompactNetlist& base, std::ostream& domainsOut, std::ostream& crossingsOut);
+    template <typename T>
+    void writeScanSetSummaries(const CompactNetlist& base, const std::vector<std::vector<std::string>>& sets, std::ostream& out) const;
+
+    // Helper methods for diagnostics and output
+    void printLoopsToFile(const std::string& filepath) const;
+    void printGatesToFile(const std::string& filepath) const;
+    void printNetsToFile(const std::string& filepath) const;
+};
+
+#endif // CIRCUIT_H
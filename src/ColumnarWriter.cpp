@@ -0,0 +1,111 @@
+#include "ColumnarWriter.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr size_t kBufferSize = 1 << 16;
+constexpr uint64_t kHeaderSize = 24;
+constexpr uint64_t kDirectoryEntrySize = 56;
+constexpr size_t kNameSize = 32;
+
+uint64_t align8(uint64_t v) { return (v + 7) & ~uint64_t(7); }
+
+uint64_t valueWidth(ColumnarWriter::Type type) {
+    switch (type) {
+    case ColumnarWriter::Type::UInt8:  return 1;
+    case ColumnarWriter::Type::Int32:
+    case ColumnarWriter::Type::UInt32: return 4;
+    case ColumnarWriter::Type::Utf8:   return 8; // Offsets
+    }
+    return 0;
+}
+
+} // namespace
+
+ColumnarWriter::ColumnarWriter(const std::string& path, uint64_t rows)
+    : out(path, std::ios::binary), rows(rows) {
+    buffer.reserve(kBufferSize);
+}
+
+void ColumnarWriter::addColumn(const std::string& name, Type type, uint64_t utf8Bytes) {
+    if (current > 0 || name.size() >= kNameSize) {
+        valid = false;
+        return;
+    }
+    uint64_t length = rows * valueWidth(type);
+    if (type == Type::Utf8) length += 8 + utf8Bytes;
+    columns.push_back({name, type, 0, length});
+}
+
+void ColumnarWriter::beginColumn() {
+    if (current == 0) {
+        uint64_t offset = align8(kHeaderSize + kDirectoryEntrySize * columns.size());
+        for (Column& c : columns) {
+            c.offset = offset;
+            offset = align8(offset + c.length);
+        }
+        buffer.insert(buffer.end(), "SCOAPCOL", "SCOAPCOL" + 8);
+        put(Version, 4);
+        put(columns.size(), 4);
+        put(rows, 8);
+        for (const Column& c : columns) {
+            char name[kNameSize] = {};
+            std::memcpy(name, c.name.data(), c.name.size());
+            putBytes(name, kNameSize);
+            put(static_cast<uint8_t>(c.type), 1);
+            put(0, 7);
+            put(c.offset, 8);
+            put(c.length, 8);
+        }
+    } else if (!columnComplete()) {
+        valid = false;
+    }
+    if (current >= columns.size()) {
+        valid = false;
+        return;
+    }
+    pad();
+    ++current;
+}
+
+void ColumnarWriter::putBytes(const char* data, size_t size) {
+    while (size > 0) {
+        const size_t n = std::min(size, kBufferSize - buffer.size());
+        buffer.insert(buffer.end(), data, data + n);
+        data += n;
+        size -= n;
+        if (buffer.size() == kBufferSize) flush();
+    }
+}
+
+bool ColumnarWriter::finish() {
+    if (current != columns.size() || (current > 0 && !columnComplete())) valid = false;
+    pad();
+    flush();
+    out.flush();
+    return valid && static_cast<bool>(out);
+}
+
+void ColumnarWriter::put(uint64_t v, int bytes) {
+    if (buffer.size() + bytes > kBufferSize) flush();
+    for (int i = 0; i < bytes; ++i) {
+        buffer.push_back(static_cast<char>(v & 0xff));
+        v >>= 8;
+    }
+}
+
+void ColumnarWriter::flush() {
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    written += buffer.size();
+    buffer.clear();
+}
+
+void ColumnarWriter::pad() {
+    while (position() % 8 != 0) put(0, 1);
+}
+
+bool ColumnarWriter::columnComplete() const {
+    const Column& c = columns[current - 1];
+    return position() == c.offset + c.length;
+}
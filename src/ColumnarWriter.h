@@ -0,0 +1,71 @@
+#ifndef COLUMNAR_WRITER_H
+#define COLUMNAR_WRITER_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Streams a table in the columnar layout of scoap_nets.col (see README,
+// "Columnar export"). All integers are little-endian:
+//
+//   header     "SCOAPCOL", uint32 version, uint32 columns, uint64 rows
+//   directory  per column: char[32] name (NUL-padded), uint8 type,
+//              7 bytes of padding, uint64 offset, uint64 length
+//   data       each column at its offset, aligned to 8 bytes
+//
+// Fixed-width columns hold one value per row. A Utf8 column holds rows + 1
+// uint64 offsets into its string bytes, followed by the bytes.
+//
+// All columns are declared up front, which fixes every offset, so the header
+// is written first and the values follow without being held in memory:
+// columns are written in declaration order, one value per row.
+class ColumnarWriter {
+public:
+    enum class Type : uint8_t { UInt8 = 1, Int32 = 2, UInt32 = 3, Utf8 = 4 };
+    static constexpr uint32_t Version = 1;
+
+    ColumnarWriter(const std::string& path, uint64_t rows);
+    bool isOpen() const { return static_cast<bool>(out); }
+
+    // Declares the next column. Utf8 columns need the total length of
+    // their strings.
+    void addColumn(const std::string& name, Type type, uint64_t utf8Bytes = 0);
+
+    // Starts the next declared column (the first call writes the header).
+    void beginColumn();
+    void putUInt8(uint8_t v) { put(v, 1); }
+    void putInt32(int32_t v) { put(static_cast<uint32_t>(v), 4); }
+    void putUInt32(uint32_t v) { put(v, 4); }
+    // Utf8 columns: the running offsets (0 first, then the end of each
+    // string), then the string bytes.
+    void putOffset(uint64_t v) { put(v, 8); }
+    void putBytes(const char* data, size_t size);
+
+    // Flushes the file. False if a write failed or a column did not get
+    // exactly its declared length.
+    bool finish();
+
+private:
+    struct Column {
+        std::string name;
+        Type type;
+        uint64_t offset, length;
+    };
+
+    void put(uint64_t v, int bytes);
+    void flush();
+    void pad();
+    uint64_t position() const { return written + buffer.size(); }
+    bool columnComplete() const;
+
+    std::ofstream out;
+    uint64_t rows;
+    std::vector<Column> columns;
+    size_t current = 0; // Columns begun so far
+    bool valid = true;
+    std::vector<char> buffer;
+    uint64_t written = 0;
+};
+
+#endif // COLUMNAR_WRITER_H
@@ -0,0 +1,346 @@
+#include "CompactNetlist.h"
+#include "CellLibrary.h"
+#include "GateKernels.h"
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <unordered_map>
+
+CompactNetlist CompactNetlist::build(
+    const std::vector<Gate>& gates,
+    const std::vector<FlipFlop>& flipflops,
+    const NetMap& nets,
+    const std::vector<NetName>& primaryOutputs,
+    const CellLibrary* cells
+) {
+    NetlistIds ids;
+
+    // Number the nets in map order.
+    std::unordered_map<NetName, int32_t> netId;
+    netId.reserve(nets.size());
+    ids.netLevel.reserve(nets.size());
+    ids.netFlags.reserve(nets.size());
+    for (const auto& pair : nets) {
+        const Net& net = pair.second;
+        uint8_t flags = 0;
+        if (net.type == "P") flags |= PrimaryInput;
+        if (net.drivenByFlipFlop) flags |= FlipFlopOutput;
+        if (net.clockNetwork) flags |= ClockNetwork;
+        netId.emplace(pair.first, static_cast<int32_t>(ids.netFlags.size()));
+        ids.netFlags.push_back(flags);
+        ids.netLevel.push_back(net.level);
+    }
+    for (const auto& poName : primaryOutputs) {
+        auto it = netId.find(poName);
+        if (it != netId.end()) ids.netFlags[it->second] |= PrimaryOutput;
+    }
+    auto lookup = [&](const NetName& name) {
+        auto it = netId.find(name);
+        return it == netId.end() ? -1 : it->second;
+    };
+
+    ids.gates.numNets = nets.size();
+    for (const Gate& gate : gates) {
+        GateType kind = gate.kind;
+        int32_t cell = -1;
+        if (kind == GateType::Unknown && cells) {
+            cell = cells->find(gate.type);
+            if (cell >= 0) kind = GateType::Cell;
+        }
+        ids.gates.kind.push_back(kind);
+        ids.gateCell.push_back(cell);
+        ids.gateLoop.push_back(gate.loop);
+        ids.gates.outputNet.push_back(lookup(gate.output));
+        for (const auto& inp : gate.inputs) ids.gates.inputNet.push_back(lookup(inp));
+        ids.gates.inputBegin.push_back(static_cast<uint32_t>(ids.gates.inputNet.size()));
+    }
+
+    for (const FlipFlop& ff : flipflops) {
+        int32_t in0 = -1, in1 = -1;
+        switch (ff.kind) {
+        case FlipFlopType::D:  in0 = lookup(ff.d); break;
+        case FlipFlopType::T:  in0 = lookup(ff.t); break;
+        case FlipFlopType::JK: in0 = lookup(ff.j); in1 = lookup(ff.k); break;
+        case FlipFlopType::SR: in0 = lookup(ff.s); in1 = lookup(ff.r); break;
+        case FlipFlopType::Unknown: break;
+        }
+        ids.ffType.push_back(ff.kind);
+        ids.ffClk.push_back(lookup(ff.clk));
+        ids.ffQ.push_back(lookup(ff.q));
+        ids.ffIn0.push_back(in0);
+        ids.ffIn1.push_back(in1);
+        ids.ffEn.push_back(lookup(ff.en));
+        ids.ffSet.push_back(lookup(ff.set));
+        ids.ffRst.push_back(lookup(ff.rst));
+    }
+
+    return assemble(std::move(ids), cells);
+}
+
+CompactNetlist CompactNetlist::assemble(NetlistIds&& ids, const CellLibrary* cells) {
+    CompactNetlist nl;
+    nl.cells = cells;
+    nl.netFlags = std::move(ids.netFlags);
+    nl.netPosition.resize(nl.netFlags.size());
+    for (size_t n = 0; n < nl.netPosition.size(); ++n) nl.netPosition[n] = static_cast<int32_t>(n);
+    const std::vector<int>& netLevel = ids.netLevel;
+    const GateGraph& graph = ids.gates;
+    auto inputs = [&](size_t g) { return graph.inputBegin[g + 1] - graph.inputBegin[g]; };
+
+    // Single-input buffers and inverters between two clock network nets form
+    // the clock trees; every other gate is evaluated in batches.
+    std::vector<size_t> order;
+    std::vector<size_t> treeGates;
+    order.reserve(graph.numGates());
+    std::vector<int32_t> gatesDriving(nl.numNets(), 0);
+    for (size_t i = 0; i < graph.numGates(); ++i) {
+        const int32_t out = graph.outputNet[i];
+        if (out < 0) continue;
+        ++gatesDriving[out];
+        const GateType kind = graph.kind[i];
+        if ((kind == GateType::Buf || kind == GateType::Not) && inputs(i) == 1 && (nl.netFlags[out] & ClockNetwork)) {
+            const int32_t in = graph.inputNet[graph.inputBegin[i]];
+            if (in >= 0 && (nl.netFlags[in] & ClockNetwork)) {
+                treeGates.push_back(i);
+                continue;
+            }
+        }
+        order.push_back(i);
+    }
+
+    // Clock tree edges from the roots down. A net is fixed if it is a root
+    // driven neither by a gate nor by a flip-flop, or has a single driver
+    // from a fixed net.
+    for (size_t n = 0; n < nl.netFlags.size(); ++n) {
+        if ((nl.netFlags[n] & ClockNetwork) && gatesDriving[n] == 0 && !(nl.netFlags[n] & FlipFlopOutput)) {
+            nl.netFlags[n] |= FixedControl;
+        }
+    }
+    std::stable_sort(treeGates.begin(), treeGates.end(), [&](size_t a, size_t b) {
+        return netLevel[graph.outputNet[a]] < netLevel[graph.outputNet[b]];
+    });
+    for (size_t i : treeGates) {
+        const int32_t out = graph.outputNet[i], in = graph.inputNet[graph.inputBegin[i]];
+        const bool fixed = nl.netFlags[in] & FixedControl;
+        if (fixed && gatesDriving[out] == 1) nl.netFlags[out] |= FixedControl;
+        nl.clockTree.push_back({out, in, graph.kind[i] == GateType::Not, fixed});
+    }
+
+    // Order the gates by the level of their output net, then by loop, type and arity.
+    std::vector<int> gateLevel(graph.numGates(), -1);
+    std::vector<uint8_t> gateArity(graph.numGates(), 0);
+    for (size_t i : order) {
+        gateLevel[i] = netLevel[graph.outputNet[i]];
+        size_t connected = 0;
+        for (uint32_t p = graph.inputBegin[i]; p < graph.inputBegin[i + 1]; ++p) connected += graph.inputNet[p] >= 0;
+        gateArity[i] = arityClass(connected);
+    }
+    const std::vector<int>& gateLoop = ids.gateLoop;
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        if (gateLevel[a] != gateLevel[b]) return gateLevel[a] < gateLevel[b];
+        if (gateLoop[a] != gateLoop[b]) return gateLoop[a] < gateLoop[b];
+        if (graph.kind[a] != graph.kind[b]) return graph.kind[a] < graph.kind[b];
+        return gateArity[a] < gateArity[b];
+    });
+
+    nl.gateType.reserve(order.size());
+    nl.gateOutput.reserve(order.size());
+    nl.gateInputBegin.reserve(order.size() + 1);
+    nl.gateInputBegin.push_back(0);
+    int batchLevel = 0;
+    for (size_t i : order) {
+        const uint32_t index = static_cast<uint32_t>(nl.gateType.size());
+        const GateType kind = graph.kind[i];
+        nl.gateType.push_back(kind);
+        nl.gateCell.push_back(ids.gateCell[i]);
+        nl.gateSource.push_back(static_cast<int32_t>(i));
+        nl.gateOutput.push_back(graph.outputNet[i]);
+        for (uint32_t p = graph.inputBegin[i]; p < graph.inputBegin[i + 1]; ++p) {
+            if (graph.inputNet[p] >= 0) nl.gateInputs.push_back(graph.inputNet[p]);
+        }
+        nl.gateInputBegin.push_back(static_cast<uint32_t>(nl.gateInputs.size()));
+
+        // Cells without inputs (tie cells) still drive a constant.
+        if (kind != GateType::Cell && nl.gateInputBegin[index] == nl.gateInputBegin[index + 1]) continue;
+        GateBatch* last = nl.batches.empty() ? nullptr : &nl.batches.back();
+        if (last && last->end == index && batchLevel == gateLevel[i] && last->loop == gateLoop[i]
+            && last->type == kind && last->arity == gateArity[i]) {
+            last->end = index + 1;
+        } else {
+            nl.batches.push_back({kind, gateArity[i], index, index + 1, gateLoop[i]});
+            batchLevel = gateLevel[i];
+        }
+    }
+
+    // Renumber the loops in batch order.
+    std::unordered_map<int32_t, int32_t> loopId;
+    for (uint32_t b = 0; b < nl.batches.size(); ++b) {
+        GateBatch& batch = nl.batches[b];
+        if (batch.loop < 0) continue;
+        auto inserted = loopId.emplace(batch.loop, static_cast<int32_t>(nl.loops.size()));
+        if (inserted.second) nl.loops.push_back({b, b, 0});
+        batch.loop = inserted.first->second;
+        GateLoop& loop = nl.loops[batch.loop];
+        loop.batchEnd = b + 1;
+        loop.numGates += batch.end - batch.begin;
+    }
+
+    for (size_t i = 0; i < ids.ffType.size(); ++i) {
+        const int32_t in0 = ids.ffIn0[i], in1 = ids.ffIn1[i];
+        bool connected = true;
+        switch (ids.ffType[i]) {
+        case FlipFlopType::D:
+        case FlipFlopType::T:  connected = in0 >= 0; break;
+        case FlipFlopType::JK:
+        case FlipFlopType::SR: connected = in0 >= 0 && in1 >= 0; break;
+        case FlipFlopType::Unknown: connected = false; break;
+        }
+        if (!connected || ids.ffClk[i] < 0 || ids.ffQ[i] < 0) continue;
+        nl.ffType.push_back(ids.ffType[i]);
+        nl.ffClk.push_back(ids.ffClk[i]);
+        nl.ffQ.push_back(ids.ffQ[i]);
+        nl.ffIn0.push_back(in0);
+        nl.ffIn1.push_back(in1);
+        nl.ffEn.push_back(ids.ffEn[i]);
+        nl.ffSet.push_back(ids.ffSet[i]);
+        nl.ffRst.push_back(ids.ffRst[i]);
+        nl.ffSource.push_back(static_cast<int32_t>(i));
+    }
+
+    return nl;
+}
+
+void CompactNetlist::reorderForLocality() {
+    std::vector<int32_t> newId(numNets(), -1);
+    int32_t next = 0;
+    auto number = [&](int32_t n) {
+        if (n >= 0 && newId[n] < 0) newId[n] = next++;
+    };
+    std::vector<uint8_t> drivers(numNets(), 0);
+    for (const GateBatch& b : batches) {
+        for (uint32_t g = b.begin; g < b.end; ++g) drivers[gateOutput[g]] = std::min(drivers[gateOutput[g]] + 1, 2);
+    }
+    for (const ClockTreeEdge& e : clockTree) drivers[e.net] = std::min(drivers[e.net] + 1, 2);
+
+    // New gate order: batches sorted by lowest input, other gates in place.
+    // Batches driving a net with several drivers keep their order, since the
+    // last driver's value wins.
+    std::vector<uint32_t> order(numGates());
+    for (uint32_t g = 0; g < numGates(); ++g) order[g] = g;
+    std::vector<int32_t> key(numGates(), 0);
+    for (const GateBatch& b : batches) {
+        bool sortable = true;
+        for (uint32_t g = b.begin; g < b.end; ++g) {
+            int32_t lowest = INT32_MAX;
+            for (uint32_t i = gateInputBegin[g]; i < gateInputBegin[g + 1]; ++i) {
+                const int32_t in = gateInputs[i];
+                if (!drivers[in]) number(in);
+                if (newId[in] >= 0) lowest = std::min(lowest, newId[in]);
+            }
+            key[g] = lowest;
+            sortable &= drivers[gateOutput[g]] == 1;
+        }
+        if (sortable) {
+            std::stable_sort(order.begin() + b.begin, order.begin() + b.end,
+                             [&](uint32_t x, uint32_t y) { return key[x] < key[y]; });
+        }
+        for (uint32_t g = b.begin; g < b.end; ++g) number(gateOutput[order[g]]);
+    }
+    for (const ClockTreeEdge& e : clockTree) {
+        number(e.parent);
+        number(e.net);
+    }
+    for (size_t f = 0; f < numFlipFlops(); ++f) {
+        for (int32_t n : {ffClk[f], ffQ[f], ffIn0[f], ffIn1[f], ffEn[f], ffSet[f], ffRst[f]}) number(n);
+    }
+    for (size_t n = 0; n < numNets(); ++n) number(static_cast<int32_t>(n));
+
+    // Apply both permutations.
+    std::vector<uint8_t> flags(numNets());
+    std::vector<int32_t> position(numNets());
+    for (size_t n = 0; n < numNets(); ++n) {
+        flags[newId[n]] = netFlags[n];
+        position[newId[n]] = netPosition[n];
+    }
+    netFlags.swap(flags);
+    netPosition.swap(position);
+
+    std::vector<GateType> types(numGates());
+    std::vector<int32_t> outputs(numGates()), cellIds(numGates()), sources(gateSource.size());
+    std::vector<uint32_t> inputBegin;
+    std::vector<int32_t> inputs;
+    inputBegin.reserve(numGates() + 1);
+    inputs.reserve(gateInputs.size());
+    inputBegin.push_back(0);
+    for (uint32_t g = 0; g < numGates(); ++g) {
+        const uint32_t old = order[g];
+        types[g] = gateType[old];
+        outputs[g] = newId[gateOutput[old]];
+        cellIds[g] = gateCell[old];
+        if (!sources.empty()) sources[g] = gateSource[old];
+        for (uint32_t i = gateInputBegin[old]; i < gateInputBegin[old + 1]; ++i) inputs.push_back(newId[gateInputs[i]]);
+        inputBegin.push_back(static_cast<uint32_t>(inputs.size()));
+    }
+    gateType.swap(types);
+    gateOutput.swap(outputs);
+    gateCell.swap(cellIds);
+    gateSource.swap(sources);
+    gateInputBegin.swap(inputBegin);
+    gateInputs.swap(inputs);
+
+    for (ClockTreeEdge& e : clockTree) {
+        e.net = newId[e.net];
+        e.parent = newId[e.parent];
+    }
+    for (auto* pins : {&ffClk, &ffQ, &ffIn0, &ffIn1, &ffEn, &ffSet, &ffRst}) {
+        for (int32_t& n : *pins) {
+            if (n >= 0) n = newId[n];
+        }
+    }
+}
+
+const CellRule* CompactNetlist::cellRule(size_t gate) const {
+    return gateCell[gate] >= 0 ? &cells->rule(gateCell[gate]) : nullptr;
+}
+
+namespace {
+
+template <typename V>
+size_t arrayBytes(const V& v) {
+    return v.capacity() * sizeof(typename V::value_type);
+}
+
+} // namespace
+
+size_t CompactNetlist::memoryBytes() const {
+    return arrayBytes(netFlags) + arrayBytes(netPosition) + arrayBytes(gateType) + arrayBytes(gateOutput)
+         + arrayBytes(gateInputBegin) + arrayBytes(gateInputs) + arrayBytes(gateCell) + arrayBytes(gateSource)
+         + arrayBytes(batches) + arrayBytes(loops) + arrayBytes(clockTree) + arrayBytes(ffType) + arrayBytes(ffClk)
+         + arrayBytes(ffQ) + arrayBytes(ffIn0) + arrayBytes(ffIn1) + arrayBytes(ffEn) + arrayBytes(ffSet)
+         + arrayBytes(ffRst) + arrayBytes(ffSource);
+}
+
+void CompactNetlist::applyScan(const std::vector<uint8_t>& scanned) {
+    size_t kept = 0;
+    for (size_t f = 0; f < numFlipFlops(); ++f) {
+        const size_t source = static_cast<size_t>(ffSource[f]);
+        if (source < scanned.size() && scanned[source]) {
+            netFlags[ffQ[f]] |= PseudoInput;
+            netFlags[ffIn0[f]] |= PseudoOutput;
+            if (ffIn1[f] >= 0) netFlags[ffIn1[f]] |= PseudoOutput;
+            continue;
+        }
+        ffType[kept] = ffType[f];
+        ffClk[kept] = ffClk[f];
+        ffQ[kept] = ffQ[f];
+        ffIn0[kept] = ffIn0[f];
+        ffIn1[kept] = ffIn1[f];
+        ffEn[kept] = ffEn[f];
+        ffSet[kept] = ffSet[f];
+        ffRst[kept] = ffRst[f];
+        ffSource[kept] = ffSource[f];
+        ++kept;
+    }
+    for (auto* v : {&ffClk, &ffQ, &ffIn0, &ffIn1, &ffEn, &ffSet, &ffRst, &ffSource}) v->resize(kept);
+    ffType.resize(kept);
+}
@@ -0,0 +1,139 @@
+#ifndef COMPACT_NETLIST_H
+#define COMPACT_NETLIST_H
+
+#include "DataStructures.h"
+#include "GateGraph.h"
+
+class CellLibrary;
+struct CellRule;
+
+// A run of consecutive gates (in evaluation order) that share a level, a gate
+// type and an arity class, so that each batch is evaluated by a single
+// specialized kernel loop. arity is 1..4, or 0 for wider gates. loop is the
+// combinational loop the gates belong to, or -1.
+struct GateBatch {
+    GateType type;
+    uint8_t arity;
+    uint32_t begin, end;
+    int32_t loop;
+};
+
+// The gates of one combinational loop (a strongly connected component of the
+// gate graph). They share a level and fill the consecutive batches
+// [batchBegin, batchEnd), which are evaluated to a local fixpoint.
+struct GateLoop {
+    uint32_t batchBegin, batchEnd;
+    uint32_t numGates;
+};
+
+// One buffer or inverter of a clock/reset network: net is driven from parent.
+// Nets of a network rooted at a primary input or an undriven net are fixed:
+// their values do not depend on the data path.
+struct ClockTreeEdge {
+    int32_t net, parent;
+    bool inverted;
+    bool fixed;
+};
+
+// A netlist in net ids 0 .. numNets - 1, from which the compact form is
+// assembled. Pins that are not connected to a net are -1.
+struct NetlistIds {
+    std::vector<uint8_t> netFlags; // PrimaryInput, PrimaryOutput, FlipFlopOutput and ClockNetwork
+    std::vector<int> netLevel;
+    GateGraph gates;               // Library cells are GateType::Cell
+    std::vector<int32_t> gateCell; // CellLibrary rule id, or -1
+    std::vector<int> gateLoop;     // Combinational loop, or -1
+    // Flip-flops; ffIn0/ffIn1 are the data pins of the type as in CompactNetlist.
+    std::vector<FlipFlopType> ffType;
+    std::vector<int32_t> ffClk, ffQ, ffIn0, ffIn1;
+    std::vector<int32_t> ffEn, ffSet, ffRst;
+};
+
+// A flat, integer-indexed snapshot of the circuit used by the SCOAP engine.
+//
+// Net ids start out in the iteration order of Circuit's net map;
+// netPosition keeps the map position of each id, so results can be written
+// back after reorderForLocality() has renumbered the nets. Gates are
+// stored in evaluation order (ascending output level, grouped into batches
+// within a level) with their inputs in CSR form: the inputs of gate g are
+// gateInputs[gateInputBegin[g] .. gateInputBegin[g + 1]). Within a level the
+// gates of each combinational loop come after the acyclic gates, one loop
+// after the other.
+struct CompactNetlist {
+    // Bits of netFlags.
+    enum : uint8_t {
+        PrimaryInput   = 1 << 0,
+        PrimaryOutput  = 1 << 1,
+        FlipFlopOutput = 1 << 2,
+        ClockNetwork   = 1 << 3, // Feeds only flip-flop clock/set/reset pins
+        FixedControl   = 1 << 4, // Clock network net with a fixed value (see ClockTreeEdge)
+        PseudoInput    = 1 << 5, // Q of a scanned flip-flop
+        PseudoOutput   = 1 << 6, // Data pin of a scanned flip-flop
+    };
+
+    // Per-net data.
+    std::vector<uint8_t> netFlags;
+    std::vector<int32_t> netPosition; // Position in the net map
+
+    // Per-gate data, in evaluation order.
+    std::vector<GateType> gateType;
+    std::vector<int32_t> gateOutput;
+    std::vector<uint32_t> gateInputBegin; // numGates() + 1 entries
+    std::vector<int32_t> gateInputs;
+    std::vector<int32_t> gateCell;  // CellLibrary rule id, or -1 for primitives
+    std::vector<int32_t> gateSource; // Index into the gates passed to build()
+    std::vector<GateBatch> batches; // Primitives without inputs are in no batch.
+    std::vector<GateLoop> loops;    // Indexed by GateBatch::loop
+
+    // Buffers and inverters inside clock/reset networks, in topological
+    // order. They are not part of the gate arrays: the SCOAP engine
+    // propagates along these edges separately, and only once for fixed nets.
+    std::vector<ClockTreeEdge> clockTree;
+
+    // Rules of the GateType::Cell gates; must outlive the netlist.
+    const CellLibrary* cells = nullptr;
+
+    // Flip-flops whose clock, Q and data ports are connected. ffIn0/ffIn1
+    // are the data pins of the type (d | t | j, k | s, r); unused and
+    // unconnected optional pins are -1.
+    std::vector<FlipFlopType> ffType;
+    std::vector<int32_t> ffClk, ffQ, ffIn0, ffIn1;
+    std::vector<int32_t> ffEn, ffSet, ffRst;
+    std::vector<int32_t> ffSource; // Index into the flipflops passed to build()
+
+    size_t numNets() const { return netFlags.size(); }
+    size_t numGates() const { return gateType.size(); }
+    size_t numFlipFlops() const { return ffQ.size(); }
+    const CellRule* cellRule(size_t gate) const;
+    // Bytes held by the arrays.
+    size_t memoryBytes() const;
+
+    // Turns flip-flops into scan cells. Every flip-flop whose build() index
+    // is marked in `scanned` is removed from the flip-flop arrays; its Q
+    // becomes a pseudo primary input and its data pins (d | t | j, k | s, r)
+    // become pseudo primary outputs.
+    void applyScan(const std::vector<uint8_t>& scanned);
+
+    // Renumbers the nets in the order the passes first touch them: sources
+    // when first read, gate outputs in gate order, and within each batch
+    // sorts the gates by their lowest input id. The metric arrays are then
+    // read and written mostly sequentially instead of in name order.
+    void reorderForLocality();
+
+    // Builds the compact form. Net levels and gate loops must already be
+    // assigned. Gates whose type is not a primitive are looked up in `cells`.
+    static CompactNetlist build(
+        const std::vector<Gate>& gates,
+        const std::vector<FlipFlop>& flipflops,
+        const NetMap& nets,
+        const std::vector<NetName>& primaryOutputs,
+        const CellLibrary* cells = nullptr
+    );
+
+    // Builds the compact form from net ids, which become the net ids and
+    // positions of the netlist. gateSource and ffSource index the gates and
+    // flip-flops of `ids`. Used by build() and CompactNetlistBuilder.
+    static CompactNetlist assemble(NetlistIds&& ids, const CellLibrary* cells = nullptr);
+};
+
+#endif // COMPACT_NETLIST_H
@@ -0,0 +1,127 @@
+#include "CompactNetlistBuilder.h"
+#include "CellLibrary.h"
+#include <algorithm>
+#include <numeric>
+
+int32_t CompactNetlistBuilder::netId(const NetName& name) {
+    auto inserted = ids.emplace(name, static_cast<int32_t>(names.size()));
+    if (inserted.second) {
+        names.push_back(name);
+        portType.push_back(0);
+        primaryOutput.push_back(0);
+        ffOutput.push_back(0);
+        controlUse.push_back(0);
+        dataUse.push_back(0);
+    }
+    return inserted.first->second;
+}
+
+void CompactNetlistBuilder::onNet(const NetName& name, const VerilogParser::BusRange* range) {
+    if (!range) netId(name);
+}
+
+void CompactNetlistBuilder::onPort(const NetName& name, VerilogParser::PortDirection direction) {
+    const int32_t id = netId(name);
+    if (direction == VerilogParser::PortDirection::Input) {
+        portType[id] = 'P';
+    } else {
+        portType[id] = 'O';
+        primaryOutput[id] = 1;
+    }
+}
+
+void CompactNetlistBuilder::onGate(Gate&& gate) {
+    GateType kind = gate.kind;
+    int32_t cell = -1;
+    if (kind == GateType::Unknown && cells) {
+        cell = cells->find(gate.type);
+        if (cell >= 0) kind = GateType::Cell;
+    }
+    GateGraph& graph = netlist.gates;
+    graph.kind.push_back(kind);
+    graph.outputNet.push_back(netId(gate.output));
+    for (const auto& inp : gate.inputs) graph.inputNet.push_back(netId(inp));
+    graph.inputBegin.push_back(static_cast<uint32_t>(graph.inputNet.size()));
+    netlist.gateCell.push_back(cell);
+}
+
+void CompactNetlistBuilder::onFlipFlop(FlipFlop&& ff) {
+    auto pin = [&](const NetName& name) { return name.empty() ? -1 : netId(name); };
+    const int32_t clk = pin(ff.clk), q = pin(ff.q);
+    const int32_t d = pin(ff.d), t = pin(ff.t), j = pin(ff.j), k = pin(ff.k), s = pin(ff.s), r = pin(ff.r);
+    const int32_t en = pin(ff.en), set = pin(ff.set), rst = pin(ff.rst);
+    for (int32_t n : {clk, set, rst}) {
+        if (n >= 0) controlUse[n] = 1;
+    }
+    for (int32_t n : {d, t, j, k, s, r, en}) {
+        if (n >= 0) dataUse[n] = 1;
+    }
+    if (q >= 0) ffOutput[q] = 1;
+
+    int32_t in0 = -1, in1 = -1;
+    switch (ff.kind) {
+    case FlipFlopType::D:  in0 = d; break;
+    case FlipFlopType::T:  in0 = t; break;
+    case FlipFlopType::JK: in0 = j; in1 = k; break;
+    case FlipFlopType::SR: in0 = s; in1 = r; break;
+    case FlipFlopType::Unknown: break;
+    }
+    netlist.ffType.push_back(ff.kind);
+    netlist.ffClk.push_back(clk);
+    netlist.ffQ.push_back(q);
+    netlist.ffIn0.push_back(in0);
+    netlist.ffIn1.push_back(in1);
+    netlist.ffEn.push_back(en);
+    netlist.ffSet.push_back(set);
+    netlist.ffRst.push_back(rst);
+    ffNames.push_back(std::move(ff.name));
+}
+
+CompactNetlist CompactNetlistBuilder::finish(ThreadPool& pool) {
+    // Renumber the nets into name order, the order of Circuit's net map.
+    const size_t numNets = names.size();
+    std::vector<int32_t> order(numNets), newId(numNets);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](int32_t a, int32_t b) { return names[a] < names[b]; });
+    for (size_t n = 0; n < numNets; ++n) newId[order[n]] = static_cast<int32_t>(n);
+    auto permute = [&](auto& values) {
+        std::remove_reference_t<decltype(values)> sorted(numNets);
+        for (size_t n = 0; n < numNets; ++n) sorted[n] = std::move(values[order[n]]);
+        values.swap(sorted);
+    };
+    permute(names);
+    permute(portType);
+    permute(primaryOutput);
+    permute(ffOutput);
+    permute(controlUse);
+    permute(dataUse);
+    GateGraph& graph = netlist.gates;
+    graph.numNets = numNets;
+    for (auto* pins : {&graph.inputNet, &graph.outputNet, &netlist.ffClk, &netlist.ffQ, &netlist.ffIn0,
+                       &netlist.ffIn1, &netlist.ffEn, &netlist.ffSet, &netlist.ffRst}) {
+        for (int32_t& n : *pins) {
+            if (n >= 0) n = newId[n];
+        }
+    }
+    ids.clear();
+
+    GateLevels levels = levelizeGates(graph, pool);
+    netlist.netLevel = std::move(levels.netLevel);
+    netlist.gateLoop = std::move(levels.gateLoop);
+    numLoops = levels.numLoops;
+
+    std::vector<uint8_t> excluded(numNets);
+    for (size_t n = 0; n < numNets; ++n) excluded[n] = portType[n] == 'O' || dataUse[n];
+    size_t buffers = 0;
+    const std::vector<uint8_t> clock = findClockNetworks(graph, netlist.netLevel, excluded, controlUse, buffers);
+
+    netlist.netFlags.assign(numNets, 0);
+    for (size_t n = 0; n < numNets; ++n) {
+        uint8_t& flags = netlist.netFlags[n];
+        if (portType[n] == 'P') flags |= CompactNetlist::PrimaryInput;
+        if (primaryOutput[n]) flags |= CompactNetlist::PrimaryOutput;
+        if (ffOutput[n]) flags |= CompactNetlist::FlipFlopOutput;
+        if (clock[n]) flags |= CompactNetlist::ClockNetwork;
+    }
+    return CompactNetlist::assemble(std::move(netlist), cells);
+}
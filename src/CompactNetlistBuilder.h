@@ -0,0 +1,60 @@
+#ifndef COMPACT_NETLIST_BUILDER_H
+#define COMPACT_NETLIST_BUILDER_H
+
+#include "CompactNetlist.h"
+#include "VerilogParser.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Builds a CompactNetlist directly from the statements of the parser,
+// without the gate and flip-flop vectors and the net map of Circuit. Nets
+// are numbered as they first appear and gates are kept as net ids only;
+// finish() then levelizes the gates, marks the clock and reset networks and
+// assembles the netlist exactly as Circuit would. Net ids are renumbered
+// into net name order first, so netPosition is the position in Circuit's
+// net map and indexes netNames().
+//
+//   CompactNetlistBuilder builder(&cells);
+//   VerilogParser::parseFile("design.v.gz", builder);
+//   CompactNetlist netlist = builder.finish();
+class CompactNetlistBuilder : public VerilogParser::Listener {
+public:
+    // Gates whose type is not a primitive are looked up in `cells`, which
+    // must outlive the netlist.
+    explicit CompactNetlistBuilder(const CellLibrary* cells = nullptr) : cells(cells) {}
+
+    void onNet(const NetName& name, const VerilogParser::BusRange* range) override;
+    void onPort(const NetName& name, VerilogParser::PortDirection direction) override;
+    void onGate(Gate&& gate) override;
+    void onFlipFlop(FlipFlop&& ff) override;
+
+    // Assembles the netlist once the whole file is parsed, levelizing on the
+    // threads of `pool`. Call it once.
+    CompactNetlist finish(ThreadPool& pool = ThreadPool::shared());
+
+    // The net names by net position (in name order once finished).
+    const std::vector<NetName>& netNames() const { return names; }
+    // The flip-flop instance names, indexed by CompactNetlist::ffSource and
+    // by the mask of applyScan().
+    const std::vector<std::string>& flipFlopNames() const { return ffNames; }
+    // The number of combinational loops found by finish().
+    int numCombinationalLoops() const { return numLoops; }
+
+private:
+    int32_t netId(const NetName& name);
+
+    const CellLibrary* cells;
+    std::unordered_map<NetName, int32_t> ids;
+    std::vector<NetName> names;
+    std::vector<char> portType;         // 'P', 'O', or 0 (the last port statement wins)
+    std::vector<uint8_t> primaryOutput; // Listed as an output port
+    std::vector<uint8_t> ffOutput;      // Q of a flip-flop
+    std::vector<uint8_t> controlUse;    // Clock, set or reset pin of a flip-flop
+    std::vector<uint8_t> dataUse;       // Any other flip-flop pin
+    NetlistIds netlist;
+    std::vector<std::string> ffNames;
+    int numLoops = 0;
+};
+
+#endif // COMPACT_NETLIST_BUILDER_H
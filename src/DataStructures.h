@@ -1,47 +1,78 @@
-#ifndef DATA_STRUCTURES_H
-#define DATA_STRUCTURES_H
-
-#include <string>
-#include <vector>
-#include <limits>
-#include <map>
-#include <set>
-
-// A constant representing infinity for SCOAP calculations.
-constexpr int INF = std::numeric_limits<int>::max() / 2;
-
-// Represents a combinational logic gate.
-struct Gate {
-    std::string name;
-    std::string type;
-    std::vector<std::string> inputs;
-    std::string output;
-    int level = -1;
-};
-
-// Represents a sequential element (D, T, JK, or SR flip-flop).
-struct FlipFlop {
-    std::string type;    // "dff", "tff", "jkff", or "srff"
-    std::string name;
-    // Port nets (strings of net names). Unused ports remain empty.
-    std::string clk, q, d, t, j, k, s, r;
-};
-
-// Represents a signal/net in the circuit.
-struct Net {
-    std::string name;
-    std::string type; // "P" for primary input, "O" for primary output, "" for internal wire.
-    std::vector<std::string> drivers; // Gates that drive this net.
-    std::vector<std::string> loads;   // Gates that this net is an input to.
-    int level = -1; // Topological level.
-
-    // SCOAP Metrics
-    int cc0 = INF, cc1 = INF; // Combinational Controllability
-    int sc0 = INF, sc1 = INF; // Sequential Controllability
-    int co = INF;             // Combinational Observability
-    int so = INF;             // Sequential Observability
-
-    bool drivenByFlipFlop = false; // True if the net is a flip-flop's Q output.
-};
-
-#endif // DATA_STRUCTURES_H
+#ifndef DATA_STRUCTURES_H
+#define DATA_STRUCTURES_H
+
+#include "NetName.h"
+#include <string>
+#include <vector>
+#include <limits>
+#include <map>
+#include <set>
+#include <cstdint>
+
+// A constant representing infinity for SCOAP calculations.
+constexpr int INF = std::numeric_limits<int>::max() / 2;
+
+// Gate functions understood by the SCOAP engine. Cell stands for a complex
+// cell whose rules come from a CellLibrary.
+enum class GateType : uint8_t { And, Nand, Or, Nor, Xor, Xnor, Not, Buf, Cell, Unknown };
+
+// Maps a Verilog primitive name to its GateType.
+inline GateType gateTypeFromString(const std::string& type) {
+    if (type == "and")  return GateType::And;
+    if (type == "nand") return GateType::Nand;
+    if (type == "or")   return GateType::Or;
+    if (type == "nor")  return GateType::Nor;
+    if (type == "xor")  return GateType::Xor;
+    if (type == "xnor") return GateType::Xnor;
+    if (type == "not")  return GateType::Not;
+    if (type == "buf")  return GateType::Buf;
+    return GateType::Unknown;
+}
+
+// Represents a combinational logic gate.
+struct Gate {
+    std::string name;
+    std::string type;
+    GateType kind = GateType::Unknown; // Resolved from `type` by the parser.
+    std::vector<NetName> inputs;
+    NetName output;
+    int level = -1;
+    int loop = -1; // Index of the combinational loop the gate belongs to, or -1.
+};
+
+// Flip-flop behaviours understood by the SCOAP engine.
+enum class FlipFlopType : uint8_t { D, T, JK, SR, Unknown };
+
+// Represents a sequential element (D, T, JK, or SR flip-flop).
+struct FlipFlop {
+    std::string type;    // "dff", "tff", "jkff", or "srff", optionally suffixed (see VerilogParser)
+    FlipFlopType kind = FlipFlopType::Unknown; // Resolved from `type` by the parser.
+    std::string name;
+    // Port nets. Unused ports remain empty.
+    NetName clk, q, d, t, j, k, s, r;
+    // Optional clock enable and active-high asynchronous set/reset.
+    NetName en, set, rst;
+};
+
+// Represents a signal/net in the circuit.
+struct Net {
+    NetName name;
+    std::string type; // "P" for primary input, "O" for primary output, "" for internal wire.
+    std::vector<std::string> drivers; // Gates that drive this net.
+    std::vector<std::string> loads;   // Gates that this net is an input to.
+    int level = -1; // Topological level.
+
+    // SCOAP Metrics
+    int cc0 = INF, cc1 = INF; // Combinational Controllability
+    int sc0 = INF, sc1 = INF; // Sequential Controllability
+    int co = INF;             // Combinational Observability
+    int so = INF;             // Sequential Observability
+
+    bool drivenByFlipFlop = false; // True if the net is a flip-flop's Q output.
+    bool clockNetwork = false;     // True if the net only feeds flip-flop clock/set/reset pins, possibly through buffers.
+};
+
+// The nets of a circuit, ordered by the text of their names.
+using NetMap = std::map<NetName, Net>;
+
+#endif // DATA_STRUCTURES_H
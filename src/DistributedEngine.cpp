@@ -0,0 +1,510 @@
+#include "DistributedEngine.h"
+#include "GateKernels.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <new>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+
+#ifndef _WIN32
+#include <csignal>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <fstream>
+#include <sched.h>
+#include <sstream>
+#endif
+
+namespace {
+
+// Lowers a shared value to v. Returns true if it changed.
+template <typename T>
+bool lower(std::atomic<T>& value, T v) {
+    T current = value.load(std::memory_order_relaxed);
+    while (v < current) {
+        if (value.compare_exchange_weak(current, v, std::memory_order_relaxed)) return true;
+    }
+    return false;
+}
+
+size_t roundUp(size_t bytes) {
+    return (bytes + 63) / 64 * 64;
+}
+
+#ifdef __linux__
+// Restricts the calling process to the CPUs of NUMA node `index` modulo the
+// number of nodes. Does nothing on single-node machines.
+void bindToNumaNode(int index) {
+    std::vector<std::string> cpuLists;
+    for (int node = 0;; ++node) {
+        std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        std::string list;
+        if (!file || !std::getline(file, list)) break;
+        cpuLists.push_back(list);
+    }
+    if (cpuLists.size() < 2) return;
+
+    // A cpulist reads like "0-3,8-11".
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    std::istringstream ranges(cpuLists[index % cpuLists.size()]);
+    std::string range;
+    while (std::getline(ranges, range, ',')) {
+        const size_t dash = range.find('-');
+        const int first = std::stoi(range.substr(0, dash));
+        const int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (int cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu) CPU_SET(cpu, &set);
+    }
+    sched_setaffinity(0, sizeof(set), &set);
+}
+#endif
+
+} // namespace
+
+template <typename T>
+DistributedEngine<T>::DistributedEngine(const CompactNetlist& netlist, int workers) : nl(netlist) {
+    static_assert(std::atomic<T>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+                  "shared metrics need lock-free atomics");
+    partition(std::max(workers, 1));
+
+    const size_t nB = boundaryNl.numNets();
+    const size_t controlBytes = roundUp(sizeof(Control));
+    const size_t boundaryBytes = roundUp(NumMetrics * nB * sizeof(std::atomic<T>));
+    region = MappedRange::anonymous(controlBytes + boundaryBytes + NumMetrics * nl.numNets() * sizeof(T));
+    control = new (region.data()) Control();
+    boundaryValues = reinterpret_cast<std::atomic<T>*>(region.data() + controlBytes);
+    for (size_t i = 0; i < NumMetrics * nB; ++i) new (&boundaryValues[i]) std::atomic<T>(M::INF);
+    results = reinterpret_cast<T*>(region.data() + controlBytes + boundaryBytes);
+}
+
+template <typename T>
+DistributedEngine<T>::~DistributedEngine() {
+    stopWorkers();
+}
+
+// Assigns gates and clock tree edges to partitions (see the class comment)
+// and finds the boundary nets.
+template <typename T>
+void DistributedEngine<T>::partition(int workers) {
+    const size_t numGates = nl.numGates();
+    const size_t total = numGates + nl.clockTree.size();
+
+    // Group gates that must stay together: drivers of one net, gates of one loop.
+    std::vector<int32_t> group(total);
+    std::iota(group.begin(), group.end(), 0);
+    auto find = [&](int32_t x) {
+        while (group[x] != x) x = group[x] = group[group[x]];
+        return x;
+    };
+    auto unite = [&](int32_t a, int32_t b) { group[find(a)] = find(b); };
+    std::vector<int32_t> firstDriver(nl.numNets(), -1);
+    std::vector<int32_t> loopGate(nl.loops.size(), -1);
+    auto join = [&](int32_t g, int32_t out, int32_t loop) {
+        if (firstDriver[out] < 0) firstDriver[out] = g;
+        else unite(g, firstDriver[out]);
+        if (loop >= 0) {
+            if (loopGate[loop] < 0) loopGate[loop] = g;
+            else unite(g, loopGate[loop]);
+        }
+    };
+    for (const GateBatch& b : nl.batches) {
+        for (uint32_t g = b.begin; g < b.end; ++g) join(static_cast<int32_t>(g), nl.gateOutput[g], b.loop);
+    }
+    for (size_t e = 0; e < nl.clockTree.size(); ++e) join(static_cast<int32_t>(numGates + e), nl.clockTree[e].net, -1);
+
+    std::vector<size_t> groupSize(total, 0);
+    size_t counted = 0;
+    for (const GateBatch& b : nl.batches) {
+        for (uint32_t g = b.begin; g < b.end; ++g, ++counted) ++groupSize[find(static_cast<int32_t>(g))];
+    }
+    for (size_t e = 0; e < nl.clockTree.size(); ++e, ++counted) ++groupSize[find(static_cast<int32_t>(numGates + e))];
+    const size_t share = (counted + workers - 1) / workers;
+
+    // Walk backwards from the outputs; a group joins the partition that reads
+    // its output unless that one is full.
+    gatePart.assign(total, -1);
+    partGates.assign(workers, 0);
+    std::vector<int32_t> readerPart(nl.numNets(), -1);
+    std::vector<int32_t> groupPart(total, -1);
+    auto assign = [&](int32_t g, int32_t out, const int32_t* in, size_t n) {
+        const int32_t root = find(g);
+        if (groupPart[root] < 0) {
+            int32_t p = readerPart[out];
+            if (p < 0 || partGates[p] + groupSize[root] > share) {
+                p = static_cast<int32_t>(std::min_element(partGates.begin(), partGates.end()) - partGates.begin());
+            }
+            groupPart[root] = p;
+            partGates[p] += groupSize[root];
+        }
+        gatePart[g] = groupPart[root];
+        for (size_t i = 0; i < n; ++i) {
+            if (readerPart[in[i]] < 0) readerPart[in[i]] = gatePart[g];
+        }
+    };
+    for (size_t e = nl.clockTree.size(); e-- > 0;) {
+        assign(static_cast<int32_t>(numGates + e), nl.clockTree[e].net, &nl.clockTree[e].parent, 1);
+    }
+    for (size_t bi = nl.batches.size(); bi-- > 0;) {
+        const GateBatch& b = nl.batches[bi];
+        for (uint32_t g = b.end; g-- > b.begin;) {
+            assign(static_cast<int32_t>(g), nl.gateOutput[g], nl.gateInputs.data() + nl.gateInputBegin[g],
+                   nl.gateInputBegin[g + 1] - nl.gateInputBegin[g]);
+        }
+    }
+
+    // A net belongs to the partition of its drivers, or of a reader if undriven.
+    owner.assign(nl.numNets(), 0);
+    for (size_t n = 0; n < nl.numNets(); ++n) {
+        if (firstDriver[n] >= 0) owner[n] = gatePart[firstDriver[n]];
+        else if (readerPart[n] >= 0) owner[n] = readerPart[n];
+    }
+
+    std::vector<uint8_t> isBoundary(nl.numNets(), 0);
+    for (const GateBatch& b : nl.batches) {
+        for (uint32_t g = b.begin; g < b.end; ++g) {
+            for (uint32_t i = nl.gateInputBegin[g]; i < nl.gateInputBegin[g + 1]; ++i) {
+                if (owner[nl.gateInputs[i]] != gatePart[g]) isBoundary[nl.gateInputs[i]] = 1;
+            }
+        }
+    }
+    for (size_t e = 0; e < nl.clockTree.size(); ++e) {
+        if (owner[nl.clockTree[e].parent] != gatePart[numGates + e]) isBoundary[nl.clockTree[e].parent] = 1;
+    }
+    for (const auto* pins : {&nl.ffClk, &nl.ffQ, &nl.ffIn0, &nl.ffIn1, &nl.ffEn, &nl.ffSet, &nl.ffRst}) {
+        for (int32_t n : *pins) {
+            if (n >= 0) isBoundary[n] = 1;
+        }
+    }
+    boundaryIndex.assign(nl.numNets(), -1);
+    int32_t count = 0;
+    for (size_t n = 0; n < nl.numNets(); ++n) {
+        if (isBoundary[n]) boundaryIndex[n] = count++;
+    }
+
+    boundaryNl.netFlags.assign(count, 0);
+    boundaryNl.gateInputBegin.push_back(0);
+    boundaryNl.ffType = nl.ffType;
+    boundaryNl.ffSource = nl.ffSource;
+    auto remap = [&](const std::vector<int32_t>& nets, std::vector<int32_t>& out) {
+        for (int32_t n : nets) out.push_back(n >= 0 ? boundaryIndex[n] : -1);
+    };
+    remap(nl.ffClk, boundaryNl.ffClk);
+    remap(nl.ffQ, boundaryNl.ffQ);
+    remap(nl.ffIn0, boundaryNl.ffIn0);
+    remap(nl.ffIn1, boundaryNl.ffIn1);
+    remap(nl.ffEn, boundaryNl.ffEn);
+    remap(nl.ffSet, boundaryNl.ffSet);
+    remap(nl.ffRst, boundaryNl.ffRst);
+    boundary = std::make_unique<ScoapEngine<T>>(boundaryNl);
+}
+
+// Extracts partition p as a netlist of its own. Clock tree edges become
+// buffers and inverters after all other gates.
+template <typename T>
+std::unique_ptr<typename DistributedEngine<T>::Worker> DistributedEngine<T>::buildWorker(int32_t p) const {
+    auto w = std::make_unique<Worker>();
+    w->part = p;
+    CompactNetlist& wn = w->nl;
+    wn.cells = nl.cells;
+    std::vector<int32_t> local(nl.numNets(), -1);
+    auto add = [&](int32_t n) {
+        if (local[n] < 0) {
+            local[n] = static_cast<int32_t>(w->global.size());
+            w->global.push_back(n);
+            wn.netFlags.push_back(owner[n] == p ? nl.netFlags[n] : 0);
+            if (boundaryIndex[n] >= 0) w->links.push_back({local[n], boundaryIndex[n]});
+        }
+        return local[n];
+    };
+    for (size_t n = 0; n < nl.numNets(); ++n) {
+        if (owner[n] == p) add(static_cast<int32_t>(n));
+    }
+
+    wn.gateInputBegin.push_back(0);
+    auto addGate = [&](GateType type, int32_t cell, int32_t out, const int32_t* in, size_t n) {
+        wn.gateType.push_back(type);
+        wn.gateCell.push_back(cell);
+        wn.gateOutput.push_back(add(out));
+        for (size_t i = 0; i < n; ++i) wn.gateInputs.push_back(add(in[i]));
+        wn.gateInputBegin.push_back(static_cast<uint32_t>(wn.gateInputs.size()));
+    };
+    std::vector<int32_t> loopLocal(nl.loops.size(), -1);
+    for (const GateBatch& b : nl.batches) {
+        const uint32_t begin = static_cast<uint32_t>(wn.numGates());
+        for (uint32_t g = b.begin; g < b.end; ++g) {
+            if (gatePart[g] != p) continue;
+            addGate(nl.gateType[g], nl.gateCell[g], nl.gateOutput[g], nl.gateInputs.data() + nl.gateInputBegin[g],
+                    nl.gateInputBegin[g + 1] - nl.gateInputBegin[g]);
+        }
+        const uint32_t end = static_cast<uint32_t>(wn.numGates());
+        if (end == begin) continue;
+        int32_t loop = -1;
+        if (b.loop >= 0) {
+            if (loopLocal[b.loop] < 0) {
+                loopLocal[b.loop] = static_cast<int32_t>(wn.loops.size());
+                const uint32_t next = static_cast<uint32_t>(wn.batches.size());
+                wn.loops.push_back({next, next, 0});
+            }
+            loop = loopLocal[b.loop];
+        }
+        wn.batches.push_back({b.type, b.arity, begin, end, loop});
+        if (loop >= 0) {
+            wn.loops[loop].batchEnd = static_cast<uint32_t>(wn.batches.size());
+            wn.loops[loop].numGates += end - begin;
+        }
+    }
+    for (size_t e = 0; e < nl.clockTree.size(); ++e) {
+        if (gatePart[nl.numGates() + e] != p) continue;
+        const ClockTreeEdge& edge = nl.clockTree[e];
+        const GateType type = edge.inverted ? GateType::Not : GateType::Buf;
+        const uint32_t g = static_cast<uint32_t>(wn.numGates());
+        addGate(type, -1, edge.net, &edge.parent, 1);
+        wn.batches.push_back({type, arityClass(1), g, g + 1, -1});
+    }
+
+    w->engine = std::make_unique<ScoapEngine<T>>(wn);
+    return w;
+}
+
+// One round of a pass in one partition: takes the boundary values, re-runs
+// the pass if any of them improved on the partition's own, and lowers the
+// boundary values with the results. Returns true if a boundary value changed.
+template <typename T>
+bool DistributedEngine<T>::runRound(Worker& w, Pass pass, bool first) {
+    ScoapEngine<T>& e = *w.engine;
+    std::vector<T>* values[2] = {nullptr, nullptr};
+    int metrics[2] = {0, 0};
+    switch (pass) {
+    case Pass::CC: values[0] = &e.cc0; values[1] = &e.cc1; metrics[0] = CC0; metrics[1] = CC1; break;
+    case Pass::SC: values[0] = &e.sc0; values[1] = &e.sc1; metrics[0] = SC0; metrics[1] = SC1; break;
+    case Pass::CO: values[0] = &e.co; metrics[0] = CO; break;
+    case Pass::SO: values[0] = &e.so; metrics[0] = SO; break;
+    }
+
+    bool inputsChanged = first;
+    for (int k = 0; k < 2 && values[k]; ++k) {
+        std::atomic<T>* s = shared(metrics[k]);
+        std::vector<T>& v = *values[k];
+        for (const auto& link : w.links) {
+            const T b = s[link.second].load(std::memory_order_relaxed);
+            if (b < v[link.first]) {
+                v[link.first] = b;
+                inputsChanged = true;
+            }
+        }
+    }
+    if (!inputsChanged) return false;
+
+    switch (pass) {
+    case Pass::CC: e.computeCombinationalControllability(); break;
+    case Pass::SC: e.computeSequentialControllability(); break;
+    case Pass::CO: e.computeCombinationalObservability(); break;
+    case Pass::SO: e.computeSequentialObservability(); break;
+    }
+
+    bool changed = false;
+    for (int k = 0; k < 2 && values[k]; ++k) {
+        std::atomic<T>* s = shared(metrics[k]);
+        const std::vector<T>& v = *values[k];
+        for (const auto& link : w.links) changed |= lower(s[link.second], v[link.first]);
+    }
+    return changed;
+}
+
+// Applies the flip-flop rules to the boundary values once (parent only,
+// while the workers wait). Returns true if a value changed.
+template <typename T>
+bool DistributedEngine<T>::flipFlopRound(Pass pass) {
+    if (boundaryNl.numFlipFlops() == 0) return false;
+    const size_t nB = boundaryNl.numNets();
+    auto load = [&](std::vector<T>& v, int metric) {
+        for (size_t b = 0; b < nB; ++b) v[b] = shared(metric)[b].load(std::memory_order_relaxed);
+    };
+    auto store = [&](const std::vector<T>& v, int metric) {
+        for (size_t b = 0; b < nB; ++b) lower(shared(metric)[b], v[b]);
+    };
+    load(boundary->sc0, SC0);
+    load(boundary->sc1, SC1);
+    if (pass == Pass::SC) {
+        const bool changed = boundary->stepFlipFlopControllability();
+        store(boundary->sc0, SC0);
+        store(boundary->sc1, SC1);
+        return changed;
+    }
+    load(boundary->so, SO);
+    const bool changed = boundary->stepFlipFlopObservability();
+    store(boundary->so, SO);
+    return changed;
+}
+
+template <typename T>
+void DistributedEngine<T>::writeResults(const Worker& w) {
+    const ScoapEngine<T>& e = *w.engine;
+    const std::vector<T>* values[NumMetrics] = {&e.cc0, &e.cc1, &e.sc0, &e.sc1, &e.co, &e.so};
+    for (size_t i = 0; i < w.global.size(); ++i) {
+        const int32_t n = w.global[i];
+        if (owner[n] != w.part) continue;
+        for (int m = 0; m < NumMetrics; ++m) results[static_cast<size_t>(m) * nl.numNets() + n] = (*values[m])[i];
+    }
+    control->cappedLoops.fetch_add(static_cast<uint32_t>(e.cappedLoops));
+}
+
+// Waits until the parent and all workers have arrived. A waiting parent
+// notices workers that died; a waiting worker notices a parent that did.
+template <typename T>
+void DistributedEngine<T>::barrier() {
+    const uint32_t generation = control->generation.load(std::memory_order_acquire);
+    if (control->arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == parties) {
+        control->arrived.store(0, std::memory_order_relaxed);
+        control->generation.fetch_add(1, std::memory_order_release);
+        return;
+    }
+    for (uint32_t spins = 1; control->generation.load(std::memory_order_acquire) == generation; ++spins) {
+        if (spins < 64) {
+            std::this_thread::yield();
+            continue;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+#ifndef _WIN32
+        if (spins % 1024 != 0) continue;
+        if (!pids.empty()) {
+            for (int pid : pids) {
+                int status;
+                if (waitpid(pid, &status, WNOHANG) != 0) throw std::runtime_error("A worker process exited unexpectedly");
+            }
+        } else if (getppid() != parentPid) {
+            _exit(1);
+        }
+#endif
+    }
+}
+
+template <typename T>
+int DistributedEngine<T>::workerMain(int32_t p) {
+    pids.clear();
+#ifdef __linux__
+    if (bindToNumaNodes) bindToNumaNode(p);
+#endif
+    std::unique_ptr<Worker> w;
+    try {
+        w = buildWorker(p);
+    } catch (const std::exception&) {
+        control->failed.store(1);
+    }
+    for (;;) {
+        barrier();
+        const int32_t cmd = control->command.load();
+        if (cmd == Exit) break;
+        if (w) {
+            try {
+                if (cmd == Finish) writeResults(*w);
+                else if (runRound(*w, static_cast<Pass>(cmd), control->first.load() != 0)) control->changed.fetch_add(1);
+            } catch (const std::exception&) {
+                control->failed.store(1);
+                w.reset();
+            }
+        }
+        barrier();
+    }
+    return w ? 0 : 1;
+}
+
+// Parent: hands a command to the workers and waits until they are done.
+template <typename T>
+void DistributedEngine<T>::command(int32_t cmd, bool first) {
+    control->command.store(cmd);
+    control->first.store(first ? 1 : 0);
+    barrier();
+    if (cmd == Exit) return;
+    barrier();
+    if (control->failed.load()) throw std::runtime_error("A worker process failed");
+}
+
+template <typename T>
+bool DistributedEngine<T>::round(Pass pass, bool first) {
+    if (pids.empty()) {
+        bool changed = false;
+        for (auto& w : inProcess) changed |= runRound(*w, pass, first);
+        return changed;
+    }
+    command(static_cast<int32_t>(pass), first);
+    return control->changed.exchange(0) > 0;
+}
+
+template <typename T>
+void DistributedEngine<T>::stopWorkers() {
+#ifndef _WIN32
+    for (int pid : pids) kill(pid, SIGKILL);
+    for (int pid : pids) waitpid(pid, nullptr, 0);
+#endif
+    pids.clear();
+}
+
+template <typename T>
+void DistributedEngine<T>::computeAll() {
+    const int32_t numParts = static_cast<int32_t>(partGates.size());
+#ifdef _WIN32
+    for (int32_t p = 0; p < numParts; ++p) inProcess.push_back(buildWorker(p));
+#else
+    // Flush so that the workers do not inherit (and later repeat) buffered output.
+    std::cout.flush();
+    std::cerr.flush();
+    std::fflush(nullptr);
+    parentPid = static_cast<int>(getpid());
+    parties = static_cast<uint32_t>(numParts) + 1;
+    for (int32_t p = 0; p < numParts; ++p) {
+        const pid_t pid = fork();
+        if (pid < 0) {
+            stopWorkers();
+            throw std::runtime_error("Could not start a worker process");
+        }
+        if (pid == 0) _exit(workerMain(p));
+        pids.push_back(static_cast<int>(pid));
+    }
+#endif
+
+    try {
+        for (int pass = 0; pass < 4; ++pass) {
+            bool changed;
+            bool first = true;
+            do {
+                changed = round(static_cast<Pass>(pass), first);
+                if (pass == static_cast<int>(Pass::SC) || pass == static_cast<int>(Pass::SO)) {
+                    changed |= flipFlopRound(static_cast<Pass>(pass));
+                }
+                first = false;
+                ++rounds[pass];
+            } while (changed);
+        }
+        if (pids.empty()) {
+            for (auto& w : inProcess) writeResults(*w);
+            inProcess.clear();
+        } else {
+            command(Finish, false);
+            command(Exit, false);
+        }
+    } catch (...) {
+        stopWorkers();
+        throw;
+    }
+
+#ifndef _WIN32
+    bool failed = false;
+    for (int pid : pids) {
+        int status = 0;
+        waitpid(pid, &status, 0);
+        failed |= !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+    }
+    pids.clear();
+    if (failed) throw std::runtime_error("A worker process failed");
+#endif
+    cappedLoops = control->cappedLoops.load();
+}
+
+template class DistributedEngine<uint16_t>;
+template class DistributedEngine<uint32_t>;
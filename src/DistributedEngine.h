@@ -0,0 +1,123 @@
+#ifndef DISTRIBUTED_ENGINE_H
+#define DISTRIBUTED_ENGINE_H
+
+#include "CompactNetlist.h"
+#include "MappedFile.h"
+#include "Metric.h"
+#include "ScoapEngine.h"
+#include <atomic>
+#include <memory>
+
+// Runs the SCOAP passes in several local worker processes.
+//
+// The gates are split into one partition per worker by output cone: walking
+// backwards from the outputs, a gate joins the partition of the gates it
+// feeds until that partition holds its share of the gates. All drivers of a
+// net and all gates of a combinational loop stay together. Each worker is a
+// forked process that builds a ScoapEngine over its own partition (so its
+// memory is first touched, and placed, by the process that uses it).
+//
+// Nets read outside the partition that owns them, and every flip-flop pin,
+// are boundary nets. Their metrics live in shared memory and only ever
+// decrease: each round, every worker takes the current boundary values,
+// re-runs the pass over its partition if one of them changed, and lowers the
+// boundary values it computed. Between rounds of the sequential passes the
+// parent applies the flip-flop rules to the boundary nets. A pass ends with
+// the first round that changes nothing, which is the same fixpoint the
+// single-process engine computes, so the results are identical.
+//
+// On Windows, which has no fork(), the partitions are evaluated one after
+// the other in the calling process.
+template <typename T>
+class DistributedEngine {
+public:
+    using M = Metric<T>;
+
+    DistributedEngine(const CompactNetlist& netlist, int workers);
+    ~DistributedEngine();
+    DistributedEngine(const DistributedEngine&) = delete;
+    DistributedEngine& operator=(const DistributedEngine&) = delete;
+
+    // Pins worker p to NUMA node p % nodes before it builds its partition,
+    // so that first touch places its memory on that node (Linux only).
+    bool bindToNumaNodes = false;
+
+    // Runs CC, SC, CO and SO. Throws std::runtime_error if a worker fails.
+    void computeAll();
+
+    // Results indexed by net id, valid after computeAll().
+    const T* cc0() const { return result(CC0); }
+    const T* cc1() const { return result(CC1); }
+    const T* sc0() const { return result(SC0); }
+    const T* sc1() const { return result(SC1); }
+    const T* co() const { return result(CO); }
+    const T* so() const { return result(SO); }
+
+    size_t numPartitions() const { return partGates.size(); }
+    size_t numBoundaryNets() const { return boundaryNl.numNets(); }
+    // Rounds each pass took to converge, in the order CC, SC, CO, SO.
+    size_t rounds[4] = {0, 0, 0, 0};
+
+    // Combinational loop evaluations stopped by the iteration bound.
+    size_t cappedLoops = 0;
+
+private:
+    enum class Pass { CC, SC, CO, SO };
+    enum MetricIndex { CC0, CC1, SC0, SC1, CO, SO, NumMetrics };
+    enum Command : int32_t { Finish = 4, Exit = 5 }; // Passes are 0..3
+
+    // Shared between the parent and the workers.
+    struct Control {
+        std::atomic<uint32_t> arrived{0}, generation{0}; // Barrier
+        std::atomic<int32_t> command{0};
+        std::atomic<uint32_t> first{0};
+        std::atomic<uint32_t> changed{0};
+        std::atomic<uint32_t> failed{0};
+        std::atomic<uint32_t> cappedLoops{0};
+    };
+
+    // One partition as a small netlist. Window nets are the partition's own
+    // nets and the boundary nets its gates read.
+    struct Worker {
+        int32_t part;
+        CompactNetlist nl;
+        std::vector<int32_t> global;                    // Window net -> net id
+        std::vector<std::pair<int32_t, int32_t>> links; // (window net, boundary index)
+        std::unique_ptr<ScoapEngine<T>> engine;
+    };
+
+    void partition(int workers);
+    std::unique_ptr<Worker> buildWorker(int32_t p) const;
+    bool runRound(Worker& w, Pass pass, bool first);
+    bool flipFlopRound(Pass pass);
+    void writeResults(const Worker& w);
+    int workerMain(int32_t p);
+    void barrier();
+    void stopWorkers();
+    bool round(Pass pass, bool first);
+    void command(int32_t cmd, bool first);
+
+    const T* result(int metric) const { return results + static_cast<size_t>(metric) * nl.numNets(); }
+    std::atomic<T>* shared(int metric) const { return boundaryValues + static_cast<size_t>(metric) * boundaryNl.numNets(); }
+
+    const CompactNetlist& nl;
+    // Partition of each gate (clock tree edges follow the gates), the owner
+    // partition and boundary index (or -1) of each net.
+    std::vector<int32_t> gatePart, owner, boundaryIndex;
+    std::vector<size_t> partGates;
+
+    // Flip-flops re-indexed by boundary index, and their metrics.
+    CompactNetlist boundaryNl;
+    std::unique_ptr<ScoapEngine<T>> boundary;
+
+    MappedRange region;
+    Control* control = nullptr;
+    std::atomic<T>* boundaryValues = nullptr;
+    T* results = nullptr;
+    uint32_t parties = 1;
+    std::vector<int> pids; // Worker processes, in the parent only
+    int parentPid = 0;
+    std::vector<std::unique_ptr<Worker>> inProcess; // Without fork()
+};
+
+#endif // DISTRIBUTED_ENGINE_H
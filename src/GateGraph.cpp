@@ -0,0 +1,104 @@
+#include "GateGraph.h"
+#include "Levelizer.h"
+#include "StronglyConnected.h"
+#include <algorithm>
+#include <numeric>
+
+namespace {
+
+// The gates reading each net (once per input pin), in CSR form.
+void netLoads(const GateGraph& graph, std::vector<uint32_t>& loadBegin, std::vector<int32_t>& loadGates) {
+    loadBegin.assign(graph.numNets + 1, 0);
+    for (int32_t n : graph.inputNet) {
+        if (n >= 0) ++loadBegin[n + 1];
+    }
+    for (size_t n = 0; n < graph.numNets; ++n) loadBegin[n + 1] += loadBegin[n];
+    loadGates.resize(loadBegin.back());
+    std::vector<uint32_t> loadFill(loadBegin.begin(), loadBegin.end() - 1);
+    for (size_t g = 0; g < graph.numGates(); ++g) {
+        for (uint32_t i = graph.inputBegin[g]; i < graph.inputBegin[g + 1]; ++i) {
+            if (graph.inputNet[i] >= 0) loadGates[loadFill[graph.inputNet[i]]++] = static_cast<int32_t>(g);
+        }
+    }
+}
+
+} // namespace
+
+GateLevels levelizeGates(const GateGraph& graph, ThreadPool& pool) {
+    const size_t numGates = graph.numGates();
+    std::vector<uint32_t> loadBegin;
+    std::vector<int32_t> loadGates;
+    netLoads(graph, loadBegin, loadGates);
+    std::vector<uint32_t> succBegin(numGates + 1, 0);
+    std::vector<int32_t> succ;
+    for (size_t g = 0; g < numGates; ++g) {
+        const int32_t out = graph.outputNet[g];
+        if (out >= 0) succ.insert(succ.end(), loadGates.begin() + loadBegin[out], loadGates.begin() + loadBegin[out + 1]);
+        succBegin[g + 1] = static_cast<uint32_t>(succ.size());
+    }
+
+    int32_t numComponents = 0;
+    std::vector<int32_t> component = stronglyConnectedComponents(succBegin, succ, numComponents);
+    Levelization levels = levelize(succBegin, succ, component, numComponents, pool);
+
+    // A component is a loop if it has several gates or a gate drives its
+    // own input. Loops are numbered in topological order of the components.
+    std::vector<uint8_t> cyclic(numComponents, 0);
+    std::vector<uint32_t> componentSize(numComponents, 0);
+    for (size_t g = 0; g < numGates; ++g) {
+        if (++componentSize[component[g]] > 1) cyclic[component[g]] = 1;
+        for (uint32_t i = graph.inputBegin[g]; i < graph.inputBegin[g + 1]; ++i) {
+            if (graph.inputNet[i] >= 0 && graph.inputNet[i] == graph.outputNet[g]) cyclic[component[g]] = 1;
+        }
+    }
+    std::vector<int> loopOf(numComponents, -1);
+    GateLevels result;
+    for (int32_t c = numComponents - 1; c >= 0; --c) {
+        if (cyclic[c]) loopOf[c] = result.numLoops++;
+    }
+
+    result.gateLevel.assign(levels.level.begin(), levels.level.end());
+    result.gateLoop.resize(numGates);
+    result.netLevel.assign(graph.numNets, 0);
+    result.netDriver.assign(graph.numNets, -1);
+    for (size_t g = 0; g < numGates; ++g) {
+        result.gateLoop[g] = loopOf[component[g]];
+        const int32_t out = graph.outputNet[g];
+        if (out < 0) continue;
+        result.netLevel[out] = std::max(result.netLevel[out], result.gateLevel[g]);
+        if (result.netDriver[out] < 0) result.netDriver[out] = static_cast<int32_t>(g);
+    }
+    result.levelBegin = std::move(levels.levelBegin);
+    result.levelGates = std::move(levels.nodes);
+    return result;
+}
+
+std::vector<uint8_t> findClockNetworks(const GateGraph& graph, const std::vector<int>& netLevel,
+                                       const std::vector<uint8_t>& excluded,
+                                       const std::vector<uint8_t>& controlUse, size_t& buffers) {
+    std::vector<uint32_t> loadBegin;
+    std::vector<int32_t> loadGates;
+    netLoads(graph, loadBegin, loadGates);
+    std::vector<int32_t> byLevel(graph.numNets);
+    std::iota(byLevel.begin(), byLevel.end(), 0);
+    std::stable_sort(byLevel.begin(), byLevel.end(), [&](int32_t a, int32_t b) { return netLevel[a] > netLevel[b]; });
+
+    std::vector<uint8_t> marked(graph.numNets, 0);
+    buffers = 0;
+    for (int32_t n : byLevel) {
+        if (excluded[n]) continue;
+        bool onlyTree = true;
+        for (uint32_t l = loadBegin[n]; l < loadBegin[n + 1] && onlyTree; ++l) {
+            const int32_t g = loadGates[l];
+            onlyTree = (graph.kind[g] == GateType::Buf || graph.kind[g] == GateType::Not)
+                    && graph.inputBegin[g + 1] - graph.inputBegin[g] == 1
+                    && graph.outputNet[g] >= 0 && marked[graph.outputNet[g]];
+        }
+        const uint32_t treeLoads = loadBegin[n + 1] - loadBegin[n];
+        if (onlyTree && (treeLoads > 0 || controlUse[n])) {
+            marked[n] = 1;
+            buffers += treeLoads;
+        }
+    }
+    return marked;
+}
@@ -0,0 +1,51 @@
+#ifndef GATE_GRAPH_H
+#define GATE_GRAPH_H
+
+#include "DataStructures.h"
+#include "ThreadPool.h"
+#include <cstdint>
+#include <vector>
+
+// The gates of a netlist in net ids: the input pins of gate g connect the
+// nets inputNet[inputBegin[g] .. inputBegin[g + 1]) and its output drives
+// outputNet[g]. Pins that are not connected to a net are -1.
+struct GateGraph {
+    size_t numNets = 0;
+    std::vector<GateType> kind;
+    std::vector<uint32_t> inputBegin{0}; // numGates() + 1 entries
+    std::vector<int32_t> inputNet;
+    std::vector<int32_t> outputNet;
+
+    size_t numGates() const { return outputNet.size(); }
+};
+
+// The levels of the gates and nets, and the combinational loops.
+struct GateLevels {
+    std::vector<int> gateLevel;      // Per gate
+    std::vector<int> gateLoop;       // Loop of each gate, or -1
+    int numLoops = 0;
+    std::vector<int> netLevel;       // Highest level of the gates driving a net, 0 if none
+    std::vector<int32_t> netDriver;  // First gate driving each net, or -1
+    std::vector<uint32_t> levelBegin; // Gates of level l are levelGates[levelBegin[l - 1] .. levelBegin[l])
+    std::vector<int32_t> levelGates;
+};
+
+// Levelizes the gate graph (g -> h if the output of g is an input of h).
+// The gates of a loop (a strongly connected component with several gates,
+// or a gate driving its own input) share a level instead of never being
+// levelized. Loops are numbered in topological order. Wide levels are
+// split over the threads of `pool`.
+GateLevels levelizeGates(const GateGraph& graph, ThreadPool& pool = ThreadPool::shared());
+
+// Marks the nets that only carry clocks and asynchronous set/reset signals
+// to flip-flops: nets whose every use is a control pin (`controlUse`) or a
+// buffer or inverter driving another marked net. Nets flagged in `excluded`
+// (primary outputs and flip-flop data pins) are never marked. Nets are
+// visited from the highest level down, so the outputs of a buffer tree are
+// decided before its input. `buffers` counts the buffers and inverters
+// inside the marked networks.
+std::vector<uint8_t> findClockNetworks(const GateGraph& graph, const std::vector<int>& netLevel,
+                                       const std::vector<uint8_t>& excluded,
+                                       const std::vector<uint8_t>& controlUse, size_t& buffers);
+
+#endif // GATE_GRAPH_H
@@ -0,0 +1,254 @@
+#ifndef GATE_KERNELS_H
+#define GATE_KERNELS_H
+
+#include "CellLibrary.h"
+#include "Metric.h"
+#include <type_traits>
+
+// Compile-time SCOAP evaluation kernels for the primitive gates.
+//
+// Each primitive is described by a GateRule specialization. The and/or family
+// is fully characterised by its controlling input value and whether the output
+// is inverted, so one kernel serves and/nand/or/nor. Kernels are additionally
+// specialized on the gate arity: 1..4 inputs are unrolled, and Arity == 0
+// selects the generic N-input loop. Complex cells (GateType::Cell) are
+// evaluated from the cube covers of their CellRule.
+
+struct PrimitiveRule {
+    static constexpr bool andOr = false;
+    static constexpr bool parity = false;
+    static constexpr bool unary = false;
+    static constexpr bool cell = false;
+    static constexpr bool controlling = false;
+    static constexpr bool inverted = false;
+};
+
+template <GateType G> struct GateRule : PrimitiveRule {};
+
+template <bool C, bool I> struct AndOrRule : PrimitiveRule {
+    static constexpr bool andOr = true;
+    static constexpr bool controlling = C;
+    static constexpr bool inverted = I;
+};
+template <> struct GateRule<GateType::And>  : AndOrRule<false, false> {};
+template <> struct GateRule<GateType::Nand> : AndOrRule<false, true> {};
+template <> struct GateRule<GateType::Or>   : AndOrRule<true, false> {};
+template <> struct GateRule<GateType::Nor>  : AndOrRule<true, true> {};
+
+template <bool I> struct ParityRule : PrimitiveRule {
+    static constexpr bool parity = true;
+    static constexpr bool inverted = I;
+};
+template <> struct GateRule<GateType::Xor>  : ParityRule<false> {};
+template <> struct GateRule<GateType::Xnor> : ParityRule<true> {};
+
+template <bool I> struct UnaryRule : PrimitiveRule {
+    static constexpr bool unary = true;
+    static constexpr bool inverted = I;
+};
+template <> struct GateRule<GateType::Not> : UnaryRule<true> {};
+template <> struct GateRule<GateType::Buf> : UnaryRule<false> {};
+
+// Complex cells evaluate the cube covers of their CellRule.
+template <> struct GateRule<GateType::Cell> : PrimitiveRule {
+    static constexpr bool cell = true;
+};
+
+// Largest arity with an unrolled kernel; wider gates use the generic loop.
+constexpr int kMaxUnrolledArity = 4;
+
+// Arity class used to group gates into batches.
+inline uint8_t arityClass(size_t inputs) {
+    return inputs <= static_cast<size_t>(kMaxUnrolledArity) ? static_cast<uint8_t>(inputs) : 0;
+}
+
+// Minimum of minOf[] and saturated sum of sumOf[] over the gate inputs.
+template <int Arity, typename T>
+inline void foldMinSum(const int32_t* in, uint32_t n, const T* minOf, const T* sumOf, T& mn, T& sum) {
+    using M = Metric<T>;
+    if constexpr (Arity == 0) {
+        mn = M::INF;
+        sum = 0;
+        for (uint32_t k = 0; k < n; ++k) {
+            mn = M::min(mn, minOf[in[k]]);
+            sum = M::add(sum, sumOf[in[k]]);
+        }
+    } else {
+        mn = minOf[in[0]];
+        sum = sumOf[in[0]];
+        for (int k = 1; k < Arity; ++k) {
+            mn = M::min(mn, minOf[in[k]]);
+            sum = M::add(sum, sumOf[in[k]]);
+        }
+    }
+}
+
+// Cost of the cheapest cube in `cubes`: the saturated sum of the
+// controllabilities of its literals.
+template <typename T>
+inline T cheapestCube(const std::vector<CellCube>& cubes, const int32_t* in, const T* v0, const T* v1) {
+    using M = Metric<T>;
+    T best = M::INF;
+    for (const CellCube& cube : cubes) {
+        T cost = 0;
+        uint32_t pin = 0;
+        for (uint32_t bits = cube.care; bits; bits >>= 1, ++pin) {
+            if (bits & 1u) cost = M::add(cost, ((cube.value >> pin) & 1u) ? v1[in[pin]] : v0[in[pin]]);
+        }
+        best = M::min(best, cost);
+    }
+    return best;
+}
+
+// Controllability of a gate output from its input controllabilities, without
+// the per-gate +1 (the caller adds 1 for CC and 0 for SC). `cell` is the rule
+// of a complex cell and is ignored by primitives. Returns false for gates the
+// kernel cannot evaluate.
+template <GateType G, int Arity>
+struct ControllabilityKernel {
+    using R = GateRule<G>;
+
+    template <typename T>
+    static bool eval(const int32_t* in, uint32_t n, const T* v0, const T* v1, T& out0, T& out1,
+                     const CellRule* cell) {
+        using M = Metric<T>;
+        (void)cell;
+        if constexpr (R::andOr) {
+            // Any input at the controlling value fixes the output; the other
+            // output value needs every input at the non-controlling value.
+            T mn, sum;
+            foldMinSum<Arity>(in, n, R::controlling ? v1 : v0, R::controlling ? v0 : v1, mn, sum);
+            constexpr bool controlledOutput = R::controlling != R::inverted;
+            out0 = controlledOutput ? sum : mn;
+            out1 = controlledOutput ? mn : sum;
+            return true;
+        } else if constexpr (R::parity) {
+            // Cheapest way to reach an even and an odd number of ones.
+            const uint32_t count = Arity == 0 ? n : static_cast<uint32_t>(Arity);
+            T even = 0, odd = M::INF;
+            for (uint32_t k = 0; k < count; ++k) {
+                const T c0 = v0[in[k]], c1 = v1[in[k]];
+                const T nextEven = M::min(M::add(even, c0), M::add(odd, c1));
+                odd = M::min(M::add(even, c1), M::add(odd, c0));
+                even = nextEven;
+            }
+            out0 = R::inverted ? odd : even;
+            out1 = R::inverted ? even : odd;
+            return true;
+        } else if constexpr (R::unary) {
+            out0 = R::inverted ? v1[in[0]] : v0[in[0]];
+            out1 = R::inverted ? v0[in[0]] : v1[in[0]];
+            return true;
+        } else if constexpr (R::cell) {
+            if (n != cell->pins.size()) return false;
+            out0 = cheapestCube(cell->offSet, in, v0, v1);
+            out1 = cheapestCube(cell->onSet, in, v0, v1);
+            return true;
+        } else {
+            (void)in; (void)n; (void)v0; (void)v1; (void)out0; (void)out1;
+            return false;
+        }
+    }
+};
+
+// Calls emit(i, sum) for every input position i, where sum is the saturated
+// sum of cost(in[j]) over all j != i. The total is computed once and each
+// value is derived by subtraction; only when the total saturates (so that
+// subtraction would be wrong) are prefix/suffix sums used instead. scratch
+// must hold at least `count` values for generic-arity gates.
+template <int Arity, typename T, typename Cost, typename Emit>
+inline void sumOfOthers(const int32_t* in, uint32_t count, T* scratch, Cost cost, Emit emit) {
+    using M = Metric<T>;
+    T total = 0;
+    for (uint32_t j = 0; j < count; ++j) total = M::add(total, cost(in[j]));
+    if (total != M::INF) {
+        for (uint32_t i = 0; i < count; ++i) emit(i, static_cast<T>(total - cost(in[i])));
+        return;
+    }
+    T local[kMaxUnrolledArity];
+    T* prefix = Arity == 0 ? scratch : local;
+    T acc = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        prefix[i] = acc;
+        acc = M::add(acc, cost(in[i]));
+    }
+    T suffix = 0;
+    for (uint32_t i = count; i-- > 0;) {
+        emit(i, M::add(prefix[i], suffix));
+        suffix = M::add(suffix, cost(in[i]));
+    }
+}
+
+// Observability of each gate input from the output observability obsY, with
+// per-gate cost `bias` (1 for CO, 0 for SO). Improved values are min-merged
+// into obs[]; returns true if any input improved. Runs in O(arity).
+template <GateType G, int Arity>
+struct ObservabilityKernel {
+    using R = GateRule<G>;
+
+    template <typename T>
+    static bool eval(const int32_t* in, uint32_t n, T obsY, T bias, const T* v0, const T* v1, T* obs, T* scratch,
+                     const CellRule* cell) {
+        using M = Metric<T>;
+        (void)cell;
+        const uint32_t count = Arity == 0 ? n : static_cast<uint32_t>(Arity);
+        const T base = M::add(obsY, bias);
+        bool changed = false;
+        auto emit = [&](uint32_t i, T others) {
+            T value = M::add(base, others);
+            if (value < obs[in[i]]) { obs[in[i]] = value; changed = true; }
+        };
+        if constexpr (R::andOr) {
+            // Every other input must sit at its non-controlling value.
+            const T* nc = R::controlling ? v0 : v1;
+            sumOfOthers<Arity>(in, count, scratch, [nc](int32_t net) { return nc[net]; }, emit);
+        } else if constexpr (R::parity) {
+            // Every other input must be set, to either value.
+            sumOfOthers<Arity>(in, count, scratch,
+                [v0, v1](int32_t net) { return M::min(v0[net], v1[net]); }, emit);
+        } else if constexpr (R::unary) {
+            for (uint32_t i = 0; i < count; ++i) emit(i, 0);
+        } else if constexpr (R::cell) {
+            // The other inputs must satisfy the Boolean difference w.r.t. input i.
+            if (n == cell->pins.size()) {
+                for (uint32_t i = 0; i < n; ++i) emit(i, cheapestCube(cell->sensitize[i], in, v0, v1));
+            }
+        } else {
+            (void)in; (void)v0; (void)v1; (void)obs; (void)scratch; (void)emit;
+        }
+        return changed;
+    }
+};
+
+// Invokes f(std::integral_constant<GateType, G>, std::integral_constant<int, A>)
+// for the compile-time pair matching a runtime (type, arity class).
+template <GateType G, typename F>
+inline void dispatchArity(uint8_t arity, F&& f) {
+    switch (arity) {
+    case 1: f(std::integral_constant<GateType, G>{}, std::integral_constant<int, 1>{}); break;
+    case 2: f(std::integral_constant<GateType, G>{}, std::integral_constant<int, 2>{}); break;
+    case 3: f(std::integral_constant<GateType, G>{}, std::integral_constant<int, 3>{}); break;
+    case 4: f(std::integral_constant<GateType, G>{}, std::integral_constant<int, 4>{}); break;
+    default: f(std::integral_constant<GateType, G>{}, std::integral_constant<int, 0>{}); break;
+    }
+}
+
+template <typename F>
+inline void dispatchGate(GateType type, uint8_t arity, F&& f) {
+    switch (type) {
+    case GateType::And:  dispatchArity<GateType::And>(arity, f); break;
+    case GateType::Nand: dispatchArity<GateType::Nand>(arity, f); break;
+    case GateType::Or:   dispatchArity<GateType::Or>(arity, f); break;
+    case GateType::Nor:  dispatchArity<GateType::Nor>(arity, f); break;
+    case GateType::Xor:  dispatchArity<GateType::Xor>(arity, f); break;
+    case GateType::Xnor: dispatchArity<GateType::Xnor>(arity, f); break;
+    case GateType::Not:  dispatchArity<GateType::Not>(arity, f); break;
+    case GateType::Buf:  dispatchArity<GateType::Buf>(arity, f); break;
+    case GateType::Cell:
+        f(std::integral_constant<GateType, GateType::Cell>{}, std::integral_constant<int, 0>{});
+        break;
+    case GateType::Unknown: break;
+    }
+}
+
+#endif // GATE_KERNELS_H
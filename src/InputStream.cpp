@@ -0,0 +1,289 @@
+#include "InputStream.h"
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef SCOAP_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef SCOAP_HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+namespace {
+
+constexpr size_t kBlockSize = 1 << 20; // Decompressed bytes per ring block
+constexpr size_t kBlocks = 4;          // Ring blocks, including the one being read
+constexpr size_t kReadSize = 1 << 18;  // Compressed bytes per read
+
+} // namespace
+
+// The ring and its producer thread. Blocks are produced in order; block
+// `filled % kBlocks` is the next one to write and block `consumed % kBlocks`
+// the one the reader holds, so the producer may run up to kBlocks - 1 blocks
+// ahead.
+class InputPipeline : public std::streambuf {
+public:
+    explicit InputPipeline(const std::string& filename) : name(filename) {
+        if (filename == "-") {
+            file = stdin;
+#ifdef _WIN32
+            _setmode(_fileno(stdin), _O_BINARY);
+#endif
+        } else {
+            file = std::fopen(filename.c_str(), "rb");
+            if (!file) return;
+        }
+        blocks.assign(kBlocks, {});
+        for (auto& b : blocks) b.data.resize(kBlockSize);
+        producer = std::thread(&InputPipeline::run, this);
+    }
+
+    ~InputPipeline() override {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        changed.notify_all();
+        if (producer.joinable()) producer.join();
+        if (file && file != stdin) std::fclose(file);
+    }
+
+    bool isOpen() const { return file != nullptr; }
+
+    std::string errorMessage() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return failure;
+    }
+
+protected:
+    int_type underflow() override {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (holding) {
+            holding = false;
+            ++consumed;
+            changed.notify_all();
+        }
+        changed.wait(lock, [&] { return filled > consumed || done; });
+        if (filled == consumed) {
+            setg(nullptr, nullptr, nullptr);
+            return traits_type::eof();
+        }
+        Block& b = blocks[consumed % kBlocks];
+        holding = true;
+        setg(b.data.data(), b.data.data(), b.data.data() + b.size);
+        return traits_type::to_int_type(*gptr());
+    }
+
+private:
+    struct Block {
+        std::vector<char> data;
+        size_t size = 0;
+    };
+
+    // Waits for a free block; nullptr once the reader is gone.
+    char* acquire() {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [&] { return filled - consumed < kBlocks || stop; });
+        return stop ? nullptr : blocks[filled % kBlocks].data.data();
+    }
+
+    void publish(size_t size) {
+        if (size == 0) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            blocks[filled % kBlocks].size = size;
+            ++filled;
+        }
+        changed.notify_all();
+    }
+
+    void finish(const std::string& error) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            failure = error;
+            done = true;
+        }
+        changed.notify_all();
+    }
+
+    size_t readRaw(char* out, size_t size) {
+        size_t n = std::fread(out, 1, size, file);
+        if (n < size && std::ferror(file)) readError = std::strerror(errno);
+        return n;
+    }
+
+    void run() {
+        std::vector<char> head(kReadSize);
+        size_t headSize = readRaw(head.data(), head.size());
+        const unsigned char* magic = reinterpret_cast<const unsigned char*>(head.data());
+        std::string error;
+        if (headSize >= 2 && magic[0] == 0x1f && magic[1] == 0x8b) {
+            error = inflateGzip(head, headSize);
+        } else if (headSize >= 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd) {
+            error = decompressZstd(head, headSize);
+        } else {
+            copyPlain(head, headSize);
+        }
+        if (error.empty() && !readError.empty()) error = "read error: " + readError;
+        finish(error.empty() ? error : name + ": " + error);
+    }
+
+    void copyPlain(const std::vector<char>& head, size_t headSize) {
+        size_t used = 0; // Bytes of head already copied
+        while (true) {
+            char* out = acquire();
+            if (!out) return;
+            size_t size = std::min(headSize - used, kBlockSize);
+            std::memcpy(out, head.data() + used, size);
+            used += size;
+            if (size < kBlockSize && used == headSize) size += readRaw(out + size, kBlockSize - size);
+            publish(size);
+            if (size < kBlockSize) return;
+        }
+    }
+
+    std::string inflateGzip(std::vector<char>& in, size_t inSize) {
+#ifdef SCOAP_HAVE_ZLIB
+        z_stream zs{};
+        if (inflateInit2(&zs, 15 + 16) != Z_OK) return "could not initialize zlib";
+        zs.next_in = reinterpret_cast<Bytef*>(in.data());
+        zs.avail_in = static_cast<uInt>(inSize);
+        std::string error;
+        char* out = acquire();
+        size_t size = 0;
+        bool inputEnded = inSize < in.size();
+        while (out) {
+            if (zs.avail_in == 0 && !inputEnded) {
+                inSize = readRaw(in.data(), in.size());
+                inputEnded = inSize < in.size();
+                zs.next_in = reinterpret_cast<Bytef*>(in.data());
+                zs.avail_in = static_cast<uInt>(inSize);
+            }
+            zs.next_out = reinterpret_cast<Bytef*>(out + size);
+            zs.avail_out = static_cast<uInt>(kBlockSize - size);
+            const int status = inflate(&zs, Z_NO_FLUSH);
+            size = kBlockSize - zs.avail_out;
+            if (status == Z_STREAM_END) {
+                // Concatenated gzip members form one stream. A member may end
+                // exactly at the end of a read, so read ahead before deciding
+                // that another one follows.
+                if (zs.avail_in == 0 && !inputEnded) {
+                    inSize = readRaw(in.data(), in.size());
+                    inputEnded = inSize < in.size();
+                    zs.next_in = reinterpret_cast<Bytef*>(in.data());
+                    zs.avail_in = static_cast<uInt>(inSize);
+                }
+                if (zs.avail_in == 0) break;
+                inflateReset(&zs);
+            } else if (status == Z_BUF_ERROR && zs.avail_in == 0 && inputEnded) {
+                error = "truncated gzip stream";
+                break;
+            } else if (status != Z_OK && status != Z_BUF_ERROR) {
+                error = std::string("corrupt gzip stream") + (zs.msg ? std::string(" (") + zs.msg + ")" : "");
+                break;
+            }
+            if (size == kBlockSize) {
+                publish(size);
+                out = acquire();
+                size = 0;
+            }
+        }
+        if (out) publish(size);
+        inflateEnd(&zs);
+        return error;
+#else
+        (void)in;
+        (void)inSize;
+        return "gzip input needs a build with zlib";
+#endif
+    }
+
+    std::string decompressZstd(std::vector<char>& in, size_t inSize) {
+#ifdef SCOAP_HAVE_ZSTD
+        ZSTD_DStream* zs = ZSTD_createDStream();
+        if (!zs) return "could not initialize zstd";
+        ZSTD_inBuffer input{in.data(), inSize, 0};
+        std::string error;
+        char* out = acquire();
+        size_t size = 0;
+        size_t hint = 1;      // Nonzero while a frame is incomplete
+        bool flushed = false; // The last call left room in the output, so zstd holds nothing back
+        bool inputEnded = inSize < in.size();
+        while (out) {
+            if (input.pos == input.size && !inputEnded) {
+                inSize = readRaw(in.data(), in.size());
+                inputEnded = inSize < in.size();
+                input = {in.data(), inSize, 0};
+            }
+            // Decide on the hint of the last call that had input: called
+            // without any, zstd would ask for the header of a next frame.
+            if (input.pos == input.size && inputEnded && flushed) {
+                if (hint != 0) error = "truncated zstd stream";
+                break;
+            }
+            ZSTD_outBuffer output{out, kBlockSize, size};
+            hint = ZSTD_decompressStream(zs, &output, &input);
+            if (ZSTD_isError(hint)) {
+                error = std::string("corrupt zstd stream (") + ZSTD_getErrorName(hint) + ")";
+                break;
+            }
+            size = output.pos;
+            flushed = size < kBlockSize;
+            if (size == kBlockSize) {
+                publish(size);
+                out = acquire();
+                size = 0;
+            }
+        }
+        if (out) publish(size);
+        ZSTD_freeDStream(zs);
+        return error;
+#else
+        (void)in;
+        (void)inSize;
+        return "zstd input needs a build with libzstd";
+#endif
+    }
+
+    std::string name;
+    FILE* file = nullptr;
+    std::thread producer;
+    std::vector<Block> blocks;
+    mutable std::mutex mutex;
+    std::condition_variable changed;
+    size_t filled = 0, consumed = 0; // Blocks produced and released
+    bool holding = false;            // The reader holds block `consumed`
+    bool done = false, stop = false;
+    std::string failure;
+    std::string readError; // Producer thread only
+};
+
+InputStream::InputStream(const std::string& filename)
+    : std::istream(nullptr), pipeline(new InputPipeline(filename)) {
+    rdbuf(pipeline.get());
+    if (!pipeline->isOpen()) setstate(std::ios::failbit);
+}
+
+InputStream::~InputStream() = default;
+
+bool InputStream::is_open() const {
+    return pipeline->isOpen();
+}
+
+bool InputStream::failed() const {
+    return !pipeline->errorMessage().empty();
+}
+
+std::string InputStream::error() const {
+    return pipeline->errorMessage();
+}
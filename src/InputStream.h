@@ -0,0 +1,31 @@
+#ifndef INPUT_STREAM_H
+#define INPUT_STREAM_H
+
+#include <istream>
+#include <memory>
+#include <string>
+
+class InputPipeline;
+
+// An input stream over a file, or standard input for "-", that may be gzip
+// or zstd compressed (detected from the first bytes, not the file name).
+// A pipeline thread reads and decompresses into a small ring of blocks that
+// the stream hands to the reader directly, so decompression overlaps with
+// parsing and nothing is written to disk. Plain input goes through the same
+// ring, which overlaps reading with parsing.
+class InputStream : public std::istream {
+public:
+    explicit InputStream(const std::string& filename);
+    ~InputStream();
+
+    bool is_open() const;
+    // Whether reading or decompressing stopped on an error; the stream then
+    // ends early, as if the input were shorter.
+    bool failed() const;
+    std::string error() const;
+
+private:
+    std::unique_ptr<InputPipeline> pipeline;
+};
+
+#endif // INPUT_STREAM_H
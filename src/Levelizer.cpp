@@ -0,0 +1,63 @@
+#include "Levelizer.h"
+#include <algorithm>
+#include <atomic>
+
+Levelization levelize(const std::vector<uint32_t>& begin, const std::vector<int32_t>& adj,
+                      const std::vector<int32_t>& component, int32_t numComponents, ThreadPool& pool) {
+    const size_t numNodes = component.size();
+
+    // Members of each component.
+    std::vector<uint32_t> memberBegin(numComponents + 1, 0);
+    for (int32_t c : component) ++memberBegin[c + 1];
+    for (int32_t c = 0; c < numComponents; ++c) memberBegin[c + 1] += memberBegin[c];
+    std::vector<int32_t> members(numNodes);
+    std::vector<uint32_t> fill(memberBegin.begin(), memberBegin.end() - 1);
+    for (size_t v = 0; v < numNodes; ++v) members[fill[component[v]]++] = static_cast<int32_t>(v);
+
+    // Pending incoming edges from other components, counted per edge.
+    std::vector<std::atomic<uint32_t>> pending(numComponents);
+    for (auto& p : pending) p.store(0, std::memory_order_relaxed);
+    pool.parallelChunks(numNodes, [&](size_t first, size_t last, unsigned) {
+        for (size_t v = first; v < last; ++v) {
+            for (uint32_t i = begin[v]; i < begin[v + 1]; ++i) {
+                if (component[adj[i]] != component[v]) pending[component[adj[i]]].fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    });
+
+    Levelization result;
+    result.level.assign(numNodes, 0);
+    result.levelBegin.push_back(0);
+    result.nodes.reserve(numNodes);
+    std::vector<int32_t> frontier;
+    for (int32_t c = numComponents - 1; c >= 0; --c) {
+        if (pending[c].load(std::memory_order_relaxed) == 0) frontier.push_back(c);
+    }
+    std::vector<std::vector<int32_t>> next(pool.concurrency());
+    for (int32_t level = 1; !frontier.empty(); ++level) {
+        pool.parallelChunks(frontier.size(), [&](size_t first, size_t last, unsigned t) {
+            for (size_t f = first; f < last; ++f) {
+                const int32_t c = frontier[f];
+                for (uint32_t m = memberBegin[c]; m < memberBegin[c + 1]; ++m) {
+                    const int32_t v = members[m];
+                    result.level[v] = level;
+                    for (uint32_t i = begin[v]; i < begin[v + 1]; ++i) {
+                        const int32_t s = component[adj[i]];
+                        if (s != c && pending[s].fetch_sub(1, std::memory_order_acq_rel) == 1) next[t].push_back(s);
+                    }
+                }
+            }
+        });
+        for (int32_t c : frontier) {
+            result.nodes.insert(result.nodes.end(), members.begin() + memberBegin[c], members.begin() + memberBegin[c + 1]);
+        }
+        result.levelBegin.push_back(static_cast<uint32_t>(result.nodes.size()));
+        frontier.clear();
+        for (auto& n : next) {
+            frontier.insert(frontier.end(), n.begin(), n.end());
+            n.clear();
+        }
+        std::sort(frontier.begin(), frontier.end(), std::greater<int32_t>());
+    }
+    return result;
+}
@@ -0,0 +1,32 @@
+#ifndef LEVELIZER_H
+#define LEVELIZER_H
+
+#include "ThreadPool.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Levels of the nodes of a directed graph, and the nodes of each level.
+// The nodes of level l (l >= 1) are nodes[levelBegin[l - 1] .. levelBegin[l]).
+struct Levelization {
+    std::vector<int32_t> level; // Per node
+    std::vector<uint32_t> levelBegin;
+    std::vector<int32_t> nodes;
+    size_t numLevels() const { return levelBegin.size() - 1; }
+};
+
+// Levelizes the condensation of a graph in CSR form (successors of v are
+// adj[begin[v] .. begin[v + 1])) whose strongly connected components are
+// given: every node of a component gets the component's level, which is one
+// more than the highest level of the components with an edge into it (1 if
+// there are none).
+//
+// Each component keeps an atomic count of its pending incoming edges. The
+// components are processed one frontier at a time: frontier k holds the
+// components whose last predecessor was in frontier k - 1, so they are at
+// level k + 1. Wide frontiers are split over the threads of `pool`; a
+// component joins the next frontier when its count drops to zero. Within a level, components come in decreasing number.
+Levelization levelize(const std::vector<uint32_t>& begin, const std::vector<int32_t>& adj,
+                      const std::vector<int32_t>& component, int32_t numComponents, ThreadPool& pool);
+
+#endif // LEVELIZER_H
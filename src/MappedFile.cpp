@@ -0,0 +1,160 @@
+#include "MappedFile.h"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+[[noreturn]] void fail(const std::string& what, const std::string& path) {
+#ifdef _WIN32
+    throw std::runtime_error(what + " " + path + ": error " + std::to_string(GetLastError()));
+#else
+    throw std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+#endif
+}
+
+// Mappings must start at a multiple of this.
+uint64_t mapAlignment() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwAllocationGranularity;
+#else
+    return static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+} // namespace
+
+MappedRange::MappedRange(MappedRange&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedRange& MappedRange::operator=(MappedRange&& other) noexcept {
+    if (this != &other) {
+        release();
+        std::swap(base, other.base);
+        std::swap(skew, other.skew);
+        std::swap(length, other.length);
+#ifdef _WIN32
+        std::swap(mapping, other.mapping);
+#endif
+    }
+    return *this;
+}
+
+MappedRange::~MappedRange() {
+    release();
+}
+
+void MappedRange::release() {
+    if (!base) return;
+#ifdef _WIN32
+    UnmapViewOfFile(base);
+    CloseHandle(mapping);
+    mapping = nullptr;
+#else
+    munmap(base, skew + length);
+#endif
+    base = nullptr;
+    skew = length = 0;
+}
+
+MappedRange MappedRange::anonymous(size_t length) {
+    MappedRange range;
+    if (length == 0) return range;
+    range.length = length;
+#ifdef _WIN32
+    const uint64_t size = length;
+    range.mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                       static_cast<DWORD>(size >> 32), static_cast<DWORD>(size), nullptr);
+    if (!range.mapping) fail("Could not map", "shared memory");
+    void* view = MapViewOfFile(range.mapping, FILE_MAP_WRITE, 0, 0, length);
+    if (!view) {
+        CloseHandle(range.mapping);
+        range.mapping = nullptr;
+        fail("Could not map", "shared memory");
+    }
+#else
+    void* view = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (view == MAP_FAILED) fail("Could not map", "shared memory");
+#endif
+    range.base = static_cast<char*>(view);
+    return range;
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+void MappedFile::open(const std::string& filePath, bool create) {
+    close();
+    path = filePath;
+#ifdef _WIN32
+    handle = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                         create ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        handle = nullptr;
+        fail("Could not open", path);
+    }
+#else
+    fd = ::open(path.c_str(), create ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDWR, 0644);
+    if (fd < 0) fail("Could not open", path);
+#endif
+}
+
+void MappedFile::close() {
+#ifdef _WIN32
+    if (handle) CloseHandle(handle);
+    handle = nullptr;
+#else
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+#endif
+}
+
+void MappedFile::resize(uint64_t bytes) {
+#ifdef _WIN32
+    LARGE_INTEGER size;
+    size.QuadPart = static_cast<LONGLONG>(bytes);
+    if (!SetFilePointerEx(handle, size, nullptr, FILE_BEGIN) || !SetEndOfFile(handle)) fail("Could not resize", path);
+#else
+    if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) fail("Could not resize", path);
+#endif
+}
+
+MappedRange MappedFile::map(uint64_t offset, size_t length, bool writable) const {
+    MappedRange range;
+    if (length == 0) return range;
+    const uint64_t aligned = offset - offset % mapAlignment();
+    range.skew = static_cast<size_t>(offset - aligned);
+    range.length = length;
+#ifdef _WIN32
+    range.mapping = CreateFileMappingA(handle, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY, 0, 0, nullptr);
+    if (!range.mapping) fail("Could not map", path);
+    void* view = MapViewOfFile(range.mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ,
+                               static_cast<DWORD>(aligned >> 32), static_cast<DWORD>(aligned),
+                               range.skew + length);
+    if (!view) {
+        CloseHandle(range.mapping);
+        range.mapping = nullptr;
+        fail("Could not map", path);
+    }
+    range.base = static_cast<char*>(view);
+#else
+    void* view = mmap(nullptr, range.skew + length, writable ? (PROT_READ | PROT_WRITE) : PROT_READ,
+                      MAP_SHARED, fd, static_cast<off_t>(aligned));
+    if (view == MAP_FAILED) fail("Could not map", path);
+    range.base = static_cast<char*>(view);
+#endif
+    return range;
+}
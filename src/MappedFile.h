@@ -0,0 +1,64 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// A memory mapping of a byte range of a file. The range need not be aligned;
+// data() points at its first byte. The mapping is released on destruction.
+class MappedRange {
+public:
+    MappedRange() = default;
+    MappedRange(MappedRange&& other) noexcept;
+    MappedRange& operator=(MappedRange&& other) noexcept;
+    MappedRange(const MappedRange&) = delete;
+    MappedRange& operator=(const MappedRange&) = delete;
+    ~MappedRange();
+
+    char* data() const { return base ? base + skew : nullptr; }
+    size_t size() const { return length; }
+
+    // Zero-filled memory not backed by a file, which stays shared with child
+    // processes created after it is mapped. Throws std::runtime_error.
+    static MappedRange anonymous(size_t length);
+
+private:
+    friend class MappedFile;
+    void release();
+
+    char* base = nullptr; // Start of the aligned mapping
+    size_t skew = 0;      // Offset of the range within the mapping
+    size_t length = 0;
+#ifdef _WIN32
+    void* mapping = nullptr;
+#endif
+};
+
+// A file opened for memory-mapped access. Throws std::runtime_error on I/O
+// errors.
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    // Opens (and with `create`, creates or truncates) the file.
+    void open(const std::string& path, bool create);
+    void close();
+    void resize(uint64_t bytes);
+
+    // Maps `length` bytes at `offset`; an empty range maps nothing.
+    MappedRange map(uint64_t offset, size_t length, bool writable) const;
+
+private:
+    std::string path;
+#ifdef _WIN32
+    void* handle = nullptr;
+#else
+    int fd = -1;
+#endif
+};
+
+#endif // MAPPED_FILE_H
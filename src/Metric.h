@@ -0,0 +1,47 @@
+#ifndef METRIC_H
+#define METRIC_H
+
+#include "DataStructures.h"
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+// Saturating arithmetic for SCOAP metric storage.
+//
+// The engine keeps every metric in a flat array of an unsigned integer type T
+// (uint16_t or uint32_t, chosen per run). The largest value of T is the INF
+// sentinel, and every addition saturates at it, so INF + x == INF and sums of
+// large finite values can never wrap around. Both operations are written
+// without branches so that the per-gate loops compile to cmov/SIMD code.
+template <typename T>
+struct Metric {
+    static_assert(std::is_unsigned<T>::value, "Metric storage must be an unsigned integer type");
+
+    using value_type = T;
+
+    static constexpr T INF = std::numeric_limits<T>::max();
+
+    // a + b, clamped to INF.
+    static constexpr T add(T a, T b) {
+        T s = static_cast<T>(a + b);
+        return static_cast<T>(s | static_cast<T>(-static_cast<int>(s < a)));
+    }
+
+    static constexpr T min(T a, T b) {
+        return b < a ? b : a;
+    }
+
+    // Converts a stored value to the int representation used by Net.
+    // Saturated values (and anything beyond the int range) become ::INF.
+    static constexpr int toInt(T v) {
+        return (v == INF || static_cast<uint64_t>(v) >= static_cast<uint64_t>(::INF))
+            ? ::INF : static_cast<int>(v);
+    }
+
+    // Converts a value from toInt back; ::INF becomes INF.
+    static constexpr T fromInt(int v) {
+        return (v >= ::INF || static_cast<uint64_t>(v) >= static_cast<uint64_t>(INF)) ? INF : static_cast<T>(v);
+    }
+};
+
+#endif // METRIC_H
@@ -0,0 +1,128 @@
+#include "MetricStats.h"
+#include <algorithm>
+#include <cmath>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+
+constexpr int kSubBits = 6;                    // 64 buckets per power of two
+constexpr uint64_t kExact = 2ull << kSubBits;  // Values below have their own bucket
+
+int highestBit(uint64_t v) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, v);
+    return static_cast<int>(index);
+#else
+    return 63 - __builtin_clzll(v);
+#endif
+}
+
+size_t bucketOf(uint64_t v) {
+    if (v < kExact) return static_cast<size_t>(v);
+    const int shift = highestBit(v) - kSubBits;
+    return (static_cast<size_t>(shift) << kSubBits) + static_cast<size_t>(v >> shift);
+}
+
+// Smallest and largest value of a bucket.
+void bucketRange(size_t b, uint64_t& low, uint64_t& high) {
+    if (b < kExact) {
+        low = high = b;
+        return;
+    }
+    const int shift = static_cast<int>(b >> kSubBits) - 1;
+    const uint64_t mantissa = b - (static_cast<uint64_t>(shift) << kSubBits);
+    low = mantissa << shift;
+    high = ((mantissa + 1) << shift) - 1;
+}
+
+} // namespace
+
+void QuantileSketch::add(uint64_t value) {
+    const size_t b = bucketOf(value);
+    if (b >= buckets.size()) buckets.resize(b + 1, 0);
+    ++buckets[b];
+    ++n;
+    lo = std::min(lo, value);
+    hi = std::max(hi, value);
+    sum += static_cast<double>(value);
+}
+
+void QuantileSketch::merge(const QuantileSketch& other) {
+    if (other.buckets.size() > buckets.size()) buckets.resize(other.buckets.size(), 0);
+    for (size_t b = 0; b < other.buckets.size(); ++b) buckets[b] += other.buckets[b];
+    n += other.n;
+    lo = std::min(lo, other.lo);
+    hi = std::max(hi, other.hi);
+    sum += other.sum;
+}
+
+uint64_t QuantileSketch::quantile(double q) const {
+    if (n == 0) return 0;
+    const uint64_t rank = std::min(n, std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * static_cast<double>(n)))));
+    uint64_t seen = 0;
+    for (size_t b = 0; b < buckets.size(); ++b) {
+        seen += buckets[b];
+        if (seen < rank) continue;
+        uint64_t low, high;
+        bucketRange(b, low, high);
+        return std::clamp(low + (high - low) / 2, min(), max());
+    }
+    return hi;
+}
+
+std::vector<uint64_t> QuantileSketch::log2Histogram() const {
+    std::vector<uint64_t> bins;
+    for (size_t b = 0; b < buckets.size(); ++b) {
+        if (buckets[b] == 0) continue;
+        uint64_t low, high;
+        bucketRange(b, low, high);
+        const size_t bin = low == 0 ? 0 : static_cast<size_t>(highestBit(low)) + 1;
+        if (bin >= bins.size()) bins.resize(bin + 1, 0);
+        bins[bin] += buckets[b];
+    }
+    return bins;
+}
+
+void MetricStats::Summary::merge(const Summary& other) {
+    finite.merge(other.finite);
+    inf += other.inf;
+}
+
+void MetricStats::add(int level, uint32_t group, const int (&values)[NumMetrics], int inf) {
+    if (level >= 0 && static_cast<size_t>(level) >= byLevel.size()) byLevel.resize(level + 1);
+    if (group >= byGroup.size()) byGroup.resize(group + 1);
+    // Each net goes to its level and its group; total() merges the levels.
+    Summaries* targets[2] = {level >= 0 ? &byLevel[level] : &noLevel, &byGroup[group]};
+    for (Summaries* t : targets) {
+        for (int m = 0; m < NumMetrics; ++m) {
+            if (values[m] == inf) ++(*t)[m].inf;
+            else (*t)[m].finite.add(static_cast<uint64_t>(values[m]));
+        }
+    }
+}
+
+namespace {
+
+void mergeAll(MetricStats::Summaries& into, const MetricStats::Summaries& from) {
+    for (int m = 0; m < MetricStats::NumMetrics; ++m) into[m].merge(from[m]);
+}
+
+} // namespace
+
+void MetricStats::merge(const MetricStats& other) {
+    mergeAll(noLevel, other.noLevel);
+    if (other.byLevel.size() > byLevel.size()) byLevel.resize(other.byLevel.size());
+    for (size_t l = 0; l < other.byLevel.size(); ++l) mergeAll(byLevel[l], other.byLevel[l]);
+    if (other.byGroup.size() > byGroup.size()) byGroup.resize(other.byGroup.size());
+    for (size_t g = 0; g < other.byGroup.size(); ++g) mergeAll(byGroup[g], other.byGroup[g]);
+}
+
+MetricStats::Summaries MetricStats::total() const {
+    Summaries t = noLevel;
+    for (const auto& level : byLevel) mergeAll(t, level);
+    return t;
+}
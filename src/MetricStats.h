@@ -0,0 +1,60 @@
+#ifndef METRIC_STATS_H
+#define METRIC_STATS_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A mergeable quantile sketch of non-negative integers. Values below 128 get
+// a bucket each; above, every power of two is split into 64 buckets, so a
+// reported quantile is within 1/64 of the true value. Buckets are counts, so
+// sketches filled on different threads merge exactly by adding them.
+class QuantileSketch {
+public:
+    void add(uint64_t value);
+    void merge(const QuantileSketch& other);
+
+    uint64_t count() const { return n; }
+    uint64_t min() const { return n ? lo : 0; }
+    uint64_t max() const { return hi; }
+    double mean() const { return n ? sum / static_cast<double>(n) : 0.0; }
+    // The q-quantile (0 <= q <= 1): the middle of the bucket holding it.
+    uint64_t quantile(double q) const;
+    // Counts in power-of-two bins: bin 0 holds 0, bin i holds [2^(i-1), 2^i).
+    std::vector<uint64_t> log2Histogram() const;
+
+private:
+    std::vector<uint64_t> buckets;
+    uint64_t n = 0, lo = UINT64_MAX, hi = 0;
+    double sum = 0.0;
+};
+
+// Distributions of the six SCOAP metrics (CC0, CC1, SC0, SC1, CO, SO) over
+// all nets, per level and per group of nets (e.g. by driver type). INF values
+// are counted apart from the sketches. Accumulate one instance per thread
+// and merge them.
+class MetricStats {
+public:
+    static constexpr int NumMetrics = 6;
+
+    struct Summary {
+        QuantileSketch finite;
+        uint64_t inf = 0;
+        void merge(const Summary& other);
+    };
+    using Summaries = std::array<Summary, NumMetrics>;
+
+    // Adds a net at `level` (-1 for none) in `group`; values equal to `inf`
+    // are INF.
+    void add(int level, uint32_t group, const int (&values)[NumMetrics], int inf);
+    void merge(const MetricStats& other);
+    // Over all nets: the levels merged with the nets without a level.
+    Summaries total() const;
+
+    Summaries noLevel;
+    std::vector<Summaries> byLevel; // Indexed by level
+    std::vector<Summaries> byGroup;
+};
+
+#endif // METRIC_STATS_H
@@ -0,0 +1,136 @@
+#include "NetName.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <mutex>
+#include <string_view>
+#include <unordered_set>
+
+namespace {
+
+// The interned base names. The set is node-based, so the strings and their
+// characters never move; they live until the process ends.
+struct Symbols {
+    std::mutex mutex;
+    std::unordered_set<std::string> names;
+};
+
+Symbols& symbols() {
+    static Symbols table;
+    return table;
+}
+
+// Formats "[<bit>]" into `buffer` (at least 16 bytes).
+std::string_view suffix(int32_t bit, char* buffer) {
+    if (bit == NetName::Scalar) return {};
+    buffer[0] = '[';
+    char* end = std::to_chars(buffer + 1, buffer + 15, bit).ptr;
+    *end++ = ']';
+    return std::string_view(buffer, static_cast<size_t>(end - buffer));
+}
+
+unsigned char at(std::string_view a, std::string_view b, size_t i) {
+    return static_cast<unsigned char>(i < a.size() ? a[i] : b[i - a.size()]);
+}
+
+} // namespace
+
+NetName::NetName(const std::string& base, int32_t bit) : bit_(bit) {
+    intern(base);
+}
+
+NetName::NetName(const std::string& text) {
+    if (text.empty()) return;
+    const size_t open = text.rfind('[');
+    if (text.back() == ']' && open != std::string::npos && open > 0 && open + 2 < text.size()) {
+        const std::string index = text.substr(open + 1, text.size() - open - 2);
+        char* end = nullptr;
+        const long bit = std::strtol(index.c_str(), &end, 10);
+        if (end == index.c_str() + index.size() && std::to_string(bit) == index && bit > Scalar && bit <= INT32_MAX) {
+            intern(text.substr(0, open));
+            bit_ = static_cast<int32_t>(bit);
+            return;
+        }
+    }
+    intern(text);
+}
+
+void NetName::intern(const std::string& base) {
+    Symbols& table = symbols();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    const std::string& stored = *table.names.insert(base).first;
+    base_ = stored.data();
+    length_ = static_cast<uint32_t>(stored.size());
+}
+
+size_t NetName::internedBytes() {
+    constexpr size_t node = 2 * sizeof(void*); // Bucket link and cached hash
+    Symbols& table = symbols();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    size_t bytes = table.names.bucket_count() * sizeof(void*);
+    for (const auto& s : table.names) bytes += node + sizeof(std::string) + (s.capacity() > 15 ? s.capacity() + 1 : 0);
+    return bytes;
+}
+
+size_t NetName::size() const {
+    char buffer[16];
+    return base().size() + suffix(bit_, buffer).size();
+}
+
+std::string NetName::str() const {
+    char buffer[16];
+    const std::string_view s = suffix(bit_, buffer);
+    std::string text(base());
+    text.append(s.data(), s.size());
+    return text;
+}
+
+// The suffixes "[a]" and "[b]" of one bus compare as their digits. For
+// non-negative indices these are compared numerically: with equal digit
+// counts directly, else the longer number's leading digits decide, and a
+// shorter number that is their prefix sorts after it (']' > '9').
+bool NetName::lessSuffix(int32_t a, int32_t b) {
+    if (a >= 0 && b >= 0) {
+        int64_t ta = a, tb = b;
+        int64_t scaleA = 1, scaleB = 1;
+        while (ta >= 10 * scaleA) scaleA *= 10;
+        while (tb >= 10 * scaleB) scaleB *= 10;
+        if (scaleA == scaleB) return a < b;
+        if (scaleA < scaleB) {
+            tb /= scaleB / scaleA;
+            return ta != tb ? ta < tb : false;
+        }
+        ta /= scaleA / scaleB;
+        return ta != tb ? ta < tb : true;
+    }
+    char bufferA[16], bufferB[16];
+    return suffix(a, bufferA) < suffix(b, bufferB);
+}
+
+// Compares the texts base + suffix without building them. Different bases
+// are usually decided within their common length; the suffixes are only
+// formatted when one base is a prefix of the other.
+bool NetName::lessText(const NetName& a, const NetName& b) {
+    std::string_view baseA = a.base(), baseB = b.base();
+    const size_t common = std::min(baseA.size(), baseB.size());
+    const int c = baseA.compare(0, common, baseB.substr(0, common));
+    if (c != 0) return c < 0;
+    baseA.remove_prefix(common);
+    baseB.remove_prefix(common);
+    char bufferA[16], bufferB[16];
+    const std::string_view suffixA = suffix(a.bit_, bufferA), suffixB = suffix(b.bit_, bufferB);
+    const size_t sizeA = baseA.size() + suffixA.size(), sizeB = baseB.size() + suffixB.size();
+    for (size_t i = 0; i < sizeA && i < sizeB; ++i) {
+        const unsigned char ca = at(baseA, suffixA, i), cb = at(baseB, suffixB, i);
+        if (ca != cb) return ca < cb;
+    }
+    return sizeA < sizeB;
+}
+
+std::ostream& operator<<(std::ostream& out, const NetName& name) {
+    if (out.width() != 0) return out << name.str(); // Pad the whole text
+    char buffer[16];
+    const std::string_view s = suffix(name.bit_, buffer);
+    out.write(name.base_, static_cast<std::streamsize>(name.length_));
+    return out.write(s.data(), static_cast<std::streamsize>(s.size()));
+}
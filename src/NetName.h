@@ -0,0 +1,83 @@
+#ifndef NET_NAME_H
+#define NET_NAME_H
+
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+// The name of a net: a scalar name, or one bit of a bus as the bus's base
+// name and a bit index. Base names are interned once per process, so a
+// NetName is a pointer to the interned characters, their length and an
+// index, and the bits of a 64-bit bus share one stored string. The text of
+// a bit, "<base>[<index>]", is only spelled out when a name is written to a
+// stream or converted with str(). Names compare and order exactly as their
+// text does.
+class NetName {
+public:
+    static constexpr int32_t Scalar = INT32_MIN;
+
+    NetName() = default;
+    // Bit `bit` of the bus `base`, or the scalar net `base` for Scalar.
+    NetName(const std::string& base, int32_t bit);
+    // A name from its text: "<base>[<index>]" is a bus bit, anything else a
+    // scalar net. The empty text is the empty name (an unconnected pin).
+    explicit NetName(const std::string& text);
+    explicit NetName(const char* text) : NetName(std::string(text)) {}
+
+    bool empty() const { return base_ == nullptr; }
+    bool isBit() const { return bit_ != Scalar; }
+    // The base name (the whole name of a scalar net).
+    std::string_view base() const { return std::string_view(base_, length_); }
+    int32_t bit() const { return bit_; }
+    // Bit `bit` of the bus with this base name, without interning it again.
+    NetName withBit(int32_t bit) const {
+        NetName n = *this;
+        n.bit_ = bit;
+        return n;
+    }
+    // Identifies the base name: equal for the bits of one bus.
+    const void* symbol() const { return base_; }
+    // The length of the text.
+    size_t size() const;
+    std::string str() const;
+
+    // Heap bytes held by the interned base names of the process.
+    static size_t internedBytes();
+
+    friend bool operator==(const NetName& a, const NetName& b) { return a.base_ == b.base_ && a.bit_ == b.bit_; }
+    friend bool operator!=(const NetName& a, const NetName& b) { return !(a == b); }
+    friend bool operator<(const NetName& a, const NetName& b) {
+        if (a.base_ == b.base_) return a.bit_ != b.bit_ && lessSuffix(a.bit_, b.bit_);
+        return lessText(a, b);
+    }
+    friend bool operator>(const NetName& a, const NetName& b) { return b < a; }
+    friend bool operator<=(const NetName& a, const NetName& b) { return !(b < a); }
+    friend bool operator>=(const NetName& a, const NetName& b) { return !(a < b); }
+    friend std::ostream& operator<<(std::ostream& out, const NetName& name);
+
+private:
+    void intern(const std::string& base);
+    // Whether the text of bit a sorts before that of bit b (distinct bits).
+    static bool lessSuffix(int32_t a, int32_t b);
+    // Whether the text of a sorts before that of b (distinct bases).
+    static bool lessText(const NetName& a, const NetName& b);
+
+    const char* base_ = nullptr; // Interned
+    uint32_t length_ = 0;
+    int32_t bit_ = Scalar;
+};
+
+namespace std {
+template <>
+struct hash<NetName> {
+    size_t operator()(const NetName& name) const {
+        return hash<const void*>()(name.symbol()) * 31 + static_cast<size_t>(static_cast<uint32_t>(name.bit()));
+    }
+};
+} // namespace std
+
+#endif // NET_NAME_H
@@ -0,0 +1,448 @@
+#include "PartitionedEngine.h"
+#include "GateKernels.h"
+#include <algorithm>
+#include <bitset>
+#include <cstring>
+#include <filesystem>
+
+namespace {
+
+template <typename V>
+void writeArray(std::ostream& out, const std::vector<V>& v) {
+    const uint64_t n = v.size();
+    out.write(reinterpret_cast<const char*>(&n), sizeof(n));
+    out.write(reinterpret_cast<const char*>(v.data()), static_cast<std::streamsize>(n * sizeof(V)));
+}
+
+template <typename V>
+const char* readArray(const char* p, std::vector<V>& v) {
+    uint64_t n;
+    std::memcpy(&n, p, sizeof(n));
+    p += sizeof(n);
+    v.resize(n);
+    std::memcpy(v.data(), p, n * sizeof(V));
+    return p + n * sizeof(V);
+}
+
+} // namespace
+
+template <typename T>
+PartitionedEngine<T>::PartitionedEngine(const std::string& dir, size_t budgetBytes, const CellLibrary* cellLibrary)
+    : directory(dir), budget(budgetBytes),
+      partitionTarget(std::max<size_t>(budgetBytes / 4, 4096)), cells(cellLibrary) {
+    std::filesystem::create_directories(directory);
+    segmentOut.open(directory + "/segments.bin", std::ios::binary | std::ios::trunc);
+    if (!segmentOut) throw std::runtime_error("Could not create " + directory + "/segments.bin");
+}
+
+template <typename T>
+PartitionedEngine<T>::~PartitionedEngine() {
+    segmentOut.close();
+    segmentFile.close();
+    metricFile.close();
+    std::error_code ec;
+    std::filesystem::remove_all(directory, ec);
+}
+
+template <typename T>
+int32_t PartitionedEngine<T>::addNet(uint8_t flags) {
+    pendingFlags.push_back(flags);
+    if ((static_cast<size_t>(netCount) >> 6) >= boundaryBits.size()) boundaryBits.push_back(0);
+    return netCount++;
+}
+
+template <typename T>
+void PartitionedEngine<T>::markBoundary(int32_t net) {
+    boundaryBits[net >> 6] |= uint64_t(1) << (net & 63);
+}
+
+template <typename T>
+int32_t PartitionedEngine<T>::boundaryIndex(int32_t net) const {
+    const uint64_t below = boundaryBits[net >> 6] & ((uint64_t(1) << (net & 63)) - 1);
+    return static_cast<int32_t>(boundaryRank[net >> 6] + std::bitset<64>(below).count());
+}
+
+// Own nets become offsets; earlier nets become (boundary) imports.
+template <typename T>
+int32_t PartitionedEngine<T>::encode(int32_t net) {
+    if (net >= pendingNetBegin) return net - pendingNetBegin;
+    auto inserted = importIndex.emplace(net, static_cast<int32_t>(pendingImports.size()));
+    if (inserted.second) {
+        pendingImports.push_back(net);
+        markBoundary(net);
+    }
+    return -(inserted.first->second + 1);
+}
+
+template <typename T>
+void PartitionedEngine<T>::addGate(uint32_t level, GateType type, int32_t cell, int32_t loop, int32_t output,
+                                   const int32_t* inputs, size_t numInputs) {
+    const uint32_t index = static_cast<uint32_t>(pending.gateType.size());
+    if (pending.gateInputBegin.empty()) pending.gateInputBegin.push_back(0);
+    pending.gateType.push_back(type);
+    pending.gateCell.push_back(cell);
+    pending.gateOutput.push_back(encode(output));
+    for (size_t i = 0; i < numInputs; ++i) pending.gateInputs.push_back(encode(inputs[i]));
+    pending.gateInputBegin.push_back(static_cast<uint32_t>(pending.gateInputs.size()));
+    pendingLoop = loop;
+    if (numInputs == 0 && type != GateType::Cell) return; // Not evaluated, as in CompactNetlist
+
+    int32_t localLoop = -1;
+    if (loop >= 0) {
+        auto inserted = loopIndex.emplace(loop, static_cast<int32_t>(pending.loops.size()));
+        if (inserted.second) {
+            const uint32_t next = static_cast<uint32_t>(pending.batches.size());
+            pending.loops.push_back({next, next, 0});
+        }
+        localLoop = inserted.first->second;
+    }
+    const uint8_t arity = arityClass(numInputs);
+    GateBatch* last = pending.batches.empty() ? nullptr : &pending.batches.back();
+    if (last && last->end == index && pendingLevel == level && last->type == type
+        && last->arity == arity && last->loop == localLoop) {
+        last->end = index + 1;
+    } else {
+        pending.batches.push_back({type, arity, index, index + 1, localLoop});
+        pendingLevel = level;
+    }
+    if (localLoop >= 0) {
+        GateLoop& l = pending.loops[localLoop];
+        l.batchEnd = static_cast<uint32_t>(pending.batches.size());
+        ++l.numGates;
+    }
+}
+
+template <typename T>
+void PartitionedEngine<T>::addFlipFlop(FlipFlopType type, int32_t clk, int32_t q, int32_t in0, int32_t in1,
+                                       int32_t en, int32_t set, int32_t rst) {
+    flipflops.ffType.push_back(type);
+    flipflops.ffClk.push_back(clk);
+    flipflops.ffQ.push_back(q);
+    flipflops.ffIn0.push_back(in0);
+    flipflops.ffIn1.push_back(in1);
+    flipflops.ffEn.push_back(en);
+    flipflops.ffSet.push_back(set);
+    flipflops.ffRst.push_back(rst);
+    flipflops.ffSource.push_back(static_cast<int32_t>(flipflops.ffSource.size()));
+    for (int32_t net : {clk, q, in0, in1, en, set, rst}) {
+        if (net >= 0) markBoundary(net);
+    }
+}
+
+// Rough size of the partition being built, as it will be when evaluated:
+// gate arrays, window metrics and the mapped metric slices.
+template <typename T>
+size_t PartitionedEngine<T>::pendingBytes() const {
+    const size_t window = pendingFlags.size() + pendingImports.size();
+    return pending.gateType.size() * (sizeof(GateType) + 3 * sizeof(int32_t))
+         + pending.gateInputs.size() * sizeof(int32_t)
+         + pending.batches.size() * sizeof(GateBatch)
+         + window * (NumMetrics * sizeof(T) + 1)
+         + pendingFlags.size() * 4 * sizeof(T)
+         + pendingImports.size() * 48;
+}
+
+template <typename T>
+void PartitionedEngine<T>::checkpoint() {
+    if (pendingBytes() >= partitionTarget) flush();
+}
+
+template <typename T>
+void PartitionedEngine<T>::flush() {
+    if (pending.gateType.empty() && pendingFlags.empty()) return;
+    const int32_t numImports = static_cast<int32_t>(pendingImports.size());
+    auto decode = [numImports](int32_t x) { return x >= 0 ? x + numImports : -x - 1; };
+    for (auto& x : pending.gateOutput) x = decode(x);
+    for (auto& x : pending.gateInputs) x = decode(x);
+    if (pending.gateInputBegin.empty()) pending.gateInputBegin.push_back(0);
+    pending.netFlags.assign(numImports, 0);
+    pending.netFlags.insert(pending.netFlags.end(), pendingFlags.begin(), pendingFlags.end());
+
+    Partition part;
+    part.offset = static_cast<uint64_t>(segmentOut.tellp());
+    part.netBegin = pendingNetBegin;
+    part.numNets = static_cast<int32_t>(pendingFlags.size());
+    writeArray(segmentOut, pendingImports);
+    writeArray(segmentOut, pending.netFlags);
+    writeArray(segmentOut, pending.gateType);
+    writeArray(segmentOut, pending.gateOutput);
+    writeArray(segmentOut, pending.gateInputBegin);
+    writeArray(segmentOut, pending.gateInputs);
+    writeArray(segmentOut, pending.gateCell);
+    writeArray(segmentOut, pending.batches);
+    writeArray(segmentOut, pending.loops);
+    if (!segmentOut) throw std::runtime_error("Could not write " + directory + "/segments.bin");
+    part.length = static_cast<uint64_t>(segmentOut.tellp()) - part.offset;
+    partitions.push_back(part);
+
+    pending = CompactNetlist();
+    pendingFlags.clear();
+    pendingImports.clear();
+    importIndex.clear();
+    loopIndex.clear();
+    pendingNetBegin = netCount;
+    pendingLoop = -1;
+}
+
+template <typename T>
+void PartitionedEngine<T>::addNetlist(const CompactNetlist& nl, std::vector<int32_t>& storageId) {
+    storageId.assign(nl.numNets(), -1);
+
+    // Nets without an evaluated driver come first.
+    std::vector<uint8_t> driven(nl.numNets(), 0);
+    for (const GateBatch& b : nl.batches) {
+        for (uint32_t g = b.begin; g < b.end; ++g) driven[nl.gateOutput[g]] = 1;
+    }
+    for (const ClockTreeEdge& e : nl.clockTree) driven[e.net] = 1;
+    for (size_t n = 0; n < nl.numNets(); ++n) {
+        if (!driven[n]) storageId[n] = addNet(nl.netFlags[n]);
+    }
+
+    auto ensure = [&](int32_t n) {
+        if (storageId[n] < 0) storageId[n] = addNet(nl.netFlags[n]);
+        return storageId[n];
+    };
+    std::vector<int32_t> inputs;
+    auto add = [&](uint32_t level, uint32_t g, int32_t loop) {
+        inputs.clear();
+        for (uint32_t i = nl.gateInputBegin[g]; i < nl.gateInputBegin[g + 1]; ++i) inputs.push_back(ensure(nl.gateInputs[i]));
+        addGate(level, nl.gateType[g], nl.gateCell[g], loop, ensure(nl.gateOutput[g]), inputs.data(), inputs.size());
+    };
+
+    for (uint32_t bi = 0; bi < nl.batches.size(); ++bi) {
+        const GateBatch& b = nl.batches[bi];
+        if (b.loop < 0) {
+            for (uint32_t g = b.begin; g < b.end; ++g) {
+                checkpoint();
+                add(bi, g, -1);
+            }
+            continue;
+        }
+        // A loop reads its own outputs, so they are numbered before its gates.
+        const GateLoop& loop = nl.loops[b.loop];
+        if (bi == loop.batchBegin) {
+            checkpoint();
+            for (uint32_t lb = loop.batchBegin; lb < loop.batchEnd; ++lb) {
+                for (uint32_t g = nl.batches[lb].begin; g < nl.batches[lb].end; ++g) ensure(nl.gateOutput[g]);
+            }
+        }
+        for (uint32_t g = b.begin; g < b.end; ++g) add(bi, g, b.loop);
+    }
+
+    // Clock trees become ordinary buffers after all other gates.
+    const uint32_t treeLevel = static_cast<uint32_t>(nl.batches.size());
+    for (size_t i = 0; i < nl.clockTree.size(); ++i) {
+        const ClockTreeEdge& e = nl.clockTree[i];
+        checkpoint();
+        const int32_t in = ensure(e.parent);
+        addGate(treeLevel + static_cast<uint32_t>(i), e.inverted ? GateType::Not : GateType::Buf, -1, -1,
+                ensure(e.net), &in, 1);
+    }
+
+    auto id = [&](int32_t n) { return n >= 0 ? ensure(n) : -1; };
+    for (size_t f = 0; f < nl.numFlipFlops(); ++f) {
+        addFlipFlop(nl.ffType[f], id(nl.ffClk[f]), id(nl.ffQ[f]), id(nl.ffIn0[f]), id(nl.ffIn1[f]),
+                    id(nl.ffEn[f]), id(nl.ffSet[f]), id(nl.ffRst[f]));
+    }
+}
+
+template <typename T>
+void PartitionedEngine<T>::finish() {
+    flush();
+    segmentOut.close();
+    segmentFile.open(directory + "/segments.bin", false);
+
+    boundaryRank.resize(boundaryBits.size());
+    uint32_t count = 0;
+    for (size_t w = 0; w < boundaryBits.size(); ++w) {
+        boundaryRank[w] = count;
+        count += static_cast<uint32_t>(std::bitset<64>(boundaryBits[w]).count());
+    }
+
+    boundaryNl = std::make_unique<CompactNetlist>();
+    boundaryNl->netFlags.assign(count, 0);
+    boundaryNl->gateInputBegin.push_back(0);
+    auto remap = [&](const std::vector<int32_t>& nets, std::vector<int32_t>& out) {
+        out.reserve(nets.size());
+        for (int32_t n : nets) out.push_back(n >= 0 ? boundaryIndex(n) : -1);
+    };
+    boundaryNl->ffType = flipflops.ffType;
+    boundaryNl->ffSource = flipflops.ffSource;
+    remap(flipflops.ffClk, boundaryNl->ffClk);
+    remap(flipflops.ffQ, boundaryNl->ffQ);
+    remap(flipflops.ffIn0, boundaryNl->ffIn0);
+    remap(flipflops.ffIn1, boundaryNl->ffIn1);
+    remap(flipflops.ffEn, boundaryNl->ffEn);
+    remap(flipflops.ffSet, boundaryNl->ffSet);
+    remap(flipflops.ffRst, boundaryNl->ffRst);
+    flipflops = CompactNetlist();
+    boundary = std::make_unique<ScoapEngine<T>>(*boundaryNl);
+
+    metricFile.open(directory + "/metrics.bin", true);
+    metricFile.resize(uint64_t(NumMetrics) * static_cast<uint64_t>(netCount) * sizeof(T));
+}
+
+template <typename T>
+size_t PartitionedEngine<T>::boundaryBytes() const {
+    return numBoundaryNets() * NumMetrics * sizeof(T)
+         + boundaryBits.size() * (sizeof(uint64_t) + sizeof(uint32_t))
+         + (boundaryNl ? boundaryNl->numFlipFlops() * 8 * sizeof(int32_t) : 0);
+}
+
+template <typename T>
+typename PartitionedEngine<T>::Segment PartitionedEngine<T>::loadSegment(size_t p) const {
+    const Partition& part = partitions[p];
+    MappedRange range = segmentFile.map(part.offset, part.length, false);
+    Segment seg;
+    const char* ptr = range.data();
+    ptr = readArray(ptr, seg.imports);
+    ptr = readArray(ptr, seg.nl.netFlags);
+    ptr = readArray(ptr, seg.nl.gateType);
+    ptr = readArray(ptr, seg.nl.gateOutput);
+    ptr = readArray(ptr, seg.nl.gateInputBegin);
+    ptr = readArray(ptr, seg.nl.gateInputs);
+    ptr = readArray(ptr, seg.nl.gateCell);
+    ptr = readArray(ptr, seg.nl.batches);
+    readArray(ptr, seg.nl.loops);
+    seg.nl.cells = cells;
+
+    seg.drivenImport.assign(seg.imports.size(), 0);
+    for (int32_t out : seg.nl.gateOutput) {
+        if (static_cast<size_t>(out) < seg.imports.size()) seg.drivenImport[out] = 1;
+    }
+    return seg;
+}
+
+template <typename T>
+MappedRange PartitionedEngine<T>::mapMetric(size_t p, int metric, bool writable) const {
+    const Partition& part = partitions[p];
+    const uint64_t offset = (uint64_t(metric) * static_cast<uint64_t>(netCount) + static_cast<uint64_t>(part.netBegin)) * sizeof(T);
+    return metricFile.map(offset, static_cast<size_t>(part.numNets) * sizeof(T), writable);
+}
+
+// Runs one pass over partition p. Window values come from the boundary
+// metrics (imports and own boundary nets) and from the metric file (own
+// nets); afterwards own nets go back to the file and boundary nets back to
+// the boundary metrics. `first` marks the first stream of a fixpoint, when
+// the file holds no values of the pass yet.
+template <typename T>
+void PartitionedEngine<T>::evaluate(size_t p, Pass pass, bool first) {
+    Segment seg = loadSegment(p);
+    ScoapEngine<T> e(seg.nl);
+    ScoapEngine<T>& b = *boundary;
+    const Partition& part = partitions[p];
+    const size_t numImports = seg.imports.size();
+    const size_t numOwn = static_cast<size_t>(part.numNets);
+
+    std::vector<int32_t> importIndexOf(numImports);
+    for (size_t i = 0; i < numImports; ++i) importIndexOf[i] = boundaryIndex(seg.imports[i]);
+    std::vector<int32_t> ownIndexOf(numOwn, -1);
+    for (size_t i = 0; i < numOwn; ++i) {
+        const int32_t net = part.netBegin + static_cast<int32_t>(i);
+        if (isBoundary(net)) ownIndexOf[i] = boundaryIndex(net);
+    }
+
+    auto gather = [&](std::vector<T>& window, const std::vector<T>& values) {
+        for (size_t i = 0; i < numImports; ++i) window[i] = values[importIndexOf[i]];
+        for (size_t i = 0; i < numOwn; ++i) {
+            if (ownIndexOf[i] >= 0) window[numImports + i] = M::min(window[numImports + i], values[ownIndexOf[i]]);
+        }
+    };
+    auto load = [&](std::vector<T>& window, int metric) {
+        MappedRange range = mapMetric(p, metric, false);
+        const T* values = reinterpret_cast<const T*>(range.data());
+        for (size_t i = 0; i < numOwn; ++i) window[numImports + i] = values[i];
+    };
+    auto store = [&](const std::vector<T>& window, int metric) {
+        MappedRange range = mapMetric(p, metric, true);
+        T* values = reinterpret_cast<T*>(range.data());
+        for (size_t i = 0; i < numOwn; ++i) values[i] = window[numImports + i];
+    };
+    // Forward passes write back the imports the partition drives; backward
+    // passes write back every import, since observability flows to inputs.
+    auto scatter = [&](const std::vector<T>& window, std::vector<T>& values, bool allImports, bool merge) {
+        for (size_t i = 0; i < numImports; ++i) {
+            if (!allImports && !seg.drivenImport[i]) continue;
+            T& v = values[importIndexOf[i]];
+            v = merge ? M::min(v, window[i]) : window[i];
+        }
+        for (size_t i = 0; i < numOwn; ++i) {
+            if (ownIndexOf[i] < 0) continue;
+            T& v = values[ownIndexOf[i]];
+            v = merge ? M::min(v, window[numImports + i]) : window[numImports + i];
+        }
+    };
+
+    switch (pass) {
+    case Pass::CC:
+        gather(e.cc0, b.cc0);
+        gather(e.cc1, b.cc1);
+        e.computeCombinationalControllability();
+        store(e.cc0, CC0);
+        store(e.cc1, CC1);
+        scatter(e.cc0, b.cc0, false, false);
+        scatter(e.cc1, b.cc1, false, false);
+        break;
+    case Pass::SC:
+        if (!first) {
+            load(e.sc0, SC0);
+            load(e.sc1, SC1);
+        }
+        gather(e.sc0, b.sc0);
+        gather(e.sc1, b.sc1);
+        e.computeSequentialControllability();
+        store(e.sc0, SC0);
+        store(e.sc1, SC1);
+        scatter(e.sc0, b.sc0, false, true);
+        scatter(e.sc1, b.sc1, false, true);
+        break;
+    case Pass::CO:
+        load(e.cc0, CC0);
+        load(e.cc1, CC1);
+        gather(e.cc0, b.cc0);
+        gather(e.cc1, b.cc1);
+        gather(e.co, b.co);
+        e.computeCombinationalObservability();
+        store(e.co, CO);
+        scatter(e.co, b.co, true, true);
+        break;
+    case Pass::SO:
+        load(e.sc0, SC0);
+        load(e.sc1, SC1);
+        gather(e.sc0, b.sc0);
+        gather(e.sc1, b.sc1);
+        if (!first) load(e.so, SO);
+        gather(e.so, b.so);
+        e.computeSequentialObservability();
+        store(e.so, SO);
+        scatter(e.so, b.so, true, true);
+        break;
+    }
+    cappedLoops += e.cappedLoops;
+}
+
+// CC and CO take one stream each. The sequential fixpoints alternate a
+// stream over all partitions with one round of the flip-flop rules on the
+// boundary nets, until the flip-flops no longer change.
+template <typename T>
+void PartitionedEngine<T>::computeAll() {
+    const size_t n = partitions.size();
+    for (size_t p = 0; p < n; ++p) evaluate(p, Pass::CC, true);
+
+    bool first = true;
+    do {
+        for (size_t p = 0; p < n; ++p) evaluate(p, Pass::SC, first);
+        first = false;
+    } while (boundary->stepFlipFlopControllability());
+
+    for (size_t p = n; p-- > 0;) evaluate(p, Pass::CO, true);
+
+    first = true;
+    do {
+        for (size_t p = n; p-- > 0;) evaluate(p, Pass::SO, first);
+        first = false;
+    } while (boundary->stepFlipFlopObservability());
+}
+
+template class PartitionedEngine<uint16_t>;
+template class PartitionedEngine<uint32_t>;
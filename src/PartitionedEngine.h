@@ -0,0 +1,162 @@
+#ifndef PARTITIONED_ENGINE_H
+#define PARTITIONED_ENGINE_H
+
+#include "CompactNetlist.h"
+#include "MappedFile.h"
+#include "Metric.h"
+#include "ScoapEngine.h"
+#include <fstream>
+#include <memory>
+#include <unordered_map>
+
+// Out-of-core SCOAP engine for netlists whose gates and metrics do not fit
+// in memory.
+//
+// The netlist is added gate by gate in evaluation order and cut into
+// partitions, each a run of consecutive gates sized to a quarter of the
+// memory budget. A partition is stored as a small CompactNetlist in a segment
+// file: its own nets, plus the nets it reads from earlier partitions
+// (imports). The metrics of every net live in a metric file. Both are
+// memory-mapped only while their partition is evaluated, by a ScoapEngine
+// over the partition: CC and SC stream over the partitions forwards, CO and
+// SO backwards.
+//
+// Only the boundary nets stay in memory between partitions: nets read
+// outside the partition that owns them, and every flip-flop pin. They are
+// held by a ScoapEngine over the boundary nets, which also runs the
+// flip-flop rules between the streams of the sequential fixpoints.
+template <typename T>
+class PartitionedEngine {
+public:
+    using M = Metric<T>;
+
+    // Files are kept in `directory`, which is created and removed again.
+    PartitionedEngine(const std::string& directory, size_t budgetBytes, const CellLibrary* cells = nullptr);
+    ~PartitionedEngine();
+    PartitionedEngine(const PartitionedEngine&) = delete;
+    PartitionedEngine& operator=(const PartitionedEngine&) = delete;
+
+    // --- Building ---
+    // Nets are numbered in the order they are added and must be added before
+    // a gate reads them. Gates must come in evaluation order. Consecutive
+    // gates share a batch only if they have the same `level`, and the gates
+    // of a loop must be consecutive.
+
+    // Adds a net with CompactNetlist flags and returns its id.
+    int32_t addNet(uint8_t flags);
+    void addGate(uint32_t level, GateType type, int32_t cell, int32_t loop, int32_t output,
+                 const int32_t* inputs, size_t numInputs);
+    void addFlipFlop(FlipFlopType type, int32_t clk, int32_t q, int32_t in0, int32_t in1,
+                     int32_t en, int32_t set, int32_t rst);
+    // Starts a new partition if the current one has reached its share of the
+    // budget. Call only between gates, and never inside a loop.
+    void checkpoint();
+
+    // Adds a whole CompactNetlist. storageId receives the id of each of its nets.
+    void addNetlist(const CompactNetlist& nl, std::vector<int32_t>& storageId);
+
+    // Writes the last partition and sets up the boundary nets. Call once,
+    // after building and before computing.
+    void finish();
+
+    // --- Computing ---
+    void computeAll();
+
+    // Calls f(net, cc0, cc1, sc0, sc1, co, so) for every net in id order.
+    template <typename F>
+    void forEachNet(F f) const;
+
+    size_t numNets() const { return netCount; }
+    size_t numPartitions() const { return partitions.size(); }
+    size_t numBoundaryNets() const { return boundaryNl ? boundaryNl->numNets() : 0; }
+    // Memory held between partitions: boundary metrics and the boundary index.
+    size_t boundaryBytes() const;
+    size_t partitionBytes() const { return partitionTarget; }
+
+    // Combinational loop evaluations stopped by the iteration bound.
+    size_t cappedLoops = 0;
+
+private:
+    enum class Pass { CC, SC, CO, SO };
+    enum MetricIndex { CC0, CC1, SC0, SC1, CO, SO, NumMetrics };
+
+    struct Partition {
+        uint64_t offset, length; // Segment bytes
+        int32_t netBegin, numNets;
+    };
+
+    // A partition loaded from its segment. Window nets are the imports
+    // followed by the partition's own nets.
+    struct Segment {
+        CompactNetlist nl;
+        std::vector<int32_t> imports;
+        std::vector<uint8_t> drivenImport; // Imports driven by a gate of the partition
+    };
+
+    int32_t encode(int32_t net);
+    void flush();
+    size_t pendingBytes() const;
+    void markBoundary(int32_t net);
+    bool isBoundary(int32_t net) const { return (boundaryBits[net >> 6] >> (net & 63)) & 1u; }
+    int32_t boundaryIndex(int32_t net) const;
+    Segment loadSegment(size_t p) const;
+    MappedRange mapMetric(size_t p, int metric, bool writable) const;
+    void evaluate(size_t p, Pass pass, bool first);
+
+    std::string directory;
+    size_t budget;
+    size_t partitionTarget;
+    const CellLibrary* cells;
+    int32_t netCount = 0;
+
+    // Partition being built. Its gate inputs and outputs are encoded as
+    // offsets into its own nets (>= 0) or as -(import index + 1).
+    CompactNetlist pending;
+    std::vector<uint8_t> pendingFlags;
+    std::vector<int32_t> pendingImports;
+    std::unordered_map<int32_t, int32_t> importIndex;
+    std::unordered_map<int32_t, int32_t> loopIndex;
+    int32_t pendingNetBegin = 0;
+    uint32_t pendingLevel = 0;
+    int32_t pendingLoop = -1;
+
+    std::vector<Partition> partitions;
+    std::ofstream segmentOut;
+    MappedFile segmentFile;
+    MappedFile metricFile;
+
+    // One bit per net, and the number of set bits before each 64-bit word.
+    std::vector<uint64_t> boundaryBits;
+    std::vector<uint32_t> boundaryRank;
+
+    // Flip-flops by net id while building; boundaryNl re-indexes them by
+    // boundary index. boundary holds the boundary metrics.
+    CompactNetlist flipflops;
+    std::unique_ptr<CompactNetlist> boundaryNl;
+    std::unique_ptr<ScoapEngine<T>> boundary;
+};
+
+template <typename T>
+template <typename F>
+void PartitionedEngine<T>::forEachNet(F f) const {
+    for (size_t p = 0; p < partitions.size(); ++p) {
+        MappedRange ranges[NumMetrics];
+        const T* values[NumMetrics];
+        for (int m = 0; m < NumMetrics; ++m) {
+            ranges[m] = mapMetric(p, m, false);
+            values[m] = reinterpret_cast<const T*>(ranges[m].data());
+        }
+        const Partition& part = partitions[p];
+        for (int32_t i = 0; i < part.numNets; ++i) {
+            const int32_t net = part.netBegin + i;
+            if (isBoundary(net)) {
+                const int32_t b = boundaryIndex(net);
+                f(net, boundary->cc0[b], boundary->cc1[b], boundary->sc0[b], boundary->sc1[b], boundary->co[b], boundary->so[b]);
+            } else {
+                f(net, values[CC0][i], values[CC1][i], values[SC0][i], values[SC1][i], values[CO][i], values[SO][i]);
+            }
+        }
+    }
+}
+
+#endif // PARTITIONED_ENGINE_H
@@ -0,0 +1,151 @@
+#include "ResultCache.h"
+#include "NetName.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+namespace {
+
+constexpr char kMagic[8] = {'S', 'C', 'O', 'A', 'P', 'R', 'E', 'S'};
+constexpr char kCheckpointMagic[8] = {'S', 'C', 'O', 'A', 'P', 'C', 'K', 'P'};
+
+// Final mix of a 64-bit hash (splitmix64), so that summed record hashes
+// do not cancel out in structured ways.
+uint64_t mix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t hi, lo;
+    uint64_t nets;
+};
+
+// Reads a file of `perNet` values per net written by writeEntry, if it has
+// the magic, version and key and holds `nets` nets.
+bool readEntry(const std::string& path, const char (&magic)[8], const CacheKey& key, size_t nets, size_t perNet,
+               std::vector<int32_t>& values) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    Header h;
+    if (!in.read(reinterpret_cast<char*>(&h), sizeof(h))) return false;
+    if (std::memcmp(h.magic, magic, sizeof(magic)) != 0 || h.version != ResultCache::ToolVersion
+        || h.hi != key.hi || h.lo != key.lo || h.nets != nets) {
+        return false;
+    }
+    values.resize(nets * perNet);
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(values.data()),
+                                     static_cast<std::streamsize>(values.size() * sizeof(int32_t))));
+}
+
+// Writes the values to a temporary file and renames it to `path`, so that
+// readers never see a partial file.
+bool writeEntry(const std::string& path, const char (&magic)[8], const CacheKey& key, size_t perNet,
+                const std::vector<int32_t>& values) {
+    std::error_code ec;
+    const std::string temp = path + ".tmp" + std::to_string(std::random_device()());
+    {
+        std::ofstream out(temp, std::ios::binary);
+        Header h;
+        std::memcpy(h.magic, magic, sizeof(magic));
+        h.version = ResultCache::ToolVersion;
+        h.reserved = 0;
+        h.hi = key.hi;
+        h.lo = key.lo;
+        h.nets = values.size() / perNet;
+        out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        out.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(int32_t)));
+        if (!out) {
+            out.close();
+            std::filesystem::remove(temp, ec);
+            return false;
+        }
+    }
+    std::filesystem::rename(temp, path, ec);
+    if (ec) {
+        std::filesystem::remove(temp, ec);
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+std::string CacheKey::hex() const {
+    char text[33];
+    std::snprintf(text, sizeof(text), "%016llx%016llx", static_cast<unsigned long long>(hi), static_cast<unsigned long long>(lo));
+    return text;
+}
+
+StructuralHasher& StructuralHasher::field(const std::string& s) {
+    field(static_cast<uint64_t>(s.size()));
+    bytes(s.data(), s.size());
+    return *this;
+}
+
+StructuralHasher& StructuralHasher::field(const NetName& name) {
+    field(static_cast<uint64_t>(name.size()));
+    bytes(name.base().data(), name.base().size());
+    if (name.isBit()) {
+        char suffix[16];
+        const int n = std::snprintf(suffix, sizeof(suffix), "[%d]", static_cast<int>(name.bit()));
+        bytes(suffix, static_cast<size_t>(n));
+    }
+    return *this;
+}
+
+StructuralHasher& StructuralHasher::field(uint64_t v) {
+    unsigned char le[8];
+    for (int i = 0; i < 8; ++i) le[i] = static_cast<unsigned char>(v >> (8 * i));
+    bytes(le, sizeof(le));
+    return *this;
+}
+
+void StructuralHasher::endRecord() {
+    sum.hi += mix(a);
+    sum.lo += mix(b ^ 0x9e3779b97f4a7c15ull);
+    a = kBasisA;
+    b = kBasisB;
+}
+
+// Two independent streams: `a` is FNV-1a, `b` adds each byte, multiplies by
+// a different odd constant and rotates the high bits back down, so the two
+// halves of the key do not follow each other.
+void StructuralHasher::bytes(const void* data, size_t size) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        a = (a ^ p[i]) * 0x100000001b3ull;
+        b = (b + p[i]) * 0x9fb21c651e98df25ull;
+        b = (b << 23) | (b >> 41);
+    }
+}
+
+std::string ResultCache::path(const CacheKey& key) const {
+    return (std::filesystem::path(dir) / (key.hex() + ".scoap")).string();
+}
+
+bool ResultCache::load(const CacheKey& key, size_t nets, std::vector<int32_t>& metrics) const {
+    return readEntry(path(key), kMagic, key, nets, 6, metrics);
+}
+
+bool ResultCache::store(const CacheKey& key, const std::vector<int32_t>& metrics) const {
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    return writeEntry(path(key), kMagic, key, 6, metrics);
+}
+
+bool Checkpoint::load(const CacheKey& key, size_t nets, std::vector<int32_t>& values) const {
+    return readEntry(file, kCheckpointMagic, key, nets, 3, values);
+}
+
+bool Checkpoint::store(const CacheKey& key, const std::vector<int32_t>& values) const {
+    return writeEntry(file, kCheckpointMagic, key, 3, values);
+}
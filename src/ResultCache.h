@@ -0,0 +1,78 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class NetName;
+
+// A 128-bit key of an analysis: the structure of the netlist, the options
+// that affect the results, and the tool version.
+struct CacheKey {
+    uint64_t hi = 0, lo = 0;
+    std::string hex() const;
+};
+
+// Builds an order-insensitive CacheKey from records (a gate, a net, an
+// option...). Each record is hashed on its own, with its fields length-
+// prefixed, and the record hashes are summed, so the key does not depend on
+// the order in which records are added but does count repeated records.
+class StructuralHasher {
+public:
+    StructuralHasher& field(const std::string& s);
+    // Hashes the text of the name, as field(name.str()) does.
+    StructuralHasher& field(const NetName& name);
+    StructuralHasher& field(uint64_t v);
+    // Ends the current record and adds it to the key.
+    void endRecord();
+    CacheKey key() const { return sum; }
+
+private:
+    void bytes(const void* data, size_t size);
+    uint64_t a = kBasisA, b = kBasisB;
+    CacheKey sum;
+    static constexpr uint64_t kBasisA = 0xcbf29ce484222325ull;
+    static constexpr uint64_t kBasisB = 0x84222325cbf29ce4ull;
+};
+
+// On-disk cache of SCOAP results, one file per key in a directory. A file
+// holds the six metrics of every net in net map order. Files are written
+// to a temporary name and renamed, so concurrent runs sharing a cache never
+// read a partial entry.
+class ResultCache {
+public:
+    // Part of every key; bump when a change alters the computed metrics.
+    static constexpr uint32_t ToolVersion = 1;
+
+    explicit ResultCache(std::string directory) : dir(std::move(directory)) {}
+
+    // Reads the metrics (6 per net) of `key` if present for `nets` nets.
+    bool load(const CacheKey& key, size_t nets, std::vector<int32_t>& metrics) const;
+    bool store(const CacheKey& key, const std::vector<int32_t>& metrics) const;
+
+private:
+    std::string path(const CacheKey& key) const;
+    std::string dir;
+};
+
+// A snapshot of the sequential passes of an analysis, from which an
+// interrupted run can be resumed: SC0, SC1 and SO of every net in net map
+// order (3 per net) after some round of their fixpoint iteration, which are
+// upper bounds of the final values. Stored like the cache entries under the
+// key of the analysis, so that it is only resumed for the same netlist and
+// options, and replaced atomically, so that a run killed while saving keeps
+// the previous snapshot.
+class Checkpoint {
+public:
+    explicit Checkpoint(std::string filename) : file(std::move(filename)) {}
+
+    // Reads the values (3 per net) if the file holds `nets` nets of `key`.
+    bool load(const CacheKey& key, size_t nets, std::vector<int32_t>& values) const;
+    bool store(const CacheKey& key, const std::vector<int32_t>& values) const;
+
+private:
+    std::string file;
+};
+
+#endif // RESULT_CACHE_H
@@ -0,0 +1,520 @@
+#include "ScoapEngine.h"
+#include "GateKernels.h"
+#include <algorithm>
+#include <atomic>
+
+namespace {
+
+// Evaluates the controllability of every gate in one batch. With Merge the
+// outputs are min-merged (sequential fixpoint); otherwise they are assigned.
+// With by0/by1, the gate that set each value is recorded. Returns true if a
+// merged output improved.
+template <GateType G, int A, bool Merge, typename T>
+bool forwardBatch(const CompactNetlist& nl, const GateBatch& b, T bias, T* v0, T* v1,
+                  int32_t* by0 = nullptr, int32_t* by1 = nullptr) {
+    using M = Metric<T>;
+    const uint32_t* begin = nl.gateInputBegin.data();
+    const int32_t* inputs = nl.gateInputs.data();
+    bool changed = false;
+    for (uint32_t g = b.begin; g < b.end; ++g) {
+        T out0, out1;
+        const CellRule* cell = GateRule<G>::cell ? nl.cellRule(g) : nullptr;
+        if (!ControllabilityKernel<G, A>::eval(inputs + begin[g], begin[g + 1] - begin[g], v0, v1, out0, out1, cell)) continue;
+        out0 = M::add(out0, bias);
+        out1 = M::add(out1, bias);
+        const int32_t out = nl.gateOutput[g];
+        if constexpr (Merge) {
+            if (out0 < v0[out]) { v0[out] = out0; changed = true; if (by0) by0[out] = static_cast<int32_t>(g); }
+            if (out1 < v1[out]) { v1[out] = out1; changed = true; if (by1) by1[out] = static_cast<int32_t>(g); }
+        } else {
+            v0[out] = out0;
+            v1[out] = out1;
+            if (by0) {
+                by0[out] = static_cast<int32_t>(g);
+                by1[out] = static_cast<int32_t>(g);
+            }
+        }
+    }
+    return changed;
+}
+
+// Propagates observability from the outputs to the inputs of every gate in
+// one batch, in reverse order. With `by`, the gate through which each input
+// got its value is recorded. Returns true if any input improved.
+template <GateType G, int A, typename T>
+bool backwardBatch(const CompactNetlist& nl, const GateBatch& b, T bias, const T* v0, const T* v1, T* obs, T* scratch,
+                   int32_t* by = nullptr) {
+    const uint32_t* begin = nl.gateInputBegin.data();
+    const int32_t* inputs = nl.gateInputs.data();
+    bool changed = false;
+    std::vector<T> before;
+    for (uint32_t g = b.end; g-- > b.begin;) {
+        T obsY = obs[nl.gateOutput[g]];
+        if (obsY == Metric<T>::INF) continue;
+        const CellRule* cell = GateRule<G>::cell ? nl.cellRule(g) : nullptr;
+        if (by) {
+            before.clear();
+            for (uint32_t i = begin[g]; i < begin[g + 1]; ++i) before.push_back(obs[inputs[i]]);
+        }
+        changed |= ObservabilityKernel<G, A>::eval(inputs + begin[g], begin[g + 1] - begin[g], obsY, bias, v0, v1, obs, scratch, cell);
+        if (by) {
+            for (uint32_t i = begin[g]; i < begin[g + 1]; ++i) {
+                if (obs[inputs[i]] < before[i - begin[g]]) by[inputs[i]] = static_cast<int32_t>(g);
+            }
+        }
+    }
+    return changed;
+}
+
+// Calls eval(batch, inLoop) for every batch in evaluation order, or in reverse
+// order. The batches of a combinational loop are swept again until eval
+// reports no change. Every SCOAP rule is at least as large as each input it
+// depends on, so each sweep settles at least one more value of the loop. A
+// gate has two (its output's 0 and 1 controllability), and a chain through
+// both polarities of every gate (e.g. the CC0 of one net feeding the CC1 of
+// the next) settles one value per sweep, so 2 * numGates + 1 sweeps always
+// suffice; loops that still change after that are counted in `capped`.
+// Returns true if any eval reported a change.
+template <bool Reverse, typename Eval>
+bool sweepBatches(const CompactNetlist& nl, std::atomic<size_t>& capped, Eval eval) {
+    const size_t numBatches = nl.batches.size();
+    bool changed = false;
+    for (size_t step = 0; step < numBatches;) {
+        const size_t b = Reverse ? numBatches - 1 - step : step;
+        const int32_t loopId = nl.batches[b].loop;
+        if (loopId < 0) {
+            changed |= eval(nl.batches[b], false);
+            ++step;
+            continue;
+        }
+        const GateLoop& loop = nl.loops[loopId];
+        bool loopChanged = true;
+        for (uint32_t round = 0; loopChanged && round <= 2 * loop.numGates; ++round) {
+            loopChanged = false;
+            for (uint32_t i = 0; i < loop.batchEnd - loop.batchBegin; ++i) {
+                const uint32_t lb = Reverse ? loop.batchEnd - 1 - i : loop.batchBegin + i;
+                loopChanged |= eval(nl.batches[lb], true);
+            }
+            changed |= loopChanged;
+        }
+        if (loopChanged) ++capped;
+        step += loop.batchEnd - loop.batchBegin;
+    }
+    return changed;
+}
+
+// Selects clock tree edges by whether their values are fixed.
+enum class EdgeSet { Fixed, Derived, All };
+
+inline bool selected(const ClockTreeEdge& e, EdgeSet set) {
+    return set == EdgeSet::All || e.fixed == (set == EdgeSet::Fixed);
+}
+
+// Trace pointer of clock tree edge e (see ScoapEngine::cc0By).
+inline int32_t edgePointer(size_t e) { return -2 - static_cast<int32_t>(e); }
+
+// Propagates controllability down the selected clock tree edges, from the
+// roots to the leaves. Returns true if a value improved.
+template <typename T>
+bool forwardClockTree(const CompactNetlist& nl, EdgeSet set, T bias, T* v0, T* v1,
+                      int32_t* by0 = nullptr, int32_t* by1 = nullptr) {
+    using M = Metric<T>;
+    bool changed = false;
+    for (size_t i = 0; i < nl.clockTree.size(); ++i) {
+        const ClockTreeEdge& e = nl.clockTree[i];
+        if (!selected(e, set)) continue;
+        const T out0 = M::add(e.inverted ? v1[e.parent] : v0[e.parent], bias);
+        const T out1 = M::add(e.inverted ? v0[e.parent] : v1[e.parent], bias);
+        if (out0 < v0[e.net]) { v0[e.net] = out0; changed = true; if (by0) by0[e.net] = edgePointer(i); }
+        if (out1 < v1[e.net]) { v1[e.net] = out1; changed = true; if (by1) by1[e.net] = edgePointer(i); }
+    }
+    return changed;
+}
+
+// Propagates observability up the selected clock tree edges, from the leaves
+// to the roots. Returns true if a value improved.
+template <typename T>
+bool backwardClockTree(const CompactNetlist& nl, EdgeSet set, T bias, T* obs, int32_t* by = nullptr) {
+    using M = Metric<T>;
+    bool changed = false;
+    for (size_t i = nl.clockTree.size(); i-- > 0;) {
+        const ClockTreeEdge& e = nl.clockTree[i];
+        if (!selected(e, set)) continue;
+        const T value = M::add(obs[e.net], bias);
+        if (value < obs[e.parent]) { obs[e.parent] = value; changed = true; if (by) by[e.parent] = edgePointer(i); }
+    }
+    return changed;
+}
+
+// Sequential controllability of the Q output of flip-flop f from the current
+// SC values. A clocked transition costs one time frame, the clock (`clock`,
+// SC0 + SC1 of the clock pin), and holding
+// the enable (at 1) and the asynchronous set/reset (at 0). Asynchronous
+// set/reset reach their value in one time frame without the clock.
+template <typename T>
+void flipFlopControllability(const CompactNetlist& nl, size_t f, T clock, const T* sc0, const T* sc1, T& q0, T& q1) {
+    using M = Metric<T>;
+    const int32_t a = nl.ffIn0[f], b = nl.ffIn1[f], q = nl.ffQ[f];
+    const int32_t en = nl.ffEn[f], set = nl.ffSet[f], rst = nl.ffRst[f];
+    const T setOff = set >= 0 ? sc0[set] : T(0);
+    const T rstOff = rst >= 0 ? sc0[rst] : T(0);
+
+    T frame = M::add(clock, 1);
+    if (en >= 0) frame = M::add(frame, sc1[en]);
+    frame = M::add(M::add(frame, setOff), rstOff);
+
+    switch (nl.ffType[f]) {
+    case FlipFlopType::D:
+        q0 = sc0[a];
+        q1 = sc1[a];
+        break;
+    case FlipFlopType::T: // Toggle from the opposite state.
+        q0 = M::add(sc1[q], sc1[a]);
+        q1 = M::add(sc0[q], sc1[a]);
+        break;
+    case FlipFlopType::JK: // Reset/set, or toggle from the opposite state.
+        q0 = M::min(M::add(sc0[a], sc1[b]), M::add(M::add(sc1[q], sc1[a]), sc1[b]));
+        q1 = M::min(M::add(sc1[a], sc0[b]), M::add(M::add(sc0[q], sc1[a]), sc1[b]));
+        break;
+    case FlipFlopType::SR:
+        q0 = M::add(sc0[a], sc1[b]);
+        q1 = M::add(sc1[a], sc0[b]);
+        break;
+    case FlipFlopType::Unknown:
+        q0 = q1 = M::INF;
+        break;
+    }
+    q0 = M::add(q0, frame);
+    q1 = M::add(q1, frame);
+
+    if (rst >= 0) q0 = M::min(q0, M::add(M::add(sc1[rst], setOff), 1));
+    if (set >= 0) q1 = M::min(q1, M::add(M::add(sc1[set], rstOff), 1));
+}
+
+// Sequential observability of the input pins of flip-flop f from the SO of
+// its Q output: a pin is observed when its value decides the next state.
+// `clock` is SC0 + SC1 of the clock pin. Returns true if any pin improved.
+template <typename T>
+bool flipFlopObservability(const CompactNetlist& nl, size_t f, T clock, const T* sc0, const T* sc1, T* so) {
+    using M = Metric<T>;
+    const int32_t a = nl.ffIn0[f], b = nl.ffIn1[f], q = nl.ffQ[f];
+    const int32_t en = nl.ffEn[f], set = nl.ffSet[f], rst = nl.ffRst[f];
+    const T soQ = so[q];
+    if (soQ == M::INF) return false;
+
+    bool changed = false;
+    auto merge = [&](int32_t net, T value) {
+        if (value < so[net]) { so[net] = value; changed = true; }
+    };
+    const T setOff = set >= 0 ? sc0[set] : T(0);
+    const T rstOff = rst >= 0 ? sc0[rst] : T(0);
+    const T asyncOff = M::add(setOff, rstOff);
+    const T base = M::add(M::add(soQ, clock), 1);
+    const T frame = M::add(M::add(base, en >= 0 ? sc1[en] : T(0)), asyncOff);
+
+    // Cost of an enabled clock edge changing the state, for the enable pin.
+    T change = M::INF;
+    switch (nl.ffType[f]) {
+    case FlipFlopType::D:
+        merge(a, frame);
+        change = M::min(M::add(sc0[a], sc1[q]), M::add(sc1[a], sc0[q]));
+        break;
+    case FlipFlopType::T: {
+        const T known = M::min(sc0[q], sc1[q]);
+        merge(a, M::add(frame, known));
+        change = M::add(sc1[a], known);
+        break;
+    }
+    case FlipFlopType::JK: // With Q = 0 the next state is J; with Q = 1 it is !K.
+        merge(a, M::add(frame, sc0[q]));
+        merge(b, M::add(frame, sc1[q]));
+        change = M::min(M::add(M::add(sc1[a], sc0[b]), sc0[q]), M::add(M::add(sc0[a], sc1[b]), sc1[q]));
+        break;
+    case FlipFlopType::SR:
+        merge(a, M::add(M::add(frame, sc0[b]), sc0[q]));
+        merge(b, M::add(M::add(frame, sc0[a]), sc1[q]));
+        change = M::min(M::add(M::add(sc1[a], sc0[b]), sc0[q]), M::add(M::add(sc0[a], sc1[b]), sc1[q]));
+        break;
+    case FlipFlopType::Unknown:
+        break;
+    }
+    if (en >= 0) merge(en, M::add(M::add(base, asyncOff), change));
+    if (rst >= 0) merge(rst, M::add(M::add(M::add(soQ, sc1[q]), setOff), 1));
+    if (set >= 0) merge(set, M::add(M::add(M::add(soQ, sc0[q]), rstOff), 1));
+    return changed;
+}
+
+} // namespace
+
+template <typename T>
+ScoapEngine<T>::ScoapEngine(const CompactNetlist& netlist)
+    : cc0(netlist.numNets(), M::INF), cc1(netlist.numNets(), M::INF),
+      sc0(netlist.numNets(), M::INF), sc1(netlist.numNets(), M::INF),
+      co(netlist.numNets(), M::INF), so(netlist.numNets(), M::INF),
+      nl(netlist) {
+    uint32_t widest = 1;
+    for (size_t g = 0; g < nl.numGates(); ++g) {
+        widest = std::max(widest, nl.gateInputBegin[g + 1] - nl.gateInputBegin[g]);
+    }
+    scratch.resize(widest);
+}
+
+// Calculates CC0 and CC1 for all nets in a single levelized sweep.
+template <typename T>
+void ScoapEngine<T>::computeCombinationalControllability() {
+    for (size_t n = 0; n < nl.numNets(); ++n) {
+        if (nl.netFlags[n] & (CompactNetlist::PrimaryInput | CompactNetlist::FlipFlopOutput)) {
+            cc0[n] = 1;
+            cc1[n] = 1;
+        }
+    }
+
+    int32_t* by0 = nullptr;
+    int32_t* by1 = nullptr;
+    if (recordTrace) {
+        cc0By.assign(nl.numNets(), -1);
+        cc1By.assign(nl.numNets(), -1);
+        by0 = cc0By.data();
+        by1 = cc1By.data();
+    }
+    sweepBatches<false>(nl, cappedLoops, [&](const GateBatch& b, bool inLoop) {
+        bool changed = false;
+        dispatchGate(b.type, b.arity, [&](auto type, auto arity) {
+            constexpr GateType G = decltype(type)::value;
+            constexpr int A = decltype(arity)::value;
+            changed = inLoop ? forwardBatch<G, A, true>(nl, b, T(1), cc0.data(), cc1.data(), by0, by1)
+                             : forwardBatch<G, A, false>(nl, b, T(1), cc0.data(), cc1.data(), by0, by1);
+        });
+        return changed;
+    });
+    forwardClockTree(nl, EdgeSet::All, T(1), cc0.data(), cc1.data(), by0, by1);
+}
+
+// Calculates SC0 and SC1 for all nets by iterating to a fixpoint. Fixed clock
+// network nets, and the clock cost of the flip-flops they clock, are computed
+// once up front. Without flip-flops (full scan) a single sweep is exact.
+template <typename T>
+bool ScoapEngine<T>::computeSequentialControllability() {
+    for (size_t n = 0; n < nl.numNets(); ++n) {
+        if (nl.netFlags[n] & (CompactNetlist::PrimaryInput | CompactNetlist::PseudoInput)) {
+            sc0[n] = 0;
+            sc1[n] = 0;
+        }
+    }
+
+    forwardClockTree(nl, EdgeSet::Fixed, T(0), sc0.data(), sc1.data());
+    std::vector<T> clockCost(nl.numFlipFlops());
+    std::vector<uint8_t> clockFixed(nl.numFlipFlops());
+    for (size_t f = 0; f < nl.numFlipFlops(); ++f) {
+        const int32_t clk = nl.ffClk[f];
+        clockFixed[f] = (nl.netFlags[clk] & (CompactNetlist::PrimaryInput | CompactNetlist::FixedControl)) != 0;
+        clockCost[f] = M::add(sc0[clk], sc1[clk]);
+    }
+
+    bool changed;
+    do {
+        changed = false;
+
+        // Propagate through combinational logic and derived clock networks
+        changed |= sweepBatches<false>(nl, cappedLoops, [&](const GateBatch& b, bool) {
+            bool batchChanged = false;
+            dispatchGate(b.type, b.arity, [&](auto type, auto arity) {
+                batchChanged = forwardBatch<decltype(type)::value, decltype(arity)::value, true>(nl, b, T(0), sc0.data(), sc1.data());
+            });
+            return batchChanged;
+        });
+        changed |= forwardClockTree(nl, EdgeSet::Derived, T(0), sc0.data(), sc1.data());
+
+        // Propagate through flip-flops
+        for (size_t f = 0; f < nl.numFlipFlops(); ++f) {
+            if (!clockFixed[f]) clockCost[f] = M::add(sc0[nl.ffClk[f]], sc1[nl.ffClk[f]]);
+            T new0 = M::INF, new1 = M::INF;
+            flipFlopControllability(nl, f, clockCost[f], sc0.data(), sc1.data(), new0, new1);
+            const int32_t q = nl.ffQ[f];
+            if (new0 < sc0[q]) { sc0[q] = new0; changed = true; }
+            if (new1 < sc1[q]) { sc1[q] = new1; changed = true; }
+        }
+        if (onRound) onRound();
+    } while (changed && nl.numFlipFlops() > 0 && !pastDeadline());
+    return !changed || nl.numFlipFlops() == 0;
+}
+
+// Calculates CO for all nets in a single reverse-levelized sweep. Each gate
+// costs O(arity), regardless of its width.
+template <typename T>
+void ScoapEngine<T>::computeCombinationalObservability() {
+    for (size_t n = 0; n < nl.numNets(); ++n) {
+        if (nl.netFlags[n] & (CompactNetlist::PrimaryOutput | CompactNetlist::PseudoOutput)) co[n] = 0;
+    }
+
+    int32_t* by = nullptr;
+    if (recordTrace) {
+        coBy.assign(nl.numNets(), -1);
+        by = coBy.data();
+    }
+    backwardClockTree(nl, EdgeSet::All, T(1), co.data(), by);
+    sweepBatches<true>(nl, cappedLoops, [&](const GateBatch& b, bool) {
+        bool changed = false;
+        dispatchGate(b.type, b.arity, [&](auto type, auto arity) {
+            changed = backwardBatch<decltype(type)::value, decltype(arity)::value>(nl, b, T(1), cc0.data(), cc1.data(), co.data(), scratch.data(), by);
+        });
+        return changed;
+    });
+}
+
+// Calculates SO for all nets by iterating to a fixpoint. Fixed clock network
+// nets only pass SO on to each other, so they are handled once at the end.
+// Without flip-flops (full scan) a single sweep is exact.
+template <typename T>
+bool ScoapEngine<T>::computeSequentialObservability() {
+    for (size_t n = 0; n < nl.numNets(); ++n) {
+        if (nl.netFlags[n] & (CompactNetlist::PrimaryOutput | CompactNetlist::PseudoOutput)) so[n] = 0; // PO is observable in 0 time steps
+    }
+
+    std::vector<T> clockCost(nl.numFlipFlops());
+    for (size_t f = 0; f < nl.numFlipFlops(); ++f) {
+        clockCost[f] = M::add(sc0[nl.ffClk[f]], sc1[nl.ffClk[f]]);
+    }
+
+    bool changed;
+    do {
+        changed = false;
+
+        // Propagate SO from FF outputs to their input pins
+        for (size_t f = 0; f < nl.numFlipFlops(); ++f) {
+            changed |= flipFlopObservability(nl, f, clockCost[f], sc0.data(), sc1.data(), so.data());
+        }
+        changed |= backwardClockTree(nl, EdgeSet::Derived, T(0), so.data());
+
+        // Propagate SO backward through combinational logic
+        changed |= sweepBatches<true>(nl, cappedLoops, [&](const GateBatch& b, bool) {
+            bool batchChanged = false;
+            dispatchGate(b.type, b.arity, [&](auto type, auto arity) {
+                batchChanged = backwardBatch<decltype(type)::value, decltype(arity)::value>(nl, b, T(0), sc0.data(), sc1.data(), so.data(), scratch.data());
+            });
+            return batchChanged;
+        });
+        if (onRound) onRound();
+    } while (changed && nl.numFlipFlops() > 0 && !pastDeadline());
+    backwardClockTree(nl, EdgeSet::Fixed, T(0), so.data());
+    return !changed || nl.numFlipFlops() == 0;
+}
+
+template <typename T>
+bool ScoapEngine<T>::pastDeadline() const {
+    return deadline != std::chrono::steady_clock::time_point::max() && std::chrono::steady_clock::now() > deadline;
+}
+
+template <typename T>
+bool ScoapEngine<T>::stepFlipFlopControllability() {
+    bool changed = false;
+    for (size_t f = 0; f < nl.numFlipFlops(); ++f) {
+        T new0 = M::INF, new1 = M::INF;
+        flipFlopControllability(nl, f, M::add(sc0[nl.ffClk[f]], sc1[nl.ffClk[f]]), sc0.data(), sc1.data(), new0, new1);
+        const int32_t q = nl.ffQ[f];
+        if (new0 < sc0[q]) { sc0[q] = new0; changed = true; }
+        if (new1 < sc1[q]) { sc1[q] = new1; changed = true; }
+    }
+    return changed;
+}
+
+template <typename T>
+bool ScoapEngine<T>::stepFlipFlopObservability() {
+    bool changed = false;
+    for (size_t f = 0; f < nl.numFlipFlops(); ++f) {
+        changed |= flipFlopObservability(nl, f, M::add(sc0[nl.ffClk[f]], sc1[nl.ffClk[f]]), sc0.data(), sc1.data(), so.data());
+    }
+    return changed;
+}
+
+template <typename T>
+std::vector<typename ScoapEngine<T>::TraceStep> ScoapEngine<T>::trace(int32_t net, TraceMetric metric) const {
+    std::vector<TraceStep> path;
+    const bool observe = metric == TraceMetric::CO;
+    if ((observe ? coBy : cc0By).empty()) return path;
+    auto cc = [&](int32_t n, bool one) { return one ? cc1[n] : cc0[n]; };
+
+    // Pointers only ever lead to strictly cheaper values, but bound the walk
+    // by the number of nets anyway.
+    for (size_t steps = 0; steps <= nl.numNets(); ++steps) {
+        const int32_t by = observe ? coBy[net] : (metric == TraceMetric::CC1 ? cc1By : cc0By)[net];
+        path.push_back({net, metric, by});
+        if (by == -1) break;
+        if (by <= -2) {
+            const ClockTreeEdge& e = nl.clockTree[-2 - by];
+            if (observe) {
+                net = e.net;
+            } else {
+                net = e.parent;
+                if (e.inverted) metric = metric == TraceMetric::CC1 ? TraceMetric::CC0 : TraceMetric::CC1;
+            }
+            continue;
+        }
+        if (observe) {
+            net = nl.gateOutput[by];
+            continue;
+        }
+
+        const int32_t* in = nl.gateInputs.data() + nl.gateInputBegin[by];
+        const uint32_t n = nl.gateInputBegin[by + 1] - nl.gateInputBegin[by];
+        const bool one = metric == TraceMetric::CC1;
+        int32_t next = -1;
+        bool nextOne = one;
+        switch (nl.gateType[by]) {
+        case GateType::Buf:
+        case GateType::Not:
+            next = in[0];
+            nextOne = (nl.gateType[by] == GateType::Not) != one;
+            break;
+        case GateType::And:
+        case GateType::Nand:
+        case GateType::Or:
+        case GateType::Nor: {
+            const GateType type = nl.gateType[by];
+            const bool controlling = type == GateType::Or || type == GateType::Nor;
+            const bool inverting = type == GateType::Nand || type == GateType::Nor;
+            nextOne = one != inverting; // Value of the inputs' and/or
+            for (uint32_t i = 0; i < n; ++i) {
+                const T c = cc(in[i], nextOne);
+                if (next < 0 || (nextOne == controlling ? c < cc(next, nextOne) : c > cc(next, nextOne))) next = in[i];
+            }
+            break;
+        }
+        case GateType::Xor:
+        case GateType::Xnor:
+            for (uint32_t i = 0; i < n; ++i) {
+                if (next < 0 || M::min(cc0[in[i]], cc1[in[i]]) > M::min(cc0[next], cc1[next])) next = in[i];
+            }
+            if (next >= 0) nextOne = cc1[next] < cc0[next];
+            break;
+        case GateType::Cell: {
+            const CellRule* rule = nl.cellRule(by);
+            const std::vector<CellCube>* cover = rule ? (one ? &rule->onSet : &rule->offSet) : nullptr;
+            const CellCube* best = nullptr;
+            T bestCost = M::INF;
+            for (size_t c = 0; cover && c < cover->size(); ++c) {
+                T cost = 0;
+                for (uint32_t p = 0; p < n; ++p) {
+                    if ((*cover)[c].care >> p & 1) cost = M::add(cost, cc(in[p], (*cover)[c].value >> p & 1));
+                }
+                if (!best || cost < bestCost) { best = &(*cover)[c]; bestCost = cost; }
+            }
+            for (uint32_t p = 0; best && p < n; ++p) {
+                if (!(best->care >> p & 1)) continue;
+                const bool v = best->value >> p & 1;
+                if (next < 0 || cc(in[p], v) > cc(next, nextOne)) { next = in[p]; nextOne = v; }
+            }
+            break;
+        }
+        case GateType::Unknown:
+            break;
+        }
+        if (next < 0) break; // Tie cells and unknown gates
+        net = next;
+        metric = nextOne ? TraceMetric::CC1 : TraceMetric::CC0;
+    }
+    return path;
+}
+
+template class ScoapEngine<uint16_t>;
+template class ScoapEngine<uint32_t>;
@@ -0,0 +1,87 @@
+#ifndef SCOAP_ENGINE_H
+#define SCOAP_ENGINE_H
+
+#include "CompactNetlist.h"
+#include "Metric.h"
+#include <atomic>
+#include <chrono>
+#include <functional>
+
+// Computes the SCOAP metrics of a CompactNetlist into flat per-net arrays.
+//
+// T is the metric storage type (uint16_t or uint32_t). All arithmetic goes
+// through Metric<T>, so unreachable values saturate at Metric<T>::INF
+// instead of overflowing.
+//
+// Combinational loops are evaluated where they sit in the level order: their
+// gates are swept repeatedly, min-merging the results, until nothing changes.
+// Starting from INF this yields the cheapest values that the gates of the loop
+// can justify from outside the loop, while nets that depend on the loop
+// holding its own state stay INF.
+template <typename T>
+class ScoapEngine {
+public:
+    using M = Metric<T>;
+
+    explicit ScoapEngine(const CompactNetlist& netlist);
+
+    void computeCombinationalControllability();
+    void computeCombinationalObservability();
+
+    // The sequential passes iterate to a fixpoint, starting from the current
+    // SC (SO) values: INF after construction, or the values of an earlier run
+    // on the same netlist that was stopped, which they continue. They return
+    // false if they stopped at the deadline instead.
+    bool computeSequentialControllability();
+    bool computeSequentialObservability();
+
+    // The sequential passes stop after the first round that ends past the
+    // deadline. Every round only lowers values, so after any round SC and SO
+    // are upper bounds of their fixpoint (SO also while SC is not final).
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    // Called after every round of the sequential passes, e.g. to save them.
+    std::function<void()> onRound;
+
+    // One round of the flip-flop rules over the current SC (or SO) values,
+    // for callers that drive the sequential fixpoint themselves. Returns true
+    // if a value improved.
+    bool stepFlipFlopControllability();
+    bool stepFlipFlopObservability();
+
+    // Metric arrays, indexed by net id.
+    std::vector<T> cc0, cc1, sc0, sc1, co, so;
+
+    // Number of combinational loop evaluations stopped by the iteration bound
+    // before reaching their fixpoint. Atomic because the SC and CO passes,
+    // which only share the CC values they read, may run concurrently.
+    std::atomic<size_t> cappedLoops{0};
+
+    // Argmin back-pointers, one per metric per net, recorded by the CC and CO
+    // passes when recordTrace is set beforehand: the gate (evaluation order
+    // index) that set CC0/CC1 of the net or through which the net has its
+    // CO, -2 - e for clock tree edge e, or -1 (inputs, outputs, INF values).
+    bool recordTrace = false;
+    std::vector<int32_t> cc0By, cc1By, coBy;
+
+    enum class TraceMetric : uint8_t { CC0, CC1, CO };
+    struct TraceStep {
+        int32_t net;
+        TraceMetric metric;
+        int32_t by; // Back-pointer of the net for the metric
+    };
+
+    // Walks the back-pointers from `net`, one step per net: the cheapest
+    // justification of CC0/CC1 back to an input, or the cheapest propagation
+    // path of CO forward to an output. Justification continues on the input
+    // that decides the gate's cost: the cheapest input at a controlling
+    // value, otherwise the costliest of the inputs that must all be set.
+    std::vector<TraceStep> trace(int32_t net, TraceMetric metric) const;
+
+private:
+    bool pastDeadline() const;
+
+    const CompactNetlist& nl;
+    std::vector<T> scratch; // Prefix sums for the widest gate
+};
+
+#endif // SCOAP_ENGINE_H
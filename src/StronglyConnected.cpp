@@ -0,0 +1,60 @@
+#include "StronglyConnected.h"
+#include <algorithm>
+
+std::vector<int32_t> stronglyConnectedComponents(
+    const std::vector<uint32_t>& begin,
+    const std::vector<int32_t>& adj,
+    int32_t& numComponents
+) {
+    const int32_t n = static_cast<int32_t>(begin.size()) - 1;
+    std::vector<int32_t> component(n, -1);
+    std::vector<int32_t> index(n, -1);   // DFS discovery order
+    std::vector<int32_t> lowlink(n, 0);
+    std::vector<uint32_t> nextEdge(n, 0); // Resume position of each node on the call stack
+    std::vector<int32_t> callStack;       // Replaces recursion
+    std::vector<int32_t> sccStack;        // Tarjan's stack of visited, unassigned nodes
+    int32_t counter = 0;
+    numComponents = 0;
+
+    for (int32_t root = 0; root < n; ++root) {
+        if (index[root] >= 0) continue;
+        index[root] = lowlink[root] = counter++;
+        nextEdge[root] = begin[root];
+        callStack.push_back(root);
+        sccStack.push_back(root);
+
+        while (!callStack.empty()) {
+            const int32_t v = callStack.back();
+            if (nextEdge[v] < begin[v + 1]) {
+                const int32_t w = adj[nextEdge[v]++];
+                if (index[w] < 0) {
+                    // Descend into w.
+                    index[w] = lowlink[w] = counter++;
+                    nextEdge[w] = begin[w];
+                    callStack.push_back(w);
+                    sccStack.push_back(w);
+                } else if (component[w] < 0) {
+                    lowlink[v] = std::min(lowlink[v], index[w]);
+                }
+                continue;
+            }
+
+            // All successors of v are done: return to the caller.
+            callStack.pop_back();
+            if (!callStack.empty()) {
+                const int32_t parent = callStack.back();
+                lowlink[parent] = std::min(lowlink[parent], lowlink[v]);
+            }
+            if (lowlink[v] == index[v]) {
+                int32_t w;
+                do {
+                    w = sccStack.back();
+                    sccStack.pop_back();
+                    component[w] = numComponents;
+                } while (w != v);
+                ++numComponents;
+            }
+        }
+    }
+    return component;
+}
@@ -0,0 +1,20 @@
+#ifndef STRONGLY_CONNECTED_H
+#define STRONGLY_CONNECTED_H
+
+#include <cstdint>
+#include <vector>
+
+// Strongly connected components of a directed graph in CSR form: the
+// successors of node v are adj[begin[v] .. begin[v + 1]).
+//
+// Uses an iterative form of Tarjan's algorithm, so the running time is linear
+// and the call depth does not grow with the graph. Returns the component of
+// every node. Components are numbered in reverse topological order: every
+// edge between two components goes from a higher to a lower number.
+std::vector<int32_t> stronglyConnectedComponents(
+    const std::vector<uint32_t>& begin,
+    const std::vector<int32_t>& adj,
+    int32_t& numComponents
+);
+
+#endif // STRONGLY_CONNECTED_H
@@ -0,0 +1,113 @@
+#include "TaskGraph.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <queue>
+
+// The state of one run(). It is shared with the pool jobs, which may only
+// start after run() has returned; they then find nothing ready and return.
+struct TaskGraph::Run {
+    std::vector<Node>& nodes;
+    ThreadPool& pool;
+    unsigned threads;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    // Ready tasks, lowest first, so that one thread runs them in added order.
+    std::priority_queue<Task, std::vector<Task>, std::greater<Task>> ready;
+    std::vector<size_t> pending;
+    std::vector<uint8_t> failed; // Failed or skipped
+    size_t finished = 0;
+    unsigned helpers = 0;        // Pool jobs queued or running
+    unsigned running = 0;        // Threads inside a task, the caller included
+    bool ok = true;
+
+    Run(std::vector<Node>& nodes, ThreadPool& pool, unsigned threads)
+        : nodes(nodes), pool(pool), threads(threads), pending(nodes.size()), failed(nodes.size(), 0) {}
+
+    // Called with the lock held. Asks the pool for one more thread per
+    // ready task that no idle participant (a waiting caller or a queued job)
+    // will take, up to the thread limit.
+    void recruit(const std::shared_ptr<Run>& self) {
+        while (helpers + 1 < threads && ready.size() > helpers + 1 - running) {
+            ++helpers;
+            pool.submit([self] { work(self, false); });
+        }
+    }
+
+    // Called with the lock held. Releases the successors of a finished task;
+    // those of a failed one are finished (skipped) as well, transitively.
+    void finish(Task task, bool success) {
+        std::vector<std::pair<Task, bool>> stack{{task, success}};
+        while (!stack.empty()) {
+            auto [t, done] = stack.back();
+            stack.pop_back();
+            ++finished;
+            if (!done) {
+                failed[t] = 1;
+                ok = false;
+            }
+            for (Task s : nodes[t].successors) {
+                if (!done) failed[s] = 1;
+                if (--pending[s] > 0) continue;
+                if (failed[s]) stack.push_back({s, false});
+                else ready.push(s);
+            }
+        }
+        changed.notify_all();
+    }
+};
+
+TaskGraph::Task TaskGraph::add(std::string name, std::function<bool()> body, std::vector<Task> after) {
+    const Task task = static_cast<Task>(nodes.size());
+    nodes.push_back({std::move(name), std::move(body), {}, after.size()});
+    for (Task t : after) nodes[t].successors.push_back(task);
+    return task;
+}
+
+// Runs ready tasks. The caller waits for running tasks until all are
+// finished; pool threads return as soon as nothing is ready.
+void TaskGraph::work(const std::shared_ptr<Run>& run, bool caller) {
+    std::unique_lock<std::mutex> lock(run->mutex);
+    while (true) {
+        if (caller) {
+            run->changed.wait(lock, [&] { return !run->ready.empty() || run->finished == run->nodes.size(); });
+        }
+        if (run->ready.empty()) break;
+        const Task task = run->ready.top();
+        run->ready.pop();
+        ++run->running;
+        run->recruit(run);
+        lock.unlock();
+        const Node& node = run->nodes[task];
+        bool success = false;
+        try {
+            success = node.body();
+        } catch (const std::exception& e) {
+            std::cerr << "Error in " << node.name << ": " << e.what() << std::endl;
+        } catch (...) {
+            std::cerr << "Error in " << node.name << ": unknown exception" << std::endl;
+        }
+        lock.lock();
+        --run->running;
+        run->finish(task, success);
+    }
+    if (!caller) --run->helpers;
+}
+
+bool TaskGraph::run(ThreadPool& pool, unsigned threads) {
+    if (threads == 0) threads = pool.concurrency();
+    threads = static_cast<unsigned>(std::min<size_t>(threads, std::max<size_t>(nodes.size(), 1)));
+
+    auto state = std::make_shared<Run>(nodes, pool, threads);
+    for (size_t t = 0; t < nodes.size(); ++t) {
+        state->pending[t] = nodes[t].pending;
+        if (state->pending[t] == 0) state->ready.push(static_cast<Task>(t));
+    }
+    work(state, true);
+    return state->ok;
+}
@@ -0,0 +1,44 @@
+#ifndef TASK_GRAPH_H
+#define TASK_GRAPH_H
+
+#include "ThreadPool.h"
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// A DAG of named tasks run on a shared ThreadPool. A task starts once every
+// task it was added after has finished successfully, so tasks without a
+// path between them may run concurrently. A task fails by returning false
+// or throwing; the tasks that depend on it, directly or indirectly, are then
+// skipped, while the others still run.
+class TaskGraph {
+public:
+    using Task = int;
+
+    // Adds a task that runs after the given tasks (added earlier).
+    Task add(std::string name, std::function<bool()> body, std::vector<Task> after = {});
+
+    // Runs all tasks on the caller and on up to `threads` - 1 idle threads
+    // of `pool` (0 for all of them; 1 runs them on the caller in the order
+    // they were added). Pool threads are only asked for while tasks are
+    // ready and return to the pool when none are, so they stay available to
+    // the parallel loops inside the tasks, and a graph run from a task on
+    // the same pool cannot wait for itself. Returns true if every task ran
+    // and succeeded.
+    bool run(ThreadPool& pool, unsigned threads = 0);
+
+private:
+    struct Node {
+        std::string name;
+        std::function<bool()> body;
+        std::vector<Task> successors;
+        size_t pending = 0; // Predecessors not yet finished
+    };
+    struct Run;
+    static void work(const std::shared_ptr<Run>& run, bool caller);
+
+    std::vector<Node> nodes;
+};
+
+#endif // TASK_GRAPH_H
@@ -0,0 +1,115 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+namespace {
+
+constexpr size_t kChunk = 1024;             // Items per work item
+constexpr size_t kMinParallel = 4 * kChunk; // Smaller ranges run on the caller
+
+// The pool threads taking part in one parallel() call. It is shared with
+// the queued jobs, which may only start after the call has returned.
+struct Group {
+    std::mutex mutex;
+    std::condition_variable done;
+    unsigned nextSlot = 1;
+    unsigned running = 0;
+    bool closed = false; // The caller's part has returned
+    std::exception_ptr error;
+};
+
+} // namespace
+
+ThreadPool::ThreadPool(unsigned threads) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned t = 1; t < threads; ++t) workers.emplace_back(&ThreadPool::work, this);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& t : workers) t.join();
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::submit(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(std::move(job));
+    }
+    wake.notify_one();
+}
+
+void ThreadPool::work() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [&] { return stopping || !jobs.empty(); });
+        if (jobs.empty()) return;
+        std::function<void()> job = std::move(jobs.front());
+        jobs.pop_front();
+        lock.unlock();
+        job();
+        lock.lock();
+    }
+}
+
+void ThreadPool::parallel(unsigned participants, const std::function<void(unsigned)>& worker) {
+    participants = participants == 0 ? concurrency() : std::min(participants, concurrency());
+    auto group = std::make_shared<Group>();
+    for (unsigned t = 1; t < participants; ++t) {
+        // `worker` is only used by jobs that start before the caller's part
+        // has returned, and the caller waits for those.
+        submit([group, &worker] {
+            unsigned slot;
+            {
+                std::lock_guard<std::mutex> lock(group->mutex);
+                if (group->closed) return;
+                slot = group->nextSlot++;
+                ++group->running;
+            }
+            std::exception_ptr error;
+            try {
+                worker(slot);
+            } catch (...) {
+                error = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(group->mutex);
+            if (error && !group->error) group->error = error;
+            if (--group->running == 0) group->done.notify_all();
+        });
+    }
+
+    std::exception_ptr error;
+    try {
+        worker(0);
+    } catch (...) {
+        error = std::current_exception();
+    }
+    std::unique_lock<std::mutex> lock(group->mutex);
+    group->closed = true;
+    group->done.wait(lock, [&] { return group->running == 0; });
+    if (!error) error = group->error;
+    lock.unlock();
+    if (error) std::rethrow_exception(error);
+}
+
+void ThreadPool::parallelChunks(size_t n, void (*body)(size_t, size_t, unsigned, void*), void* context) {
+    const unsigned threads = static_cast<unsigned>(std::min<size_t>(concurrency(), (n + kChunk - 1) / kChunk));
+    if (n < kMinParallel || threads <= 1) {
+        if (n > 0) body(0, n, 0, context);
+        return;
+    }
+    std::atomic<size_t> next{0};
+    parallel(threads, [&](unsigned slot) {
+        for (size_t c; (c = next.fetch_add(1)) * kChunk < n;) body(c * kChunk, std::min(n, (c + 1) * kChunk), slot, context);
+    });
+}
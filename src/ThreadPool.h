@@ -0,0 +1,67 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// A fixed set of worker threads shared by all parallel work of a run: the
+// stages of a TaskGraph, the passes within the analysis and the parallel
+// loops inside them. The thread that starts parallel work always takes part
+// in it, and pool threads only join while they are idle, so parallel work
+// started from a task that itself runs on the pool never waits for a free
+// thread: if every thread is busy, the caller does it alone.
+class ThreadPool {
+public:
+    // A pool for `threads` concurrent threads, the caller included, so it
+    // starts threads - 1 workers (0 for one per hardware thread).
+    explicit ThreadPool(unsigned threads = 0);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Threads that can take part in parallel work, the caller included.
+    unsigned concurrency() const { return static_cast<unsigned>(workers.size()) + 1; }
+
+    // Queues a job for the next idle worker. Jobs must not throw.
+    void submit(std::function<void()> job);
+
+    // Calls worker(slot) on the caller (slot 0) and on up to participants - 1
+    // idle pool threads (0 for all), each with its own slot below
+    // concurrency(). The workers share their work themselves, e.g. through
+    // an atomic counter. Returns when every started call has returned; pool
+    // threads that become idle only after the caller's call returned do not
+    // start. The first exception thrown by a call is rethrown here.
+    void parallel(unsigned participants, const std::function<void(unsigned)>& worker);
+
+    // Calls body(first, last, slot) on chunks of [0, n) in parallel; small
+    // ranges run on the caller.
+    void parallelChunks(size_t n, void (*body)(size_t, size_t, unsigned, void*), void* context);
+
+    template <typename F>
+    void parallelChunks(size_t n, F&& body) {
+        parallelChunks(n, [](size_t first, size_t last, unsigned slot, void* f) {
+            (*static_cast<std::remove_reference_t<F>*>(f))(first, last, slot);
+        }, &body);
+    }
+
+    // The pool of the process, started on first use, for callers that are
+    // not given one.
+    static ThreadPool& shared();
+
+private:
+    void work();
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<std::function<void()>> jobs;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+};
+
+#endif // THREAD_POOL_H
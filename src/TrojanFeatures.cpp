@@ -0,0 +1,308 @@
+#include "TrojanFeatures.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <random>
+
+const char* const TrojanFeatures::columnNames[NumColumns] = {
+    "CC0", "CC1", "CO",
+    "FaninNets", "FaninMinCC1", "FaninMaxCC1", "FaninMeanCC1", "FaninMinCO", "FaninMaxCO", "FaninMeanCO", "FaninRare",
+    "FanoutNets", "FanoutMinCC1", "FanoutMaxCC1", "FanoutMeanCC1", "FanoutMinCO", "FanoutMaxCO", "FanoutMeanCO", "FanoutRare",
+    "Rare0", "Rare1", "PODistance", "FFDistance",
+};
+
+namespace {
+
+constexpr size_t kChunk = 256; // Nets per work item
+
+// Aggregates of the metrics over one neighborhood.
+struct Aggregate {
+    size_t nets = 0, rare = 0;
+    int minCC1 = INF, maxCC1 = -1, minCO = INF, maxCO = -1;
+    double sumCC1 = 0, sumCO = 0;
+    size_t finiteCC1 = 0, finiteCO = 0;
+};
+
+// The 99th percentile of the finite values, but above the minimum, so that
+// a design where most nets share a value does not make them all rare.
+int rareThreshold(std::vector<int> finite) {
+    if (finite.empty()) return INF;
+    std::sort(finite.begin(), finite.end());
+    const int p99 = finite[static_cast<size_t>(0.99 * static_cast<double>(finite.size() - 1))];
+    return std::max(p99, finite.front() + 1);
+}
+
+} // namespace
+
+TrojanFeatures::TrojanFeatures(const CompactNetlist& netlist, const std::vector<int>& cc0,
+                               const std::vector<int>& cc1, const std::vector<int>& co)
+    : nl(netlist), cc0(cc0), cc1(cc1), co(co) {}
+
+// Edges run from every gate input to the gate's output and from the data
+// pins of a flip-flop to its Q. Edges at clock network nets are left out.
+void TrojanFeatures::buildGraph() {
+    const size_t n = nl.numNets();
+    std::vector<std::pair<int32_t, int32_t>> edges;
+    auto addEdge = [&](int32_t from, int32_t to) {
+        if (from < 0 || to < 0) return;
+        if ((nl.netFlags[from] | nl.netFlags[to]) & CompactNetlist::ClockNetwork) return;
+        edges.emplace_back(from, to);
+    };
+    for (size_t g = 0; g < nl.numGates(); ++g) {
+        for (uint32_t i = nl.gateInputBegin[g]; i < nl.gateInputBegin[g + 1]; ++i) addEdge(nl.gateInputs[i], nl.gateOutput[g]);
+    }
+    for (size_t f = 0; f < nl.numFlipFlops(); ++f) {
+        addEdge(nl.ffIn0[f], nl.ffQ[f]);
+        addEdge(nl.ffIn1[f], nl.ffQ[f]);
+    }
+    faninBegin.assign(n + 1, 0);
+    fanoutBegin.assign(n + 1, 0);
+    for (const auto& e : edges) {
+        ++faninBegin[e.second + 1];
+        ++fanoutBegin[e.first + 1];
+    }
+    for (size_t i = 0; i < n; ++i) {
+        faninBegin[i + 1] += faninBegin[i];
+        fanoutBegin[i + 1] += fanoutBegin[i];
+    }
+    fanin.resize(edges.size());
+    fanout.resize(edges.size());
+    std::vector<uint32_t> inFill(faninBegin.begin(), faninBegin.end() - 1);
+    std::vector<uint32_t> outFill(fanoutBegin.begin(), fanoutBegin.end() - 1);
+    for (const auto& e : edges) {
+        fanin[inFill[e.second]++] = e.first;
+        fanout[outFill[e.first]++] = e.second;
+    }
+}
+
+// Multi-source breadth-first search backwards through the fanin: the
+// number of gates from each net to the nearest source.
+void TrojanFeatures::distances(const std::vector<int32_t>& sources, Column column) {
+    std::vector<int32_t> dist(nl.numNets(), -1), queue;
+    queue.reserve(nl.numNets());
+    for (int32_t s : sources) {
+        if (dist[s] < 0) {
+            dist[s] = 0;
+            queue.push_back(s);
+        }
+    }
+    for (size_t head = 0; head < queue.size(); ++head) {
+        const int32_t u = queue[head];
+        for (uint32_t i = faninBegin[u]; i < faninBegin[u + 1]; ++i) {
+            const int32_t v = fanin[i];
+            if (dist[v] < 0) {
+                dist[v] = dist[u] + 1;
+                queue.push_back(v);
+            }
+        }
+    }
+    for (size_t net = 0; net < nl.numNets(); ++net) at(net, column) = dist[net];
+}
+
+void TrojanFeatures::compute(ThreadPool& pool) {
+    const size_t n = nl.numNets();
+    buildGraph();
+    values.assign(n * NumColumns, -1);
+
+    std::vector<int> finite0, finite1;
+    for (size_t net = 0; net < n; ++net) {
+        if (nl.netFlags[net] & CompactNetlist::ClockNetwork) continue;
+        if (cc0[net] != INF) finite0.push_back(cc0[net]);
+        if (cc1[net] != INF) finite1.push_back(cc1[net]);
+    }
+    const int threshold0 = rareThreshold(std::move(finite0));
+    const int threshold1 = rareThreshold(std::move(finite1));
+    std::vector<uint8_t> rare0(n), rare1(n);
+    for (size_t net = 0; net < n; ++net) {
+        rare0[net] = cc0[net] == INF || cc0[net] >= threshold0;
+        rare1[net] = cc1[net] == INF || cc1[net] >= threshold1;
+    }
+
+    // Visits the nets within `hops` of start (excluding start) along adj.
+    auto expand = [&](int32_t start, const std::vector<uint32_t>& begin, const std::vector<int32_t>& adj,
+                      std::vector<uint32_t>& stamp, uint32_t epoch,
+                      std::vector<int32_t>& frontier, std::vector<int32_t>& next) {
+        Aggregate agg;
+        frontier.assign(1, start);
+        stamp[start] = epoch;
+        for (int hop = 0; hop < hops && !frontier.empty() && agg.nets < maxNeighborhood; ++hop) {
+            next.clear();
+            for (int32_t u : frontier) {
+                for (uint32_t i = begin[u]; i < begin[u + 1] && agg.nets < maxNeighborhood; ++i) {
+                    const int32_t v = adj[i];
+                    if (stamp[v] == epoch) continue;
+                    stamp[v] = epoch;
+                    next.push_back(v);
+                    ++agg.nets;
+                    agg.rare += rare0[v] || rare1[v];
+                    if (cc1[v] != INF) {
+                        agg.minCC1 = std::min(agg.minCC1, cc1[v]);
+                        agg.maxCC1 = std::max(agg.maxCC1, cc1[v]);
+                        agg.sumCC1 += cc1[v];
+                        ++agg.finiteCC1;
+                    }
+                    if (co[v] != INF) {
+                        agg.minCO = std::min(agg.minCO, co[v]);
+                        agg.maxCO = std::max(agg.maxCO, co[v]);
+                        agg.sumCO += co[v];
+                        ++agg.finiteCO;
+                    }
+                }
+            }
+            frontier.swap(next);
+        }
+        return agg;
+    };
+    auto store = [&](size_t net, Column first, const Aggregate& agg) {
+        double* v = &at(net, first);
+        v[0] = static_cast<double>(agg.nets);
+        if (agg.finiteCC1) {
+            v[1] = agg.minCC1;
+            v[2] = agg.maxCC1;
+            v[3] = agg.sumCC1 / static_cast<double>(agg.finiteCC1);
+        }
+        if (agg.finiteCO) {
+            v[4] = agg.minCO;
+            v[5] = agg.maxCO;
+            v[6] = agg.sumCO / static_cast<double>(agg.finiteCO);
+        }
+        v[7] = static_cast<double>(agg.rare);
+    };
+
+    std::atomic<size_t> nextChunk{0};
+    auto worker = [&](unsigned) {
+        std::vector<uint32_t> stamp(n, 0);
+        std::vector<int32_t> frontier, next;
+        uint32_t epoch = 0;
+        for (size_t c; (c = nextChunk.fetch_add(1)) * kChunk < n;) {
+            for (size_t net = c * kChunk; net < std::min(n, (c + 1) * kChunk); ++net) {
+                const int32_t id = static_cast<int32_t>(net);
+                at(net, CC0) = cc0[net] == INF ? -1 : cc0[net];
+                at(net, CC1) = cc1[net] == INF ? -1 : cc1[net];
+                at(net, CO) = co[net] == INF ? -1 : co[net];
+                store(net, FaninNets, expand(id, faninBegin, fanin, stamp, ++epoch, frontier, next));
+                store(net, FanoutNets, expand(id, fanoutBegin, fanout, stamp, ++epoch, frontier, next));
+                at(net, Rare0) = rare0[net];
+                at(net, Rare1) = rare1[net];
+            }
+        }
+    };
+    pool.parallel(static_cast<unsigned>(std::min<size_t>(pool.concurrency(), (n + kChunk - 1) / kChunk)), worker);
+
+    std::vector<int32_t> outputs, dataPins;
+    for (size_t net = 0; net < n; ++net) {
+        if (nl.netFlags[net] & CompactNetlist::PrimaryOutput) outputs.push_back(static_cast<int32_t>(net));
+    }
+    for (size_t f = 0; f < nl.numFlipFlops(); ++f) {
+        if (nl.ffIn0[f] >= 0) dataPins.push_back(nl.ffIn0[f]);
+        if (nl.ffIn1[f] >= 0) dataPins.push_back(nl.ffIn1[f]);
+    }
+    distances(outputs, PODistance);
+    distances(dataPins, FFDistance);
+}
+
+// Features are compressed with log(1 + x) (undefined values become one
+// more than the column's maximum) and standardized before clustering.
+void TrojanFeatures::score(int k) {
+    const size_t n = nl.numNets();
+    clusters.assign(n, -1);
+    scores.assign(n, 0);
+    std::vector<size_t> rows;
+    for (size_t net = 0; net < n; ++net) {
+        if (!(nl.netFlags[net] & CompactNetlist::ClockNetwork)) rows.push_back(net);
+    }
+    if (rows.size() < static_cast<size_t>(k) || values.empty()) return;
+
+    std::vector<double> x(rows.size() * NumColumns);
+    for (int c = 0; c < NumColumns; ++c) {
+        double maxValue = 0;
+        for (size_t net : rows) maxValue = std::max(maxValue, value(net, static_cast<Column>(c)));
+        double sum = 0, sumSq = 0;
+        for (size_t r = 0; r < rows.size(); ++r) {
+            const double v = value(rows[r], static_cast<Column>(c));
+            const double t = std::log1p(v < 0 ? maxValue + 1 : v);
+            x[r * NumColumns + c] = t;
+            sum += t;
+            sumSq += t * t;
+        }
+        const double mean = sum / static_cast<double>(rows.size());
+        const double sd = std::sqrt(std::max(0.0, sumSq / static_cast<double>(rows.size()) - mean * mean));
+        for (size_t r = 0; r < rows.size(); ++r) {
+            double& t = x[r * NumColumns + c];
+            t = sd > 0 ? (t - mean) / sd : 0;
+        }
+    }
+    auto distance = [&](size_t r, const double* centroid) {
+        double sum = 0;
+        for (int c = 0; c < NumColumns; ++c) {
+            const double d = x[r * NumColumns + c] - centroid[c];
+            sum += d * d;
+        }
+        return std::sqrt(sum);
+    };
+
+    // K-Means++ initialization, then Lloyd iterations.
+    std::vector<double> centroids;
+    std::mt19937 rng(42);
+    const size_t first = std::uniform_int_distribution<size_t>(0, rows.size() - 1)(rng);
+    centroids.insert(centroids.end(), &x[first * NumColumns], &x[first * NumColumns] + NumColumns);
+    std::vector<double> nearest(rows.size(), 1e300);
+    for (int c = 1; c < k; ++c) {
+        double sum = 0;
+        for (size_t r = 0; r < rows.size(); ++r) {
+            nearest[r] = std::min(nearest[r], distance(r, &centroids[(c - 1) * NumColumns]));
+            sum += nearest[r];
+        }
+        const double target = std::uniform_real_distribution<double>(0, sum)(rng);
+        size_t pick = rows.size() - 1;
+        double acc = 0;
+        for (size_t r = 0; r < rows.size(); ++r) {
+            acc += nearest[r];
+            if (acc >= target) { pick = r; break; }
+        }
+        centroids.insert(centroids.end(), &x[pick * NumColumns], &x[pick * NumColumns] + NumColumns);
+    }
+    std::vector<int> assignment(rows.size(), -1);
+    std::vector<double> dist(rows.size());
+    for (int iter = 0; iter < 100; ++iter) {
+        bool changed = false;
+        for (size_t r = 0; r < rows.size(); ++r) {
+            int best = 0;
+            double bestDist = distance(r, &centroids[0]);
+            for (int c = 1; c < k; ++c) {
+                const double d = distance(r, &centroids[c * NumColumns]);
+                if (d < bestDist) { bestDist = d; best = c; }
+            }
+            dist[r] = bestDist;
+            if (assignment[r] != best) {
+                assignment[r] = best;
+                changed = true;
+            }
+        }
+        if (!changed) break;
+        std::vector<double> sums(centroids.size(), 0);
+        std::vector<size_t> counts(k, 0);
+        for (size_t r = 0; r < rows.size(); ++r) {
+            for (int c = 0; c < NumColumns; ++c) sums[assignment[r] * NumColumns + c] += x[r * NumColumns + c];
+            ++counts[assignment[r]];
+        }
+        for (int cl = 0; cl < k; ++cl) {
+            if (counts[cl] == 0) continue;
+            for (int c = 0; c < NumColumns; ++c) centroids[cl * NumColumns + c] = sums[cl * NumColumns + c] / static_cast<double>(counts[cl]);
+        }
+    }
+
+    std::vector<double> meanDist(k, 0);
+    std::vector<size_t> counts(k, 0);
+    for (size_t r = 0; r < rows.size(); ++r) {
+        meanDist[assignment[r]] += dist[r];
+        ++counts[assignment[r]];
+    }
+    for (int cl = 0; cl < k; ++cl) {
+        if (counts[cl]) meanDist[cl] /= static_cast<double>(counts[cl]);
+    }
+    for (size_t r = 0; r < rows.size(); ++r) {
+        clusters[rows[r]] = assignment[r];
+        scores[rows[r]] = meanDist[assignment[r]] > 0 ? dist[r] / meanDist[assignment[r]] : 0;
+    }
+}
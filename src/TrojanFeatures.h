@@ -0,0 +1,71 @@
+#ifndef TROJAN_FEATURES_H
+#define TROJAN_FEATURES_H
+
+#include "CompactNetlist.h"
+#include "ThreadPool.h"
+
+// Structural neighborhood features of every net for trojan detection.
+//
+// Besides the net's own CC0, CC1 and CO, each net gets aggregates over the
+// nets within `hops` gates in its fanin and in its fanout (flip-flops count
+// as one hop from their data pins to Q): their number, min/max/mean CC1 and
+// CO over the finite values, and how many of them hold a rare value. A value
+// is rare if it is INF or at least the 99th percentile of the design, so
+// rare0/rare1 mark nets that are hard to set to 0/1, as trojan triggers are.
+// Finally the distances (in gates) to the nearest primary output and to the
+// nearest flip-flop data pin downstream.
+//
+// The neighborhoods are bounded frontier expansions from every net, run on
+// the threads of a shared pool. Expansions do not pass through clock network nets and
+// stop growing at maxNeighborhood nets.
+class TrojanFeatures {
+public:
+    enum Column {
+        CC0, CC1, CO,
+        FaninNets, FaninMinCC1, FaninMaxCC1, FaninMeanCC1, FaninMinCO, FaninMaxCO, FaninMeanCO, FaninRare,
+        FanoutNets, FanoutMinCC1, FanoutMaxCC1, FanoutMeanCC1, FanoutMinCO, FanoutMaxCO, FanoutMeanCO, FanoutRare,
+        Rare0, Rare1, PODistance, FFDistance,
+        NumColumns
+    };
+    static const char* const columnNames[NumColumns];
+
+    // Metrics are indexed by net id, with INF for unreachable values.
+    TrojanFeatures(const CompactNetlist& netlist, const std::vector<int>& cc0,
+                   const std::vector<int>& cc1, const std::vector<int>& co);
+
+    int hops = 2;
+    size_t maxNeighborhood = 4096;
+
+    // Computes the features of every net on the threads of `pool`.
+    void compute(ThreadPool& pool = ThreadPool::shared());
+
+    // Clusters the nets outside clock networks with K-Means on the
+    // normalized features and scores each by its distance to its centroid
+    // relative to the mean distance in its cluster. Clock network nets get
+    // cluster -1 and score 0.
+    void score(int k = 3);
+
+    // Feature value of a net, -1 where it is INF or undefined (no finite
+    // value in the neighborhood, no path to an output or flip-flop).
+    double value(size_t net, Column c) const { return values[net * NumColumns + c]; }
+    int cluster(size_t net) const { return clusters[net]; }
+    double outlierScore(size_t net) const { return scores[net]; }
+
+private:
+    void buildGraph();
+    void distances(const std::vector<int32_t>& sources, Column column);
+    double& at(size_t net, Column c) { return values[net * NumColumns + c]; }
+
+    const CompactNetlist& nl;
+    const std::vector<int>& cc0;
+    const std::vector<int>& cc1;
+    const std::vector<int>& co;
+    // Net graph in CSR form: the nets each net is computed from and feeds.
+    std::vector<uint32_t> faninBegin, fanoutBegin;
+    std::vector<int32_t> fanin, fanout;
+    std::vector<double> values;
+    std::vector<int> clusters;
+    std::vector<double> scores;
+};
+
+#endif // TROJAN_FEATURES_H
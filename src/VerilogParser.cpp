@@ -1,140 +1,442 @@
-#include "VerilogParser.h"
-#include <iostream>
-#include <fstream>
-#include <sstream>
-
-namespace VerilogParser {
-
-// --- Helper functions (local to this file) ---
-
-// Trims leading/trailing whitespace from a string.
-static std::string trim(const std::string& str) {
-    size_t start = str.find_first_not_of(" \t\n\r");
-    if (start == std::string::npos) return "";
-    size_t end = str.find_last_not_of(" \t\n\r");
-    return str.substr(start, end - start + 1);
-}
-
-// Splits a comma-separated list into a vector of strings.
-static std::vector<std::string> splitCommaList(const std::string& s) {
-    std::vector<std::string> tokens;
-    std::stringstream ss(s);
-    std::string item;
-    while (getline(ss, item, ',')) {
-        item = trim(item);
-        if (!item.empty()) tokens.push_back(item);
-    }
-    return tokens;
-}
-
-// --- Main Parsing Logic ---
-
-void parseFile(
-    const std::string& filename,
-    std::vector<Gate>& gates,
-    std::vector<FlipFlop>& flipflops,
-    std::map<std::string, Net>& nets,
-    std::vector<std::string>& primaryInputs,
-    std::vector<std::string>& primaryOutputs
-) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        throw ParsingException("Could not open file: " + filename);
-    }
-
-    // Helper lambda to ensure a net exists in the map.
-    auto ensureNet = [&](const std::string& netName) {
-        if (netName.empty()) return;
-        if (nets.find(netName) == nets.end()) {
-            nets[netName] = {netName, "", {}, {}, -1, INF, INF, INF, INF, INF, INF, false};
-        }
-    };
-
-    std::string line;
-    while (getline(file, line)) {
-        // Pre-processing
-        size_t comment_pos = line.find("//");
-        if (comment_pos != std::string::npos) {
-            line = line.substr(0, comment_pos);
-        }
-        line = trim(line);
-        if (line.empty() || line.rfind("module", 0) == 0 || line.rfind("endmodule", 0) == 0) {
-            continue;
-        }
-
-        // Handle declarations (input, output, wire)
-        if (line.rfind("input", 0) == 0 || line.rfind("output", 0) == 0 || line.rfind("wire", 0) == 0) {
-            std::string declaration_type = line.substr(0, line.find_first_of(" \t"));
-            line.erase(0, declaration_type.length());
-            
-            // Handle multi-line declarations ending with a semicolon
-            while (line.find(';') == std::string::npos) {
-                std::string next_line;
-                if (!getline(file, next_line)) {
-                     throw ParsingException("Unterminated declaration line: " + line);
-                }
-                line += " " + trim(next_line);
-            }
-            line = trim(line.substr(0, line.find(';')));
-
-            auto names = splitCommaList(line);
-            for (const auto& n : names) {
-                ensureNet(n);
-                if (declaration_type == "input") {
-                    nets[n].type = "P";
-                    primaryInputs.push_back(n);
-                } else if (declaration_type == "output") {
-                    nets[n].type = "O";
-                    primaryOutputs.push_back(n);
-                }
-            }
-        }
-        // Handle gate/module instantiations
-        else if (line.find('(') != std::string::npos && line.back() == ';') {
-            std::stringstream line_ss(line);
-            std::string type, name;
-            line_ss >> type >> name;
-            
-            size_t paren_start = line.find('(');
-            size_t paren_end = line.rfind(')');
-            if(paren_start == std::string::npos || paren_end == std::string::npos) continue;
-
-            std::string connections_str = line.substr(paren_start + 1, paren_end - paren_start - 1);
-            auto connections = splitCommaList(connections_str);
-
-            if (type == "dff" || type == "tff" || type == "jkff" || type == "srff") {
-                FlipFlop ff;
-                ff.type = type;
-                ff.name = name;
-                if (type == "dff" && connections.size() >= 3) {
-                    ff.clk = connections[0]; ff.q = connections[1]; ff.d = connections[2];
-                } else {
-                     // Add other FF types here
-                }
-                
-                ensureNet(ff.clk); ensureNet(ff.q); ensureNet(ff.d);
-                nets[ff.q].drivenByFlipFlop = true;
-                flipflops.push_back(ff);
-
-            } else { // Combinational Gate
-                Gate gate;
-                gate.type = type;
-                gate.name = name;
-
-                if (connections.empty()) continue;
-                gate.output = connections[0];
-                gate.inputs.assign(connections.begin() + 1, connections.end());
-                
-                ensureNet(gate.output);
-                nets[gate.output].drivers.push_back(gate.name);
-                for (const auto& inp : gate.inputs) {
-                    ensureNet(inp);
-                    nets[inp].loads.push_back(gate.name);
-                }
-                gates.push_back(gate);
-            }
-        }
-    }
-}
-
-} // namespace VerilogParser
+#include "VerilogParser.h"
+#include "InputStream.h"
+#include <iostream>
+#include <cctype>
+#include <sstream>
+#include <unordered_map>
+
+namespace VerilogParser {
+
+// --- Helper functions (local to this file) ---
+
+// Trims leading/trailing whitespace from a string.
+static std::string trim(const std::string& str) {
+    size_t start = str.find_first_not_of(" \t\n\r");
+    if (start == std::string::npos) return "";
+    size_t end = str.find_last_not_of(" \t\n\r");
+    return str.substr(start, end - start + 1);
+}
+
+// Splits a comma-separated list into a vector of strings.
+static std::vector<std::string> splitCommaList(const std::string& s) {
+    std::vector<std::string> tokens;
+    std::stringstream ss(s);
+    std::string item;
+    while (getline(ss, item, ',')) {
+        item = trim(item);
+        if (!item.empty()) tokens.push_back(item);
+    }
+    return tokens;
+}
+
+// Splits a comma-separated list at the top level, keeping concatenations
+// such as "{a, b[1:0]}" in one piece.
+static std::vector<std::string> splitTopLevel(const std::string& s) {
+    std::vector<std::string> tokens;
+    int depth = 0;
+    size_t start = 0;
+    for (size_t i = 0; i <= s.size(); ++i) {
+        if (i < s.size() && s[i] == '{') ++depth;
+        else if (i < s.size() && s[i] == '}') --depth;
+        else if (i == s.size() || (s[i] == ',' && depth == 0)) {
+            std::string item = trim(s.substr(start, i - start));
+            if (!item.empty()) tokens.push_back(item);
+            start = i + 1;
+        }
+    }
+    return tokens;
+}
+
+// A declared vector: its interned base name and index range. Its bits are
+// the nets base.withBit(index); their text is never built while parsing.
+struct Bus {
+    NetName base;
+    BusRange range;
+};
+
+// Declared vectors by base name.
+using BusTable = std::unordered_map<std::string, Bus>;
+
+// The nets driven by the tie cells that constant bits are connected to.
+static const NetName& constantNet(bool one) {
+    static const NetName constants[2] = {NetName("1'b0", NetName::Scalar), NetName("1'b1", NetName::Scalar)};
+    return constants[one];
+}
+
+// Parses "msb:lsb" or a single index (msb == lsb).
+static void parseRange(const std::string& text, BusRange& range) {
+    try {
+        size_t colon = text.find(':');
+        range.msb = std::stoi(text.substr(0, colon));
+        range.lsb = colon == std::string::npos ? range.msb : std::stoi(text.substr(colon + 1));
+    } catch (const std::exception&) {
+        throw ParsingException("Unsupported range: [" + text + "]");
+    }
+}
+
+static void appendRange(const NetName& base, const BusRange& range, std::vector<NetName>& bits) {
+    const int step = range.msb >= range.lsb ? -1 : 1;
+    for (int i = range.msb;; i += step) {
+        bits.push_back(base.withBit(i));
+        if (i == range.lsb) break;
+    }
+}
+
+// Appends the bits of a constant ("4'b1010", "8'hff", "'d3", "0"), MSB first.
+static void appendConstant(const std::string& text, std::vector<NetName>& bits) {
+    std::string digits;
+    for (char c : text) {
+        if (c != '_') digits += c;
+    }
+    size_t tick = digits.find('\'');
+    size_t width = 32;
+    char base = 'd';
+    try {
+        if (tick != std::string::npos) {
+            if (tick > 0) width = std::stoul(digits.substr(0, tick));
+            size_t b = tick + 1;
+            if (b < digits.size() && (digits[b] == 's' || digits[b] == 'S')) ++b;
+            if (b >= digits.size()) throw ParsingException("");
+            base = static_cast<char>(std::tolower(static_cast<unsigned char>(digits[b])));
+            digits = digits.substr(b + 1);
+        }
+        std::vector<bool> value; // LSB first
+        if (base == 'd') {
+            unsigned long long v = std::stoull(digits);
+            for (; v; v >>= 1) value.push_back(v & 1);
+        } else {
+            const int perDigit = base == 'b' ? 1 : base == 'o' ? 3 : base == 'h' ? 4 : 0;
+            if (perDigit == 0 || digits.empty()) throw ParsingException("");
+            for (size_t i = digits.size(); i-- > 0;) {
+                const int d = std::isxdigit(static_cast<unsigned char>(digits[i]))
+                    ? std::stoi(std::string(1, digits[i]), nullptr, 16) : -1;
+                if (d < 0 || d >= (1 << perDigit)) throw ParsingException("");
+                for (int k = 0; k < perDigit; ++k) value.push_back((d >> k) & 1);
+            }
+        }
+        for (size_t i = width; i-- > 0;) {
+            bits.push_back(constantNet(i < value.size() && value[i]));
+        }
+    } catch (const std::exception&) {
+        throw ParsingException("Unsupported constant: " + text);
+    }
+}
+
+// Appends the bits of a net reference, MSB first: a scalar net, a whole bus,
+// a bit or part select, a constant, or a (replicated) concatenation of these.
+static void appendBits(const std::string& expr, const BusTable& buses, std::vector<NetName>& bits) {
+    if (expr.empty()) return;
+    if (expr.front() == '{') {
+        if (expr.back() != '}') throw ParsingException("Unterminated concatenation: " + expr);
+        const std::string inner = trim(expr.substr(1, expr.size() - 2));
+        size_t count = inner.find_first_not_of("0123456789");
+        if (count > 0 && count != std::string::npos && inner[count] == '{') {
+            const int times = std::stoi(inner.substr(0, count));
+            std::vector<NetName> once;
+            appendBits(trim(inner.substr(count)), buses, once);
+            for (int t = 0; t < times; ++t) bits.insert(bits.end(), once.begin(), once.end());
+            return;
+        }
+        for (const auto& part : splitTopLevel(inner)) appendBits(part, buses, bits);
+        return;
+    }
+    if (std::isdigit(static_cast<unsigned char>(expr.front())) || expr.front() == '\'') {
+        appendConstant(expr, bits);
+        return;
+    }
+    size_t open = expr.find('[');
+    if (open != std::string::npos) {
+        size_t close = expr.find(']', open);
+        if (close == std::string::npos) throw ParsingException("Unterminated select: " + expr);
+        BusRange range;
+        parseRange(trim(expr.substr(open + 1, close - open - 1)), range);
+        const std::string base = trim(expr.substr(0, open));
+        auto bus = buses.find(base);
+        appendRange(bus != buses.end() ? bus->second.base : NetName(base, NetName::Scalar), range, bits);
+        return;
+    }
+    auto bus = buses.empty() ? buses.end() : buses.find(expr);
+    if (bus != buses.end()) appendRange(bus->second.base, bus->second.range, bits);
+    else bits.emplace_back(expr, NetName::Scalar);
+}
+
+// Recognizes flip-flop types: a base type (dff, tff, jkff, srff) followed by
+// optional suffix letters, each at most once: 'e' (clock enable), 'r'
+// (asynchronous reset) and 's' (asynchronous set). Ports are connected as
+// clk, q, the data pins of the base type (d | t | j, k | s, r), then one pin
+// per suffix letter in the order the letters appear.
+static bool parseFlipFlopType(const std::string& type, FlipFlopType& kind, std::string& suffix) {
+    static const std::pair<const char*, FlipFlopType> bases[] = {
+        {"jkff", FlipFlopType::JK}, {"srff", FlipFlopType::SR},
+        {"dff", FlipFlopType::D}, {"tff", FlipFlopType::T},
+    };
+    for (const auto& base : bases) {
+        if (type.rfind(base.first, 0) != 0) continue;
+        suffix = type.substr(std::string(base.first).size());
+        for (size_t i = 0; i < suffix.size(); ++i) {
+            char c = suffix[i];
+            if ((c != 'e' && c != 'r' && c != 's') || suffix.find(c) != i) return false;
+        }
+        kind = base.second;
+        return true;
+    }
+    return false;
+}
+
+// --- Main Parsing Logic ---
+
+void parse(std::istream& file, Listener& listener) {
+    bool tieEmitted[2] = {false, false};
+
+    // Constant bits are nets driven by a tie cell, emitted on first use.
+    auto useConstants = [&](const std::vector<NetName>& bits) {
+        for (const auto& n : bits) {
+            if (n != constantNet(false) && n != constantNet(true)) continue;
+            const bool one = n == constantNet(true);
+            if (tieEmitted[one]) continue;
+            tieEmitted[one] = true;
+            Gate tie;
+            tie.type = one ? "tie1" : "tie0";
+            tie.name = n.str();
+            tie.output = n;
+            listener.onGate(std::move(tie));
+        }
+    };
+
+    // Reads continuation lines until the statement's semicolon.
+    auto readStatement = [&](std::string& statement, const std::string& what) {
+        while (statement.find(';') == std::string::npos) {
+            std::string next_line;
+            if (!getline(file, next_line)) {
+                throw ParsingException("Unterminated " + what + " line: " + statement);
+            }
+            statement += " " + trim(next_line.substr(0, next_line.find("//")));
+        }
+    };
+
+    BusTable buses;
+    std::string line;
+    while (getline(file, line)) {
+        // Pre-processing
+        size_t comment_pos = line.find("//");
+        if (comment_pos != std::string::npos) {
+            line = line.substr(0, comment_pos);
+        }
+        line = trim(line);
+        if (line.empty() || line.rfind("module", 0) == 0 || line.rfind("endmodule", 0) == 0) {
+            continue;
+        }
+
+        // Handle declarations (input, output, wire), optionally with a range
+        if (line.rfind("input", 0) == 0 || line.rfind("output", 0) == 0 || line.rfind("wire", 0) == 0) {
+            std::string declaration_type = line.substr(0, line.find_first_of(" \t["));
+            line.erase(0, declaration_type.length());
+            readStatement(line, "declaration");
+            line = trim(line.substr(0, line.find(';')));
+            if (line.rfind("wire", 0) == 0 || line.rfind("reg", 0) == 0) {
+                line = trim(line.substr(line.find_first_of(" \t[") == std::string::npos ? line.size() : line.find_first_of(" \t[")));
+            }
+
+            bool vector = false;
+            BusRange range{0, 0};
+            if (!line.empty() && line.front() == '[') {
+                size_t close = line.find(']');
+                if (close == std::string::npos) throw ParsingException("Unterminated range: " + line);
+                parseRange(trim(line.substr(1, close - 1)), range);
+                line.erase(0, close + 1);
+                vector = true;
+            }
+
+            const bool port = declaration_type != "wire";
+            const PortDirection direction = declaration_type == "input" ? PortDirection::Input : PortDirection::Output;
+            auto names = splitCommaList(line);
+            for (const auto& n : names) {
+                const NetName net(n, NetName::Scalar);
+                listener.onNet(net, vector ? &range : nullptr);
+                if (!vector) {
+                    if (port) listener.onPort(net, direction);
+                    continue;
+                }
+                buses[n] = Bus{net, range};
+                if (!port) continue; // Bits of wires are created when referenced
+                std::vector<NetName> bits;
+                appendRange(net, range, bits);
+                for (const auto& bit : bits) listener.onPort(bit, direction);
+            }
+        }
+        // Handle continuous assignments: each bit becomes a buffer
+        else if (line.rfind("assign", 0) == 0 && (line.size() == 6 || !std::isalnum(static_cast<unsigned char>(line[6])))) {
+            readStatement(line, "assign");
+            line = trim(line.substr(6, line.find(';') - 6));
+            for (const auto& assignment : splitTopLevel(line)) {
+                size_t eq = assignment.find('=');
+                if (eq == std::string::npos) throw ParsingException("Malformed assign: " + assignment);
+                std::vector<NetName> lhs, rhs;
+                appendBits(trim(assignment.substr(0, eq)), buses, lhs);
+                const std::string source = trim(assignment.substr(eq + 1));
+                if (source.find_first_of("~!&|^?()+-*<>") != std::string::npos) {
+                    throw ParsingException("Unsupported assign expression (only nets, selects, concatenations and constants): " + source);
+                }
+                appendBits(source, buses, rhs);
+                if (rhs.size() < lhs.size()) rhs.insert(rhs.begin(), lhs.size() - rhs.size(), constantNet(false));
+                useConstants(rhs);
+                // Bits are matched from the LSB; a shorter source is zero-extended.
+                for (size_t i = 0; i < lhs.size(); ++i) {
+                    const NetName& to = lhs[lhs.size() - 1 - i];
+                    Gate gate;
+                    gate.type = "buf";
+                    gate.kind = GateType::Buf;
+                    gate.name = "assign:" + to.str();
+                    gate.output = to;
+                    gate.inputs.push_back(rhs[rhs.size() - 1 - i]);
+                    listener.onGate(std::move(gate));
+                }
+            }
+        }
+        // Handle gate/module instantiations
+        else if (line.find('(') != std::string::npos && line.back() == ';') {
+            std::stringstream line_ss(line);
+            std::string type, name;
+            line_ss >> type >> name;
+            name = trim(name.substr(0, name.find('('))); // "DFF_0(CK,...)" has no space before the ports
+            
+            size_t paren_start = line.find('(');
+            size_t paren_end = line.rfind(')');
+            if(paren_start == std::string::npos || paren_end == std::string::npos) continue;
+
+            std::string connections_str = line.substr(paren_start + 1, paren_end - paren_start - 1);
+            std::vector<NetName> connections;
+            for (const auto& c : splitTopLevel(connections_str)) {
+                size_t width = connections.size();
+                appendBits(c, buses, connections);
+                if (connections.size() - width != 1) {
+                    throw ParsingException("Port connection " + c + " of " + name + " is "
+                                           + std::to_string(connections.size() - width) + " bits wide");
+                }
+            }
+            useConstants(connections);
+
+            FlipFlopType ffKind;
+            std::string ffSuffix;
+            if (parseFlipFlopType(type, ffKind, ffSuffix)) {
+                FlipFlop ff;
+                ff.type = type;
+                ff.kind = ffKind;
+                ff.name = name;
+
+                size_t pin = 0;
+                auto next = [&]() { return pin < connections.size() ? connections[pin++] : NetName(); };
+                ff.clk = next();
+                ff.q = next();
+                switch (ffKind) {
+                case FlipFlopType::D:  ff.d = next(); break;
+                case FlipFlopType::T:  ff.t = next(); break;
+                case FlipFlopType::JK: ff.j = next(); ff.k = next(); break;
+                case FlipFlopType::SR: ff.s = next(); ff.r = next(); break;
+                case FlipFlopType::Unknown: break;
+                }
+                for (char c : ffSuffix) {
+                    if (c == 'e') ff.en = next();
+                    else if (c == 'r') ff.rst = next();
+                    else ff.set = next();
+                }
+                listener.onFlipFlop(std::move(ff));
+
+            } else { // Combinational Gate
+                Gate gate;
+                gate.type = type;
+                gate.kind = gateTypeFromString(type);
+                gate.name = name;
+
+                if (connections.empty()) continue;
+                gate.output = connections[0];
+                gate.inputs.assign(connections.begin() + 1, connections.end());
+                listener.onGate(std::move(gate));
+            }
+        }
+    }
+}
+
+void parseFile(const std::string& filename, Listener& listener) {
+    InputStream file(filename);
+    if (!file.is_open()) {
+        throw ParsingException("Could not open file: " + filename);
+    }
+    parse(file, listener);
+    if (file.failed()) {
+        throw ParsingException(file.error());
+    }
+}
+
+namespace {
+
+// Collects the statements into the containers of parseFile().
+class NetlistBuilder : public Listener {
+public:
+    NetlistBuilder(std::vector<Gate>& gates, std::vector<FlipFlop>& flipflops, NetMap& nets,
+                   std::vector<NetName>& primaryInputs, std::vector<NetName>& primaryOutputs)
+        : gates(gates), flipflops(flipflops), nets(nets), primaryInputs(primaryInputs), primaryOutputs(primaryOutputs) {}
+
+    void onNet(const NetName& name, const BusRange* range) override {
+        if (!range) ensureNet(name);
+    }
+
+    void onPort(const NetName& name, PortDirection direction) override {
+        Net& net = ensureNet(name);
+        if (direction == PortDirection::Input) {
+            net.type = "P";
+            primaryInputs.push_back(name);
+        } else {
+            net.type = "O";
+            primaryOutputs.push_back(name);
+        }
+    }
+
+    void onGate(Gate&& gate) override {
+        ensureNet(gate.output).drivers.push_back(gate.name);
+        for (const auto& inp : gate.inputs) {
+            ensureNet(inp).loads.push_back(gate.name);
+        }
+        gates.push_back(std::move(gate));
+    }
+
+    void onFlipFlop(FlipFlop&& ff) override {
+        for (const NetName* port : {&ff.clk, &ff.q, &ff.d, &ff.t, &ff.j, &ff.k,
+                                        &ff.s, &ff.r, &ff.en, &ff.set, &ff.rst}) {
+            if (!port->empty()) ensureNet(*port);
+        }
+        if (!ff.q.empty()) nets[ff.q].drivenByFlipFlop = true;
+        flipflops.push_back(std::move(ff));
+    }
+
+private:
+    Net& ensureNet(const NetName& netName) {
+        auto it = nets.find(netName);
+        if (it == nets.end()) {
+            it = nets.emplace(netName, Net{netName, "", {}, {}, -1, INF, INF, INF, INF, INF, INF, false, false}).first;
+        }
+        return it->second;
+    }
+
+    std::vector<Gate>& gates;
+    std::vector<FlipFlop>& flipflops;
+    NetMap& nets;
+    std::vector<NetName>& primaryInputs;
+    std::vector<NetName>& primaryOutputs;
+};
+
+} // namespace
+
+void parseFile(
+    const std::string& filename,
+    std::vector<Gate>& gates,
+    std::vector<FlipFlop>& flipflops,
+    NetMap& nets,
+    std::vector<NetName>& primaryInputs,
+    std::vector<NetName>& primaryOutputs
+) {
+    NetlistBuilder builder(gates, flipflops, nets, primaryInputs, primaryOutputs);
+    parseFile(filename, builder);
+}
+
+} // namespace VerilogParser
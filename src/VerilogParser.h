@@ -1,29 +1,66 @@
-#ifndef VERILOG_PARSER_H
-#define VERILOG_PARSER_H
-
-#include "DataStructures.h"
-#include <stdexcept>
-
-// A custom exception for parsing errors.
-class ParsingException : public std::runtime_error {
-public:
-    explicit ParsingException(const std::string& message)
-        : std::runtime_error(message) {}
-};
-
-// Namespace to contain all Verilog parsing logic.
-namespace VerilogParser {
-
-    // Main function to parse a Verilog file and populate the circuit data structures.
-    void parseFile(
-        const std::string& filename,
-        std::vector<Gate>& gates,
-        std::vector<FlipFlop>& flipflops,
-        std::map<std::string, Net>& nets,
-        std::vector<std::string>& primaryInputs,
-        std::vector<std::string>& primaryOutputs
-    );
-
-} // namespace VerilogParser
-
-#endif // VERILOG_PARSER_H
+#ifndef VERILOG_PARSER_H
+#define VERILOG_PARSER_H
+
+#include "DataStructures.h"
+#include <istream>
+#include <stdexcept>
+
+// A custom exception for parsing errors.
+class ParsingException : public std::runtime_error {
+public:
+    explicit ParsingException(const std::string& message)
+        : std::runtime_error(message) {}
+};
+
+// Namespace to contain all Verilog parsing logic.
+namespace VerilogParser {
+
+    // The declared index range of a vector net; its bits are the nets
+    // NetName(name, index), from msb to lsb.
+    struct BusRange {
+        int msb, lsb;
+    };
+
+    enum class PortDirection { Input, Output };
+
+    // Receives the statements of a netlist in file order as they are parsed,
+    // without the parser building any netlist of its own. All net names are
+    // bit-level: a bus bit is its bus's interned name and an index, and no
+    // "<name>[<index>]" text is built for it. The default handlers ignore
+    // their statement.
+    class Listener {
+    public:
+        virtual ~Listener() = default;
+
+        // A declared net (input, output or wire); range is null for scalars.
+        // Nets that are used without a declaration are not reported.
+        virtual void onNet(const NetName& name, const BusRange* range) { (void)name; (void)range; }
+        // A primary input or output bit, after its onNet.
+        virtual void onPort(const NetName& net, PortDirection direction) { (void)net; (void)direction; }
+        // A gate, an assign buffer, or the tie cell driving a constant bit
+        // (named and driving 1'b0 or 1'b1) before the first statement that
+        // uses the constant. The listener may keep (move from) the gate.
+        virtual void onGate(Gate&& gate) { (void)gate; }
+        virtual void onFlipFlop(FlipFlop&& ff) { (void)ff; }
+    };
+
+    // Parses a netlist from a stream. Throws ParsingException.
+    void parse(std::istream& in, Listener& listener);
+
+    // Parses a Verilog file, or standard input for "-", which may be
+    // compressed (see InputStream). Throws ParsingException.
+    void parseFile(const std::string& filename, Listener& listener);
+
+    // Main function to parse a Verilog file and populate the circuit data structures.
+    void parseFile(
+        const std::string& filename,
+        std::vector<Gate>& gates,
+        std::vector<FlipFlop>& flipflops,
+        NetMap& nets,
+        std::vector<NetName>& primaryInputs,
+        std::vector<NetName>& primaryOutputs
+    );
+
+} // namespace VerilogParser
+
+#endif // VERILOG_PARSER_H
@@ -1,166 +1,204 @@
-#include "VerilogParser.h"
-#include <iostream>
-#include <fstream>
-#include <sstream>
-#include "Circuit.h"
-#include <filesystem>
-
-namespace VerilogParser {
-
-// --- Helper functions (local to this file) ---
-
-// Trims leading/trailing whitespace from a string.
-static std::string trim(const std::string& str) {
-    size_t start = str.find_first_not_of(" \t\n\r");
-    if (start == std::string::npos) return "";
-    size_t end = str.find_last_not_of(" \t\n\r");
-    return str.substr(start, end - start + 1);
-}
-
-// Splits a comma-separated list into a vector of strings.
-static std::vector<std::string> splitCommaList(const std::string& s) {
-    std::vector<std::string> tokens;
-    std::stringstream ss(s);
-    std::string item;
-    while (getline(ss, item, ',')) {
-        item = trim(item);
-        if (!item.empty()) tokens.push_back(item);
-    }
-    return tokens;
-}
-
-// --- Main Parsing Logic ---
-
-void parseFile(
-    const std::string& filename,
-    std::vector<Gate>& gates,
-    std::vector<FlipFlop>& flipflops,
-    std::map<std::string, Net>& nets,
-    std::vector<std::string>& primaryInputs,
-    std::vector<std::string>& primaryOutputs
-) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        throw ParsingException("Could not open file: " + filename);
-    }
-
-    // Helper lambda to ensure a net exists in the map.
-    auto ensureNet = [&](const std::string& netName) {
-        if (netName.empty()) return;
-        if (nets.find(netName) == nets.end()) {
-            nets[netName] = {netName, "", {}, {}, -1, INF, INF, INF, INF, INF, INF, false};
-        }
-    };
-
-    std::string line;
-    while (getline(file, line)) {
-        // Pre-processing
-        size_t comment_pos = line.find("//");
-        if (comment_pos != std::string::npos) {
-            line = line.substr(0, comment_pos);
-        }
-        line = trim(line);
-        if (line.empty() || line.rfind("module", 0) == 0 || line.rfind("endmodule", 0) == 0) {
-            continue;
-        }
-
-        // Handle declarations (input, output, wire)
-        if (line.rfind("input", 0) == 0 || line.rfind("output", 0) == 0 || line.rfind("wire", 0) == 0) {
-            std::string declaration_type = line.substr(0, line.find_first_of(" \t"));
-            line.erase(0, declaration_type.length());
-            
-            // Handle multi-line declarations ending with a semicolon
-            while (line.find(';') == std::string::npos) {
-                std::string next_line;
-                if (!getline(file, next_line)) {
-                     throw ParsingException("Unterminated declaration line: " + line);
-                }
-                line += " " + trim(next_line);
-            }
-            line = trim(line.substr(0, line.find(';')));
-
-            auto names = splitCommaList(line);
-            for (const auto& n : names) {
-                ensureNet(n);
-                if (declaration_type == "input") {
-                    nets[n].type = "P";
-                    primaryInputs.push_back(n);
-                } else if (declaration_type == "output") {
-                    nets[n].type = "O";
-                    primaryOutputs.push_back(n);
-                }
-            }
-        }
-        // Handle gate/module instantiations
-        else if (line.find('(') != std::string::npos && line.back() == ';') {
-            std::stringstream line_ss(line);
-            std::string type, name;
-            line_ss >> type >> name;
-            
-            size_t paren_start = line.find('(');
-            size_t paren_end = line.rfind(')');
-            if(paren_start == std::string::npos || paren_end == std::string::npos) continue;
-
-            std::string connections_str = line.substr(paren_start + 1, paren_end - paren_start - 1);
-            auto connections = splitCommaList(connections_str);
-
-            if (type == "dff" || type == "tff" || type == "jkff" || type == "srff") {
-                FlipFlop ff;
-                ff.type = type;
-                ff.name = name;
-                if (type == "dff" && connections.size() >= 3) {
-                    ff.clk = connections[0]; ff.q = connections[1]; ff.d = connections[2];
-                } else {
-                     // Add other FF types here
-                }
-                
-                ensureNet(ff.clk); ensureNet(ff.q); ensureNet(ff.d);
-                nets[ff.q].drivenByFlipFlop = true;
-                flipflops.push_back(ff);
-
-            } else { // Combinational Gate
-                Gate gate;
-                gate.type = type;
-                gate.name = name;
-
-                if (connections.empty()) continue;
-                gate.output = connections[0];
-                gate.inputs.assign(connections.begin() + 1, connections.end());
-                
-                ensureNet(gate.output);
-                nets[gate.output].drivers.push_back(gate.name);
-                for (const auto& inp : gate.inputs) {
-                    ensureNet(inp);
-                    nets[inp].loads.push_back(gate.name);
-                }
-                gates.push_back(gate);
-            }
-        }
-    }
-}
-
-} // namespace VerilogParser
-
-int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <verilog_file>" << std::endl;
-        return 1;
-    }
-    std::string verilogFile = argv[1];
-    std::string outputDir = "output";
-    std::filesystem::create_directory(outputDir);
-    std::string scoapCsv = outputDir + "/scoap_results.csv";
-    std::string kmeansCsv = outputDir + "/kmeans_results.csv";
-
-    Circuit circuit;
-    if (!circuit.loadFromVerilog(verilogFile)) {
-        std::cerr << "Failed to parse Verilog file." << std::endl;
-        return 1;
-    }
-    circuit.calculateAllScoapMetrics();
-    circuit.writeScoapResultsToCSV(scoapCsv);
-    circuit.runKMeansOnScoap(kmeansCsv, 3);
-    circuit.printDebugInfo(outputDir);
-    std::cout << "Analysis complete. Results in '" << outputDir << "'." << std::endl;
-    return 0;
-}
+#include "Circuit.h"
+#include "TaskGraph.h"
+#include <iostream>
+#include <filesystem>
+#include <cstdlib>
+
+int main(int argc, char* argv[]) {
+    std::string verilogFile;
+    int metricBits = 32;
+    std::string cellFile;
+    std::string scanSpec;
+    std::string scanSetsFile;
+    bool scanRank = false;
+    bool clockDomains = false;
+    bool columnar = false;
+    bool stats = false;
+    int trojanHops = 0;
+    std::string goldenFile;
+    std::string cacheDir;
+    std::vector<std::string> explainNets;
+    int diffThreshold = 0;
+    double memoryBudget = 0;
+    double timeBudget = 0;
+    std::string checkpointFile;
+    int workers = 1;
+    bool bindNuma = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--metric-bits" && i + 1 < argc) {
+            metricBits = std::atoi(argv[++i]);
+        } else if (arg == "--cells" && i + 1 < argc) {
+            cellFile = argv[++i];
+        } else if (arg == "--scan" && i + 1 < argc) {
+            scanSpec = argv[++i];
+        } else if (arg == "--scan-sets" && i + 1 < argc) {
+            scanSetsFile = argv[++i];
+        } else if (arg == "--memory-budget" && i + 1 < argc) {
+            memoryBudget = std::atof(argv[++i]);
+            if (memoryBudget <= 0) {
+                std::cerr << "Invalid memory budget: " << argv[i] << " (expected megabytes > 0)" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--time-budget" && i + 1 < argc) {
+            timeBudget = std::atof(argv[++i]);
+            if (timeBudget <= 0) {
+                std::cerr << "Invalid time budget: " << argv[i] << " (expected seconds > 0)" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--checkpoint" && i + 1 < argc) {
+            checkpointFile = argv[++i];
+        } else if (arg == "--workers" && i + 1 < argc) {
+            workers = std::atoi(argv[++i]);
+        } else if (arg == "--numa") {
+            bindNuma = true;
+        } else if (arg == "--clock-domains") {
+            clockDomains = true;
+        } else if (arg == "--trojan-features" && i + 1 < argc) {
+            trojanHops = std::atoi(argv[++i]);
+            if (trojanHops <= 0) {
+                std::cerr << "Invalid neighborhood radius: " << argv[i] << " (expected hops > 0)" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--explain" && i + 1 < argc) {
+            explainNets.push_back(argv[++i]);
+        } else if (arg == "--cache" && i + 1 < argc) {
+            cacheDir = argv[++i];
+        } else if (arg == "--golden" && i + 1 < argc) {
+            goldenFile = argv[++i];
+        } else if (arg == "--diff-threshold" && i + 1 < argc) {
+            diffThreshold = std::atoi(argv[++i]);
+            if (diffThreshold < 0) {
+                std::cerr << "Invalid diff threshold: " << argv[i] << " (expected N >= 0)" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--columnar") {
+            columnar = true;
+        } else if (arg == "--stats") {
+            stats = true;
+        } else if (arg == "--scan-rank") {
+            scanRank = true;
+        } else if (verilogFile.empty() && arg.rfind("--", 0) != 0) {
+            verilogFile = arg;
+        } else {
+            verilogFile.clear();
+            break;
+        }
+    }
+    if (verilogFile.empty()) {
+        std::cerr << "Usage: " << argv[0] << " [--metric-bits 16|32] [--cells <cell_file>]"
+                  << " [--scan all|<ff_list>] [--scan-rank] [--scan-sets <sets_file>] [--clock-domains]"
+                  << " [--columnar] [--stats] [--trojan-features <hops>] [--golden <verilog_file> [--diff-threshold <N>]]"
+                  << " [--cache <dir>] [--explain <net>] [--time-budget <seconds>] [--checkpoint <file>]"
+                  << " [--memory-budget <MB>] [--workers <N> [--numa]]"
+                  << " <verilog_file>|-" << std::endl;
+        return 1;
+    }
+    if (goldenFile == "-" && verilogFile == "-") {
+        std::cerr << "Only one netlist can be read from standard input." << std::endl;
+        return 1;
+    }
+    std::string outputDir = "output";
+    std::filesystem::create_directory(outputDir);
+    std::string scoapCsv = outputDir + "/scoap_results.csv";
+    std::string kmeansCsv = outputDir + "/kmeans_results.csv";
+
+    Circuit circuit;
+    if (!circuit.setMetricWidth(metricBits)) {
+        std::cerr << "Unsupported metric width: " << metricBits << " (expected 16 or 32)" << std::endl;
+        return 1;
+    }
+    if (timeBudget > 0) {
+        circuit.setTimeBudget(timeBudget);
+    }
+    circuit.setCheckpoint(checkpointFile);
+    if (memoryBudget > 0) {
+        circuit.setMemoryBudget(memoryBudget);
+    }
+    if (!cacheDir.empty()) {
+        circuit.setResultCache(cacheDir);
+    }
+    if (!circuit.setWorkers(workers, bindNuma)) {
+        std::cerr << "Invalid worker count: " << workers << " (expected 1 or more)" << std::endl;
+        return 1;
+    }
+    if (workers > 1 && memoryBudget > 0) {
+        std::cerr << "--workers cannot be combined with --memory-budget" << std::endl;
+        return 1;
+    }
+    if (!explainNets.empty() && (workers > 1 || memoryBudget > 0)) {
+        std::cerr << "--explain cannot be combined with --workers or --memory-budget" << std::endl;
+        return 1;
+    }
+    if ((timeBudget > 0 || !checkpointFile.empty()) && (workers > 1 || memoryBudget > 0)) {
+        std::cerr << "--time-budget and --checkpoint cannot be combined with --workers or --memory-budget" << std::endl;
+        return 1;
+    }
+    if (!cellFile.empty() && !circuit.loadCellLibrary(cellFile)) {
+        return 1;
+    }
+    if (!scanSpec.empty() && !circuit.setScanMode(scanSpec)) {
+        return 1;
+    }
+
+    // The stages form a task graph: everything after the analysis only reads
+    // the finished metrics, so the reports are written concurrently. With a
+    // golden netlist, the input file is the suspect; both are analyzed with
+    // the same settings (and time budget, but neither the checkpoint nor the
+    // --explain traces, which are for the suspect only). Runs that
+    // fork worker processes or use scratch files keep the stages sequential,
+    // in the order they are added. The stages and the parallel work inside
+    // them share one thread pool.
+    ThreadPool pool;
+    circuit.setThreadPool(pool);
+    Circuit golden = circuit;
+    golden.setCheckpoint("");
+    for (const auto& net : explainNets) {
+        circuit.explainNet(net);
+    }
+    const bool concurrent = workers == 1 && memoryBudget == 0;
+    TaskGraph stages;
+    auto analyze = [](Circuit& c, const std::string& file) {
+        if (!c.loadFromVerilog(file)) {
+            std::cerr << "Failed to parse Verilog file." << std::endl;
+            return false;
+        }
+        c.calculateAllScoapMetrics();
+        return true;
+    };
+    const auto analysis = stages.add("analysis", [&] { return analyze(circuit, verilogFile); });
+    auto goldenAnalysis = analysis;
+    if (!goldenFile.empty()) {
+        goldenAnalysis = stages.add("golden analysis", [&] { return analyze(golden, goldenFile); });
+    }
+    stages.add("results", [&] { circuit.writeScoapResultsToCSV(scoapCsv); return true; }, {analysis});
+    stages.add("k-means", [&] { circuit.runKMeansOnScoap(kmeansCsv, 3); return true; }, {analysis});
+    if (columnar) {
+        stages.add("columnar export", [&] { return circuit.writeColumnarExport(outputDir + "/scoap_nets.col"); }, {analysis});
+    }
+    if (stats) {
+        stages.add("statistics", [&] { return circuit.writeMetricStatistics(outputDir); }, {analysis});
+    }
+    if (scanRank) {
+        stages.add("scan ranking", [&] { circuit.writeScanRanking(outputDir + "/scan_ranking.csv"); return true; }, {analysis});
+    }
+    if (clockDomains) {
+        stages.add("clock domains", [&] { return circuit.writeClockDomainReport(outputDir); }, {analysis});
+    }
+    if (trojanHops > 0) {
+        stages.add("trojan features", [&] { return circuit.writeTrojanFeatures(outputDir + "/trojan_features.csv", trojanHops); }, {analysis});
+    }
+    if (!goldenFile.empty()) {
+        stages.add("netlist diff", [&] { return circuit.writeNetlistDiff(golden, outputDir + "/netlist_diff.csv", diffThreshold); },
+                   {analysis, goldenAnalysis});
+    }
+    if (!scanSetsFile.empty()) {
+        stages.add("scan sets", [&] { return circuit.evaluateScanSets(scanSetsFile, outputDir + "/scan_sets.csv"); }, {analysis});
+    }
+    stages.add("debug info", [&] { circuit.printDebugInfo(outputDir); return true; }, {analysis});
+    if (!stages.run(pool, concurrent ? 0 : 1)) {
+        return 1;
+    }
+    std::cout << "Analysis complete. Results in '" << outputDir << "'." << std::endl;
+    return 0;
+}
@@ -0,0 +1,422 @@
+#include "ReferenceEngine.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+using Value = uint64_t;
+
+struct NetState {
+    Value cc0, cc1, sc0, sc1, co, so;
+    bool primaryInput = false, primaryOutput = false;
+    bool pseudoInput = false, pseudoOutput = false;
+    bool flipFlopOutput = false;
+};
+
+// A flip-flop with its pins resolved; absent pins are null.
+struct FlipFlopPins {
+    FlipFlopType kind;
+    NetState *clk, *q, *in0, *in1, *en, *set, *rst;
+};
+
+class Reference {
+public:
+    Reference(const std::vector<Gate>& gates, const std::vector<FlipFlop>& flipflops,
+              const NetMap& netMap, const std::vector<NetName>& primaryOutputs,
+              const CellLibrary& library, const std::set<std::string>& scanned, Value infinity)
+        : gates(gates), cells(library), inf(infinity) {
+        for (const auto& pair : netMap) {
+            NetState& net = nets[pair.first.str()];
+            net.cc0 = net.cc1 = net.sc0 = net.sc1 = net.co = net.so = inf;
+            net.primaryInput = pair.second.type == "P";
+            net.flipFlopOutput = pair.second.drivenByFlipFlop;
+        }
+        for (const auto& name : primaryOutputs) {
+            if (NetState* net = find(name)) net->primaryOutput = true;
+        }
+
+        // Flip-flops with an unconnected clock, output or data pin are ignored.
+        for (const FlipFlop& ff : flipflops) {
+            FlipFlopPins pins{ff.kind, find(ff.clk), find(ff.q), nullptr, nullptr,
+                              find(ff.en), find(ff.set), find(ff.rst)};
+            bool connected = true;
+            switch (ff.kind) {
+            case FlipFlopType::D:  pins.in0 = find(ff.d); connected = pins.in0; break;
+            case FlipFlopType::T:  pins.in0 = find(ff.t); connected = pins.in0; break;
+            case FlipFlopType::JK: pins.in0 = find(ff.j); pins.in1 = find(ff.k); connected = pins.in0 && pins.in1; break;
+            case FlipFlopType::SR: pins.in0 = find(ff.s); pins.in1 = find(ff.r); connected = pins.in0 && pins.in1; break;
+            case FlipFlopType::Unknown: connected = false; break;
+            }
+            if (!connected || !pins.clk || !pins.q) continue;
+            if (scanned.count(ff.name)) {
+                // A scan cell is a pseudo primary input and output pair.
+                pins.q->pseudoInput = true;
+                pins.in0->pseudoOutput = true;
+                if (pins.in1) pins.in1->pseudoOutput = true;
+                continue;
+            }
+            flops.push_back(pins);
+        }
+    }
+
+    void computeAll() {
+        computeCC();
+        computeSC();
+        computeCO();
+        computeSO();
+    }
+
+    std::map<std::string, ReferenceEngine::Metrics> results() const {
+        auto report = [this](Value v) { return v >= inf || v >= static_cast<Value>(INF) ? INF : static_cast<int>(v); };
+        std::map<std::string, ReferenceEngine::Metrics> out;
+        for (const auto& pair : nets) {
+            const NetState& n = pair.second;
+            out[pair.first] = {report(n.cc0), report(n.cc1), report(n.sc0), report(n.sc1), report(n.co), report(n.so)};
+        }
+        return out;
+    }
+
+private:
+    const std::vector<Gate>& gates;
+    const CellLibrary& cells;
+    const Value inf;
+    std::map<std::string, NetState> nets;
+    std::vector<FlipFlopPins> flops;
+
+    // Nets are looked up by their text, independently of NetName.
+    NetState* find(const NetName& name) {
+        if (name.empty()) return nullptr;
+        auto it = nets.find(name.str());
+        return it == nets.end() ? nullptr : &it->second;
+    }
+
+    Value add(Value a, Value b) const { return std::min(a + b, inf); }
+
+    // Lowers `target` to `value`; returns true if it improved.
+    static bool improve(Value& target, Value value) {
+        if (value >= target) return false;
+        target = value;
+        return true;
+    }
+
+    // The connected inputs of a gate.
+    std::vector<NetState*> inputsOf(const Gate& g) {
+        std::vector<NetState*> in;
+        for (const auto& name : g.inputs) {
+            if (NetState* net = find(name)) in.push_back(net);
+        }
+        return in;
+    }
+
+    // The cell rule of a gate of unknown primitive type, or null.
+    const CellRule* cellOf(const Gate& g) const {
+        if (g.kind != GateType::Unknown) return nullptr;
+        const int id = cells.find(g.type);
+        return id < 0 ? nullptr : &cells.rule(id);
+    }
+
+    // Cost of the cheapest cube of a cover, reading the given controllabilities.
+    Value cheapestCube(const std::vector<CellCube>& cover, const std::vector<NetState*>& in,
+                       Value NetState::*c0, Value NetState::*c1) const {
+        Value best = inf;
+        for (const CellCube& cube : cover) {
+            Value cost = 0;
+            for (size_t p = 0; p < in.size(); ++p) {
+                if (!(cube.care >> p & 1u)) continue;
+                cost = add(cost, (cube.value >> p & 1u) ? in[p]->*c1 : in[p]->*c0);
+            }
+            best = std::min(best, cost);
+        }
+        return best;
+    }
+
+    // The cost of setting the output of g to 0 and to 1, without the cost of
+    // the gate itself, from the controllabilities c0/c1 of its inputs.
+    // Returns false if the gate cannot be evaluated.
+    bool controllability(const Gate& g, Value NetState::*c0, Value NetState::*c1, Value& out0, Value& out1) {
+        const std::vector<NetState*> in = inputsOf(g);
+        const CellRule* cell = cellOf(g);
+        if (cell) {
+            if (in.size() != cell->pins.size()) return false;
+            out0 = cheapestCube(cell->offSet, in, c0, c1);
+            out1 = cheapestCube(cell->onSet, in, c0, c1);
+            return true;
+        }
+        if (in.empty()) return false;
+        switch (g.kind) {
+        case GateType::And: case GateType::Nand: case GateType::Or: case GateType::Nor: {
+            // One input at the controlling value decides the output; the
+            // other output value needs all inputs at the non-controlling one.
+            const bool controlling = g.kind == GateType::Or || g.kind == GateType::Nor;
+            const bool inverted = g.kind == GateType::Nand || g.kind == GateType::Nor;
+            Value any = inf, all = 0;
+            for (NetState* n : in) {
+                any = std::min(any, controlling ? n->*c1 : n->*c0);
+                all = add(all, controlling ? n->*c0 : n->*c1);
+            }
+            const bool decided = controlling != inverted;
+            out0 = decided ? all : any;
+            out1 = decided ? any : all;
+            return true;
+        }
+        case GateType::Xor: case GateType::Xnor: {
+            // Every assignment of the inputs, by the parity of its ones.
+            if (in.size() > 16) throw std::invalid_argument("Reference engine: xor gate " + g.name + " is too wide");
+            Value even = inf, odd = inf;
+            for (uint32_t bits = 0; bits < (1u << in.size()); ++bits) {
+                Value cost = 0;
+                int ones = 0;
+                for (size_t p = 0; p < in.size(); ++p) {
+                    const bool one = bits >> p & 1u;
+                    cost = add(cost, one ? in[p]->*c1 : in[p]->*c0);
+                    ones += one;
+                }
+                (ones % 2 ? odd : even) = std::min(ones % 2 ? odd : even, cost);
+            }
+            out0 = g.kind == GateType::Xor ? even : odd;
+            out1 = g.kind == GateType::Xor ? odd : even;
+            return true;
+        }
+        case GateType::Not:
+            out0 = in[0]->*c1;
+            out1 = in[0]->*c0;
+            return true;
+        case GateType::Buf:
+            out0 = in[0]->*c0;
+            out1 = in[0]->*c1;
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    // The cost of making input pin i of g observable at the output, without
+    // the output's observability and the cost of the gate, for every pin
+    // (inf where it is not observable), from the controllabilities c0/c1.
+    std::vector<Value> sensitization(const Gate& g, const std::vector<NetState*>& in,
+                                     Value NetState::*c0, Value NetState::*c1) const {
+        std::vector<Value> cost(in.size(), inf);
+        const CellRule* cell = cellOf(g);
+        if (cell) {
+            if (in.size() != cell->pins.size()) return cost;
+            for (size_t i = 0; i < in.size(); ++i) cost[i] = cheapestCube(cell->sensitize[i], in, c0, c1);
+            return cost;
+        }
+        for (size_t i = 0; i < in.size(); ++i) {
+            switch (g.kind) {
+            case GateType::And: case GateType::Nand: case GateType::Or: case GateType::Nor: {
+                // All other inputs at the non-controlling value.
+                const bool controlling = g.kind == GateType::Or || g.kind == GateType::Nor;
+                cost[i] = 0;
+                for (size_t j = 0; j < in.size(); ++j) {
+                    if (j != i) cost[i] = add(cost[i], controlling ? in[j]->*c0 : in[j]->*c1);
+                }
+                break;
+            }
+            case GateType::Xor: case GateType::Xnor:
+                // All other inputs at a known value.
+                cost[i] = 0;
+                for (size_t j = 0; j < in.size(); ++j) {
+                    if (j != i) cost[i] = add(cost[i], std::min(in[j]->*c0, in[j]->*c1));
+                }
+                break;
+            case GateType::Not: case GateType::Buf:
+                cost[i] = 0;
+                break;
+            default:
+                break;
+            }
+        }
+        return cost;
+    }
+
+    void computeCC() {
+        for (auto& pair : nets) {
+            NetState& n = pair.second;
+            if (n.primaryInput || n.flipFlopOutput) n.cc0 = n.cc1 = 1;
+        }
+        bool changed;
+        do {
+            changed = false;
+            for (const Gate& g : gates) {
+                NetState* out = find(g.output);
+                Value v0, v1;
+                if (!out || !controllability(g, &NetState::cc0, &NetState::cc1, v0, v1)) continue;
+                changed |= improve(out->cc0, add(v0, 1));
+                changed |= improve(out->cc1, add(v1, 1));
+            }
+        } while (changed);
+    }
+
+    void computeSC() {
+        for (auto& pair : nets) {
+            NetState& n = pair.second;
+            if (n.primaryInput || n.pseudoInput) n.sc0 = n.sc1 = 0;
+        }
+        bool changed;
+        do {
+            changed = false;
+            for (const Gate& g : gates) {
+                NetState* out = find(g.output);
+                Value v0, v1;
+                if (!out || !controllability(g, &NetState::sc0, &NetState::sc1, v0, v1)) continue;
+                changed |= improve(out->sc0, v0);
+                changed |= improve(out->sc1, v1);
+            }
+            for (const FlipFlopPins& ff : flops) changed |= flipFlopControllability(ff);
+        } while (changed);
+    }
+
+    void computeCO() {
+        for (auto& pair : nets) {
+            NetState& n = pair.second;
+            if (n.primaryOutput || n.pseudoOutput) n.co = 0;
+        }
+        bool changed;
+        do {
+            changed = false;
+            for (const Gate& g : gates) {
+                NetState* out = find(g.output);
+                if (!out) continue;
+                const std::vector<NetState*> in = inputsOf(g);
+                const std::vector<Value> cost = sensitization(g, in, &NetState::cc0, &NetState::cc1);
+                for (size_t i = 0; i < in.size(); ++i) changed |= improve(in[i]->co, add(add(out->co, 1), cost[i]));
+            }
+        } while (changed);
+    }
+
+    void computeSO() {
+        for (auto& pair : nets) {
+            NetState& n = pair.second;
+            if (n.primaryOutput || n.pseudoOutput) n.so = 0;
+        }
+        bool changed;
+        do {
+            changed = false;
+            for (const FlipFlopPins& ff : flops) changed |= flipFlopObservability(ff);
+            for (const Gate& g : gates) {
+                NetState* out = find(g.output);
+                if (!out) continue;
+                const std::vector<NetState*> in = inputsOf(g);
+                const std::vector<Value> cost = sensitization(g, in, &NetState::sc0, &NetState::sc1);
+                for (size_t i = 0; i < in.size(); ++i) changed |= improve(in[i]->so, add(out->so, cost[i]));
+            }
+        } while (changed);
+    }
+
+    // SC of Q. A clocked transition costs one time frame, both clock values,
+    // the enable at 1 and the asynchronous set and reset at 0; the
+    // asynchronous pins set or reset Q in one time frame by themselves.
+    bool flipFlopControllability(const FlipFlopPins& ff) {
+        const Value setOff = ff.set ? ff.set->sc0 : 0;
+        const Value rstOff = ff.rst ? ff.rst->sc0 : 0;
+        Value frame = add(add(ff.clk->sc0, ff.clk->sc1), 1);
+        if (ff.en) frame = add(frame, ff.en->sc1);
+        frame = add(add(frame, setOff), rstOff);
+
+        const NetState& a = *ff.in0;
+        const NetState& q = *ff.q;
+        Value q0 = inf, q1 = inf;
+        switch (ff.kind) {
+        case FlipFlopType::D:
+            q0 = a.sc0;
+            q1 = a.sc1;
+            break;
+        case FlipFlopType::T: // Toggle from the other state
+            q0 = add(q.sc1, a.sc1);
+            q1 = add(q.sc0, a.sc1);
+            break;
+        case FlipFlopType::JK: { // J=0 K=1 resets, J=1 K=0 sets, J=K=1 toggles
+            const NetState& b = *ff.in1;
+            q0 = std::min(add(a.sc0, b.sc1), add(add(q.sc1, a.sc1), b.sc1));
+            q1 = std::min(add(a.sc1, b.sc0), add(add(q.sc0, a.sc1), b.sc1));
+            break;
+        }
+        case FlipFlopType::SR: { // S=0 R=1 resets, S=1 R=0 sets
+            const NetState& b = *ff.in1;
+            q0 = add(a.sc0, b.sc1);
+            q1 = add(a.sc1, b.sc0);
+            break;
+        }
+        case FlipFlopType::Unknown:
+            break;
+        }
+        q0 = add(q0, frame);
+        q1 = add(q1, frame);
+        if (ff.rst) q0 = std::min(q0, add(add(ff.rst->sc1, setOff), 1));
+        if (ff.set) q1 = std::min(q1, add(add(ff.set->sc1, rstOff), 1));
+
+        bool changed = improve(ff.q->sc0, q0);
+        changed |= improve(ff.q->sc1, q1);
+        return changed;
+    }
+
+    // SO of the input pins from the SO of Q: a pin is observed when its
+    // value decides the next state.
+    bool flipFlopObservability(const FlipFlopPins& ff) {
+        const NetState& q = *ff.q;
+        const Value soQ = q.so;
+        if (soQ >= inf) return false;
+        const Value setOff = ff.set ? ff.set->sc0 : 0;
+        const Value rstOff = ff.rst ? ff.rst->sc0 : 0;
+        const Value clocked = add(add(soQ, add(ff.clk->sc0, ff.clk->sc1)), 1);
+        const Value frame = add(add(clocked, ff.en ? ff.en->sc1 : 0), add(setOff, rstOff));
+
+        NetState& a = *ff.in0;
+        bool changed = false;
+        // Cost of a clock edge that changes the state, for the enable.
+        Value change = inf;
+        switch (ff.kind) {
+        case FlipFlopType::D:
+            changed |= improve(a.so, frame);
+            change = std::min(add(a.sc0, q.sc1), add(a.sc1, q.sc0));
+            break;
+        case FlipFlopType::T: {
+            const Value known = std::min(q.sc0, q.sc1);
+            changed |= improve(a.so, add(frame, known));
+            change = add(a.sc1, known);
+            break;
+        }
+        case FlipFlopType::JK: { // Q=0: the next state is J; Q=1: it is !K
+            NetState& b = *ff.in1;
+            changed |= improve(a.so, add(frame, q.sc0));
+            changed |= improve(b.so, add(frame, q.sc1));
+            change = std::min(add(add(a.sc1, b.sc0), q.sc0), add(add(a.sc0, b.sc1), q.sc1));
+            break;
+        }
+        case FlipFlopType::SR: {
+            NetState& b = *ff.in1;
+            changed |= improve(a.so, add(add(frame, b.sc0), q.sc0));
+            changed |= improve(b.so, add(add(frame, a.sc0), q.sc1));
+            change = std::min(add(add(a.sc1, b.sc0), q.sc0), add(add(a.sc0, b.sc1), q.sc1));
+            break;
+        }
+        case FlipFlopType::Unknown:
+            break;
+        }
+        if (ff.en) changed |= improve(ff.en->so, add(add(clocked, add(setOff, rstOff)), change));
+        if (ff.rst) changed |= improve(ff.rst->so, add(add(add(soQ, q.sc1), setOff), 1));
+        if (ff.set) changed |= improve(ff.set->so, add(add(add(soQ, q.sc0), rstOff), 1));
+        return changed;
+    }
+};
+
+} // namespace
+
+namespace ReferenceEngine {
+
+std::map<std::string, Metrics> compute(
+    const std::vector<Gate>& gates,
+    const std::vector<FlipFlop>& flipflops,
+    const NetMap& nets,
+    const std::vector<NetName>& primaryOutputs,
+    const CellLibrary& cells,
+    const std::set<std::string>& scanned,
+    uint64_t inf
+) {
+    Reference reference(gates, flipflops, nets, primaryOutputs, cells, scanned, inf);
+    reference.computeAll();
+    return reference.results();
+}
+
+} // namespace ReferenceEngine
@@ -0,0 +1,47 @@
+#ifndef REFERENCE_ENGINE_H
+#define REFERENCE_ENGINE_H
+
+#include "CellLibrary.h"
+#include "DataStructures.h"
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+// The reference SCOAP engine of the differential tests.
+//
+// It computes the metrics of ScoapEngine in the most direct way: nets are
+// looked up by name, and every rule (gates, clock buffers and flip-flops
+// alike) is applied to the whole netlist again and again until no value
+// improves. All rules are monotone, so this reaches the same fixpoint as the
+// levelized, batched, partitioned and distributed engines, whatever order
+// they evaluate in. It shares no code with them beyond the parsed netlist
+// and the cell rules, and it is kept deliberately simple: do not optimize it.
+// It is quadratic and meant for netlists of a few hundred gates, with at
+// most one driver per net.
+namespace ReferenceEngine {
+
+    struct Metrics {
+        int cc0 = INF, cc1 = INF;
+        int sc0 = INF, sc1 = INF;
+        int co = INF, so = INF;
+    };
+
+    // Computes all metrics with sums saturating at `inf` (the INF sentinel
+    // of the engine's metric storage); saturated values are reported as
+    // ::INF, like the metrics of Net. `scanned` holds the instance names of
+    // the scan flip-flops.
+    std::map<std::string, Metrics> compute(
+        const std::vector<Gate>& gates,
+        const std::vector<FlipFlop>& flipflops,
+        const NetMap& nets,
+        const std::vector<NetName>& primaryOutputs,
+        const CellLibrary& cells,
+        const std::set<std::string>& scanned,
+        uint64_t inf
+    );
+
+} // namespace ReferenceEngine
+
+#endif // REFERENCE_ENGINE_H
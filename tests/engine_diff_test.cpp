@@ -0,0 +1,423 @@
+// Differential test of the SCOAP engines.
+//
+// Generates random sequential netlists (reconvergent fanout, wide gates,
+// complex cells, combinational loops, flip-flop feedback, clock trees,
+// gated and derived clocks, enables and asynchronous set/reset, constants,
+// undriven nets, scan cells) as Verilog, and requires every engine to
+// report the same CC0/CC1/SC0/SC1/CO/SO as the reference engine
+// (ReferenceEngine.h) on every net:
+//   - the in-memory engine (CC, then SC and CO concurrently, then SO),
+//     with the justification trace of --explain recorded,
+//   - the same with 16-bit metric storage,
+//   - the out-of-core PartitionedEngine, cut into many small partitions,
+//   - the DistributedEngine in three worker processes,
+//   - the in-memory engine resumed from the checkpoint of a run stopped
+//     by its time budget after one round of SC and SO,
+//   - the results reloaded from the result cache,
+//   - the in-memory engine on a netlist built by CompactNetlistBuilder
+//     straight from the parser, without a Circuit.
+//
+// Usage: engine_diff_test [designs] [seed]
+// The first design that disagrees is kept as engine_diff_failure.v (with its
+// scan list in engine_diff_failure.scan) and the test fails.
+
+#include "Circuit.h"
+#include "CompactNetlistBuilder.h"
+#include "ReferenceEngine.h"
+#include "ScoapEngine.h"
+#include "VerilogParser.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Discards what the engines print about their progress.
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+};
+
+struct Design {
+    std::string verilog;
+    std::vector<std::string> flipFlops; // Instance names
+    size_t gates = 0;
+};
+
+struct CellShape {
+    const char* name;
+    int pins;
+};
+const CellShape kCells[] = {
+    {"mux2", 3}, {"ao21", 3}, {"aoi22", 4}, {"aoi211", 4}, {"oa22", 4}, {"oai21", 3}, {"oai211", 4},
+};
+
+// Generates a random netlist. Gate n<i> drives net n<i>; its inputs are
+// mostly recent nets (deep paths) and otherwise any net (reconvergence),
+// and now and then a net driven later, which closes combinational loops.
+Design generateDesign(std::mt19937& rng) {
+    auto chance = [&](double p) { return std::uniform_real_distribution<double>(0, 1)(rng) < p; };
+    auto between = [&](int lo, int hi) { return std::uniform_int_distribution<int>(lo, hi)(rng); };
+
+    Design design;
+    const int numInputs = between(1, 10);
+    const int numFlipFlops = chance(0.2) ? 0 : between(1, 12);
+    const int numGates = chance(0.1) ? between(150, 400) : between(3, 120);
+    const int numUndriven = chance(0.3) ? between(1, 2) : 0;
+
+    std::vector<std::string> inputs{"clk", "rst"}, wires;
+    std::vector<std::string> pool; // Nets gates may read, in creation order
+    for (int i = 0; i < numInputs; ++i) {
+        inputs.push_back("a" + std::to_string(i));
+        pool.push_back(inputs.back());
+    }
+    for (int i = 0; i < numFlipFlops; ++i) {
+        wires.push_back("q" + std::to_string(i));
+        pool.push_back(wires.back());
+    }
+    for (int i = 0; i < numUndriven; ++i) wires.push_back("u" + std::to_string(i));
+
+    std::ostringstream body;
+    auto pick = [&]() -> std::string {
+        if (numUndriven > 0 && chance(0.01)) return "u" + std::to_string(between(0, numUndriven - 1));
+        if (chance(0.02)) return chance(0.5) ? "1'b0" : "1'b1";
+        if (chance(0.7)) return pool[pool.size() - 1 - between(0, std::min<int>(7, static_cast<int>(pool.size()) - 1))];
+        return pool[between(0, static_cast<int>(pool.size()) - 1)];
+    };
+
+    for (int i = 0; i < numGates; ++i) {
+        const std::string out = "n" + std::to_string(i);
+        std::string type;
+        int arity;
+        const int kind = between(0, 99);
+        if (kind < 45) {
+            static const char* andOr[] = {"and", "nand", "or", "nor"};
+            type = andOr[between(0, 3)];
+            const int width = between(0, 99);
+            arity = width < 55 ? 2 : width < 85 ? between(3, 4) : width < 95 ? between(5, 8) : between(9, 40);
+        } else if (kind < 58) {
+            type = chance(0.5) ? "xor" : "xnor";
+            arity = chance(0.8) ? between(2, 4) : between(5, 8);
+        } else if (kind < 78) {
+            type = chance(0.5) ? "not" : "buf";
+            arity = 1;
+        } else if (kind < 98) {
+            const CellShape& cell = kCells[between(0, static_cast<int>(std::size(kCells)) - 1)];
+            type = cell.name;
+            arity = cell.pins;
+        } else {
+            type = "blackbox"; // Neither a primitive nor a cell
+            arity = between(1, 3);
+        }
+        body << "  " << type << " g" << i << " (" << out;
+        for (int k = 0; k < arity; ++k) {
+            // A net driven later in the file; a loop if it depends on this gate.
+            if (i + 1 < numGates && chance(0.03)) body << ", n" << between(i + 1, std::min(numGates - 1, i + 6));
+            else body << ", " << pick();
+        }
+        body << ");\n";
+        wires.push_back(out);
+        pool.push_back(out);
+    }
+    design.gates = static_cast<size_t>(numGates);
+
+    // Clock and reset trees of buffers and inverters, gated clocks, and
+    // clocks derived from flip-flop outputs.
+    std::vector<std::string> clocks{"clk"}, resets{"rst"};
+    const int treeNets = numFlipFlops > 0 ? between(0, 6) : 0;
+    for (int i = 0; i < treeNets; ++i) {
+        const bool reset = chance(0.3);
+        std::vector<std::string>& tree = reset ? resets : clocks;
+        const std::string net = (reset ? "rb" : "cb") + std::to_string(i);
+        body << "  " << (chance(0.5) ? "buf" : "not") << " t" << i << " (" << net << ", "
+             << tree[between(0, static_cast<int>(tree.size()) - 1)] << ");\n";
+        wires.push_back(net);
+        tree.push_back(net);
+        ++design.gates;
+    }
+    if (numFlipFlops > 0 && chance(0.2)) {
+        body << "  and cg (gclk, clk, " << pick() << ");\n";
+        wires.push_back("gclk");
+        clocks.push_back("gclk");
+        ++design.gates;
+    }
+    if (numFlipFlops > 1 && chance(0.2)) clocks.push_back("q" + std::to_string(between(0, numFlipFlops - 1)));
+
+    for (int i = 0; i < numFlipFlops; ++i) {
+        static const char* bases[] = {"dff", "tff", "jkff", "srff"};
+        const int base = chance(0.5) ? 0 : between(1, 3);
+        std::string suffix;
+        for (char c : std::string("ers")) {
+            if (chance(0.25)) suffix += c;
+        }
+        std::shuffle(suffix.begin(), suffix.end(), rng);
+        const std::string name = "f" + std::to_string(i);
+        body << "  " << bases[base] << suffix << " " << name << " ("
+             << (chance(0.9) ? clocks[between(0, static_cast<int>(clocks.size()) - 1)] : pick())
+             << ", q" << i << ", " << pick();
+        if (base >= 2) body << ", " << pick();
+        for (char c : suffix) {
+            const bool async = c != 'e';
+            body << ", " << (async && chance(0.7) ? resets[between(0, static_cast<int>(resets.size()) - 1)] : pick());
+        }
+        body << ");\n";
+        design.flipFlops.push_back(name);
+    }
+
+    // Primary outputs: some of the gate outputs and flip-flop outputs.
+    std::vector<std::string> outputs;
+    const int numOutputs = between(1, std::max(1, numGates / 4));
+    for (int i = 0; i < numOutputs; ++i) {
+        std::string net = chance(0.1) && numFlipFlops > 0 ? "q" + std::to_string(between(0, numFlipFlops - 1))
+                                                          : "n" + std::to_string(between(0, numGates - 1));
+        if (std::find(outputs.begin(), outputs.end(), net) == outputs.end()) outputs.push_back(net);
+    }
+    wires.erase(std::remove_if(wires.begin(), wires.end(), [&](const std::string& w) {
+        return std::find(outputs.begin(), outputs.end(), w) != outputs.end();
+    }), wires.end());
+
+    std::ostringstream text;
+    auto list = [&](const std::vector<std::string>& names) {
+        for (size_t i = 0; i < names.size(); ++i) text << (i ? ", " : "") << names[i];
+    };
+    std::vector<std::string> ports = inputs;
+    ports.insert(ports.end(), outputs.begin(), outputs.end());
+    text << "module random_design (";
+    list(ports);
+    text << ");\n  input ";
+    list(inputs);
+    text << ";\n  output ";
+    list(outputs);
+    text << ";\n";
+    if (!wires.empty()) {
+        text << "  wire ";
+        list(wires);
+        text << ";\n";
+    }
+    text << body.str() << "endmodule\n";
+    design.verilog = text.str();
+    return design;
+}
+
+struct Variant {
+    const char* name;
+    uint64_t inf; // INF sentinel of the metric storage
+    std::function<void(Circuit&)> configure;
+};
+
+// Compares the nets of a circuit with the reference. Returns the number of
+// mismatching metrics and prints the first few.
+size_t compare(const Circuit& circuit, const std::map<std::string, ReferenceEngine::Metrics>& expected,
+               const char* variant) {
+    static const char* names[] = {"CC0", "CC1", "SC0", "SC1", "CO", "SO"};
+    size_t mismatches = 0;
+    const auto& nets = circuit.getNets();
+    if (nets.size() != expected.size()) {
+        std::cerr << variant << ": " << nets.size() << " nets, the reference has " << expected.size() << std::endl;
+        return 1;
+    }
+    for (const auto& pair : nets) {
+        auto it = expected.find(pair.first.str());
+        if (it == expected.end()) {
+            std::cerr << variant << ": net " << pair.first << " is not in the reference" << std::endl;
+            ++mismatches;
+            continue;
+        }
+        const Net& n = pair.second;
+        const ReferenceEngine::Metrics& e = it->second;
+        const int actual[] = {n.cc0, n.cc1, n.sc0, n.sc1, n.co, n.so};
+        const int wanted[] = {e.cc0, e.cc1, e.sc0, e.sc1, e.co, e.so};
+        for (int m = 0; m < 6; ++m) {
+            if (actual[m] == wanted[m]) continue;
+            if (++mismatches <= 10) {
+                std::cerr << variant << ": " << names[m] << "(" << pair.first << ") = " << actual[m]
+                          << ", reference " << wanted[m] << std::endl;
+            }
+        }
+    }
+    return mismatches;
+}
+
+// Builds the netlist with CompactNetlistBuilder, runs the in-memory engine
+// and compares it with the reference like compare().
+size_t compareBuilder(const std::string& netlistFile, const CellLibrary& cells, const std::set<std::string>& scanned,
+                      const std::map<std::string, ReferenceEngine::Metrics>& expected) {
+    using M = Metric<uint32_t>;
+    static const char* names[] = {"CC0", "CC1", "SC0", "SC1", "CO", "SO"};
+    CompactNetlistBuilder builder(&cells);
+    VerilogParser::parseFile(netlistFile, builder);
+    CompactNetlist netlist = builder.finish();
+    std::vector<uint8_t> mask;
+    for (const auto& name : builder.flipFlopNames()) mask.push_back(scanned.count(name) ? 1 : 0);
+    netlist.applyScan(mask);
+    netlist.reorderForLocality();
+    ScoapEngine<uint32_t> engine(netlist);
+    engine.computeCombinationalControllability();
+    engine.computeCombinationalObservability();
+    engine.computeSequentialControllability();
+    engine.computeSequentialObservability();
+
+    if (netlist.numNets() != expected.size()) {
+        std::cerr << "builder: " << netlist.numNets() << " nets, the reference has " << expected.size() << std::endl;
+        return 1;
+    }
+    size_t mismatches = 0;
+    for (size_t id = 0; id < netlist.numNets(); ++id) {
+        const NetName& name = builder.netNames()[netlist.netPosition[id]];
+        auto it = expected.find(name.str());
+        if (it == expected.end()) {
+            std::cerr << "builder: net " << name << " is not in the reference" << std::endl;
+            ++mismatches;
+            continue;
+        }
+        const ReferenceEngine::Metrics& e = it->second;
+        const int actual[] = {M::toInt(engine.cc0[id]), M::toInt(engine.cc1[id]), M::toInt(engine.sc0[id]),
+                              M::toInt(engine.sc1[id]), M::toInt(engine.co[id]), M::toInt(engine.so[id])};
+        const int wanted[] = {e.cc0, e.cc1, e.sc0, e.sc1, e.co, e.so};
+        for (int m = 0; m < 6; ++m) {
+            if (actual[m] == wanted[m]) continue;
+            if (++mismatches <= 10) {
+                std::cerr << "builder: " << names[m] << "(" << name << ") = " << actual[m] << ", reference "
+                          << wanted[m] << std::endl;
+            }
+        }
+    }
+    return mismatches;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const long designs = argc > 1 ? std::atol(argv[1]) : 1000;
+    const unsigned seed = argc > 2 ? static_cast<unsigned>(std::stoul(argv[2])) : 1;
+    if (designs < 1) {
+        std::cerr << "Usage: " << argv[0] << " [designs] [seed]" << std::endl;
+        return 1;
+    }
+
+    const fs::path dir = fs::temp_directory_path()
+        / ("scoap_engine_diff_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+    fs::create_directories(dir);
+    const std::string netlistFile = (dir / "design.v").string();
+    const std::string scanFile = (dir / "design.scan").string();
+    const std::string cacheDir = (dir / "cache").string();
+    const std::string checkpointFile = (dir / "design.checkpoint").string();
+
+    std::string explain, scanSpec;
+    auto resume = [&](Circuit& c) {
+        Circuit stopped;
+        stopped.loadFromVerilog(netlistFile);
+        if (!scanSpec.empty()) stopped.setScanMode(scanSpec);
+        stopped.setTimeBudget(1e-9);
+        stopped.setCheckpoint(checkpointFile);
+        stopped.calculateAllScoapMetrics();
+        c.setCheckpoint(checkpointFile);
+    };
+    const Variant variants[] = {
+        {"in-memory", UINT32_MAX, [&](Circuit& c) { c.explainNet(explain); }},
+        {"16-bit", UINT16_MAX, [](Circuit& c) { c.setMetricWidth(16); }},
+        {"partitioned", UINT32_MAX, [](Circuit& c) { c.setMemoryBudget(0.004); }},
+        {"distributed", UINT32_MAX, [](Circuit& c) { c.setWorkers(3); }},
+        {"resumed", UINT32_MAX, resume},
+        {"cache store", UINT32_MAX, [&](Circuit& c) { c.setResultCache(cacheDir); }},
+        {"cache load", UINT32_MAX, [&](Circuit& c) { c.setResultCache(cacheDir); }},
+    };
+
+    std::mt19937 rng(seed);
+    const CellLibrary cells = CellLibrary::builtin();
+    NullBuffer null;
+    std::streambuf* console = std::cout.rdbuf();
+    size_t totalGates = 0, totalFlipFlops = 0, failures = 0;
+    const auto start = std::chrono::steady_clock::now();
+
+    for (long d = 0; d < designs && failures == 0; ++d) {
+        Design design = generateDesign(rng);
+        totalGates += design.gates;
+        totalFlipFlops += design.flipFlops.size();
+        std::ofstream(netlistFile) << design.verilog;
+
+        // No scan, full scan, or a random subset of the flip-flops.
+        std::set<std::string> scanned;
+        scanSpec.clear();
+        const int scanMode = static_cast<int>(rng() % 6);
+        if (scanMode == 1) {
+            scanSpec = "all";
+            scanned.insert(design.flipFlops.begin(), design.flipFlops.end());
+        } else if (scanMode >= 4 && !design.flipFlops.empty()) {
+            std::ofstream list(scanFile);
+            for (const auto& name : design.flipFlops) {
+                if (rng() % 2) continue;
+                list << name << "\n";
+                scanned.insert(name);
+            }
+            scanSpec = scanFile;
+        }
+
+        std::vector<Gate> gates;
+        std::vector<FlipFlop> flipflops;
+        NetMap nets;
+        std::vector<NetName> primaryInputs, primaryOutputs;
+        VerilogParser::parseFile(netlistFile, gates, flipflops, nets, primaryInputs, primaryOutputs);
+        auto it = nets.begin();
+        std::advance(it, rng() % nets.size());
+        explain = it->first.str();
+
+        std::map<uint64_t, std::map<std::string, ReferenceEngine::Metrics>> expected;
+        for (const Variant& variant : variants) {
+            auto& reference = expected[variant.inf];
+            if (reference.empty()) {
+                reference = ReferenceEngine::compute(gates, flipflops, nets, primaryOutputs, cells, scanned, variant.inf);
+            }
+
+            Circuit circuit;
+            std::streambuf* errors = std::cerr.rdbuf(&null);
+            std::cout.rdbuf(&null);
+            bool loaded = circuit.loadFromVerilog(netlistFile);
+            if (loaded && !scanSpec.empty()) loaded = circuit.setScanMode(scanSpec);
+            if (loaded) {
+                variant.configure(circuit);
+                circuit.calculateAllScoapMetrics();
+            }
+            std::cout.rdbuf(console);
+            std::cerr.rdbuf(errors);
+            if (!loaded || compare(circuit, reference, variant.name) > 0) {
+                std::cerr << "Design " << d << " (seed " << seed << ") differs in the " << variant.name
+                          << " engine; kept as engine_diff_failure.v" << std::endl;
+                fs::copy_file(netlistFile, "engine_diff_failure.v", fs::copy_options::overwrite_existing);
+                std::ofstream("engine_diff_failure.scan") << (scanSpec == "all" ? "all\n" : "");
+                if (!scanSpec.empty() && scanSpec != "all") {
+                    fs::copy_file(scanFile, "engine_diff_failure.scan", fs::copy_options::overwrite_existing);
+                }
+                ++failures;
+                break;
+            }
+        }
+        if (failures == 0 && compareBuilder(netlistFile, cells, scanned, expected[UINT32_MAX]) > 0) {
+            std::cerr << "Design " << d << " (seed " << seed << ") differs in the builder netlist; kept as engine_diff_failure.v"
+                      << std::endl;
+            fs::copy_file(netlistFile, "engine_diff_failure.v", fs::copy_options::overwrite_existing);
+            ++failures;
+        }
+    }
+
+    std::error_code ignored;
+    fs::remove_all(dir, ignored);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (failures > 0) return 1;
+    std::cout << designs << " random designs (" << totalGates << " gates, " << totalFlipFlops
+              << " flip-flops) agree with the reference in " << std::size(variants) + 1 << " engine configurations ("
+              << seconds << " s, " << static_cast<long>(designs / seconds * 60) << " designs/min)." << std::endl;
+    return 0;
+}
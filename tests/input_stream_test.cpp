@@ -0,0 +1,224 @@
+// Test of the compressed input path (InputStream).
+//
+// Writes the same netlist as plain text, as gzip and (in builds with
+// libzstd) as zstd files, and requires InputStream to return exactly the
+// text and the parser to read every gate. Compressed files are padded to
+// sizes at and around multiples of the 256 KiB read size, so that a member
+// or frame ends exactly where a read ends, and are concatenated from
+// several members or frames. Truncated files must be reported as failed.
+//
+// Usage: input_stream_test
+
+#include "InputStream.h"
+#include "VerilogParser.h"
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#ifdef SCOAP_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef SCOAP_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr size_t kReadSize = 1 << 18; // InputStream's compressed bytes per read
+
+// A chain of `gates` and gates as one module.
+std::string netlist(size_t gates) {
+    std::string v = "module chain(a, b, y);\ninput a, b;\noutput y;\nwire w0";
+    for (size_t g = 1; g < gates; ++g) v += ", w" + std::to_string(g);
+    v += ";\nbuf g0(w0, a);\n";
+    for (size_t g = 1; g < gates; ++g) {
+        v += "and g" + std::to_string(g) + "(w" + std::to_string(g) + ", w" + std::to_string(g - 1) + ", b);\n";
+    }
+    v += "buf out(y, w" + std::to_string(gates - 1) + ");\nendmodule\n";
+    return v;
+}
+
+class GateCounter : public VerilogParser::Listener {
+public:
+    void onGate(Gate&&) override { ++gates; }
+    size_t gates = 0;
+};
+
+size_t failures = 0;
+
+void fail(const std::string& what) {
+    std::cerr << "FAIL: " << what << std::endl;
+    ++failures;
+}
+
+// Reads `file` through InputStream and the parser and checks the result.
+void check(const std::string& label, const fs::path& file, const std::string& text, size_t gates, bool truncated) {
+    InputStream in(file.string());
+    const std::string read((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (truncated) {
+        if (!in.failed()) fail(label + ": a truncated file was read without an error");
+        return;
+    }
+    if (in.failed()) fail(label + ": " + in.error());
+    if (read != text) fail(label + ": read " + std::to_string(read.size()) + " bytes, expected " + std::to_string(text.size()));
+    GateCounter counter;
+    try {
+        VerilogParser::parseFile(file.string(), counter);
+    } catch (const std::exception& e) {
+        fail(label + ": " + e.what());
+        return;
+    }
+    if (counter.gates != gates) fail(label + ": parsed " + std::to_string(counter.gates) + " gates, expected " + std::to_string(gates));
+}
+
+void write(const fs::path& file, const std::string& bytes) {
+    std::ofstream(file, std::ios::binary) << bytes;
+}
+
+#ifdef SCOAP_HAVE_ZLIB
+// One gzip member of `data`. A non-empty `name` is stored in the header,
+// which pads the member by name.size() + 1 bytes.
+std::string gzipMember(const std::string& data, int level, const std::string& name) {
+    z_stream zs{};
+    deflateInit2(&zs, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+    gz_header header{};
+    std::vector<Bytef> nameBytes(name.begin(), name.end());
+    nameBytes.push_back(0);
+    if (!name.empty()) {
+        header.name = nameBytes.data();
+        deflateSetHeader(&zs, &header);
+    }
+    std::string out(deflateBound(&zs, data.size()) + name.size() + 64, '\0');
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    zs.avail_in = static_cast<uInt>(data.size());
+    zs.next_out = reinterpret_cast<Bytef*>(&out[0]);
+    zs.avail_out = static_cast<uInt>(out.size());
+    deflate(&zs, Z_FINISH);
+    out.resize(zs.total_out);
+    deflateEnd(&zs);
+    return out;
+}
+
+// `text` split into `members` gzip members, padded to exactly `size` bytes.
+std::string gzipOfSize(const std::string& text, size_t members, size_t size) {
+    std::vector<std::string> parts;
+    size_t unpadded = 0;
+    for (size_t m = 0; m < members; ++m) {
+        const size_t begin = text.size() * m / members, end = text.size() * (m + 1) / members;
+        parts.push_back(text.substr(begin, end - begin));
+        unpadded += gzipMember(parts.back(), 0, "").size();
+    }
+    if (unpadded + 2 > size) return "";
+    std::string out;
+    for (size_t m = 0; m < members; ++m) {
+        out += gzipMember(parts[m], 0, m + 1 == members ? std::string(size - unpadded - 1, 'p') : "");
+    }
+    return out;
+}
+#endif
+
+#ifdef SCOAP_HAVE_ZSTD
+std::string zstdFrame(const std::string& data) {
+    std::string out(ZSTD_compressBound(data.size()), '\0');
+    out.resize(ZSTD_compress(&out[0], out.size(), data.data(), data.size(), 3));
+    return out;
+}
+
+// A skippable frame of `size` bytes (at least 8).
+std::string zstdSkippable(size_t size) {
+    std::string out(size, '\0');
+    const uint32_t words[2] = {0x184D2A50u, static_cast<uint32_t>(size - 8)};
+    for (int w = 0; w < 2; ++w) {
+        for (int b = 0; b < 4; ++b) out[4 * w + b] = static_cast<char>(words[w] >> (8 * b));
+    }
+    return out;
+}
+
+// `text` in two frames, padded by a skippable frame at the end to exactly
+// `size` bytes.
+std::string zstdOfSize(const std::string& text, size_t size) {
+    const std::string out = zstdFrame(text.substr(0, text.size() / 2)) + zstdFrame(text.substr(text.size() / 2));
+    if (out.size() + 8 > size) return "";
+    return out + zstdSkippable(size - out.size());
+}
+#endif
+
+} // namespace
+
+int main() {
+    const fs::path dir = fs::temp_directory_path() / "scoap_input_stream_test";
+    fs::create_directories(dir);
+    // The small and medium netlists fit into one and two reads when stored
+    // uncompressed; the large one decompresses to several ring blocks.
+    const size_t smallGates = 6000, mediumGates = 12000, largeGates = 60000;
+    const std::string small = netlist(smallGates), medium = netlist(mediumGates), large = netlist(largeGates);
+
+    write(dir / "plain.v", large);
+    check("plain", dir / "plain.v", large, largeGates + 1, false);
+
+#ifdef SCOAP_HAVE_ZLIB
+    // Stored (uncompressed) members make the sizes easy to hit: the text
+    // must fit below the target size.
+    for (size_t size : {kReadSize - 1, kReadSize, kReadSize + 1, 2 * kReadSize}) {
+        for (size_t members : {1, 2, 3}) {
+            const std::string& text = size > kReadSize + 1 ? medium : small;
+            const size_t gates = (size > kReadSize + 1 ? mediumGates : smallGates) + 1;
+            const std::string gz = gzipOfSize(text, members, size);
+            if (gz.size() != size) {
+                fail("could not build a gzip file of " + std::to_string(size) + " bytes");
+                continue;
+            }
+            const std::string label = "gzip, " + std::to_string(members) + " members, " + std::to_string(size) + " bytes";
+            write(dir / "boundary.v.gz", gz);
+            check(label, dir / "boundary.v.gz", text, gates, false);
+            write(dir / "truncated.v.gz", gz.substr(0, gz.size() - 8));
+            check(label + ", truncated", dir / "truncated.v.gz", text, gates, true);
+        }
+    }
+    // Compressed, and decompressing to several ring blocks.
+    std::string big;
+    for (int copy = 0; copy < 4; ++copy) big += large;
+    write(dir / "big.v.gz", gzipMember(large, 6, "") + gzipMember(large + large + large, 6, ""));
+    {
+        InputStream in((dir / "big.v.gz").string());
+        const std::string read((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        if (in.failed() || read != big) fail("gzip, several ring blocks: " + (in.failed() ? in.error() : "wrong text"));
+    }
+#else
+    std::cout << "Built without zlib; gzip input is not tested." << std::endl;
+#endif
+
+#ifdef SCOAP_HAVE_ZSTD
+    for (size_t size : {kReadSize - 1, kReadSize, kReadSize + 1, 2 * kReadSize}) {
+        const std::string& text = large;
+        const std::string zst = zstdOfSize(text, size);
+        if (zst.size() != size) {
+            fail("could not build a zstd file of " + std::to_string(size) + " bytes");
+            continue;
+        }
+        const std::string label = "zstd, " + std::to_string(size) + " bytes";
+        write(dir / "boundary.v.zst", zst);
+        check(label, dir / "boundary.v.zst", text, largeGates + 1, false);
+        // Cut into the second data frame, not the skippable padding.
+        write(dir / "truncated.v.zst", zst.substr(0, zstdFrame(text.substr(0, text.size() / 2)).size() + 16));
+        check(label + ", truncated", dir / "truncated.v.zst", text, largeGates + 1, true);
+    }
+#else
+    std::cout << "Built without libzstd; zstd input is not tested." << std::endl;
+#endif
+
+    fs::remove_all(dir);
+    if (failures) {
+        std::cerr << failures << " input stream checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All input stream checks passed." << std::endl;
+    return 0;
+}
@@ -0,0 +1,65 @@
+// Test of NetName.
+//
+// Net maps are ordered by NetName and their order is the order of every
+// output, so NetName must order exactly as the text of the names. Builds
+// random scalar names and bus bits whose texts share prefixes, brackets
+// and digits (including bases that are prefixes of each other, negative
+// and multi-digit indices, and bytes above 0x7f), and requires <, == and
+// the text from str() and operator<< to agree with the strings, and
+// NetName(text) to give back the same name.
+//
+// Usage: net_name_test [names] [seed]
+
+#include "NetName.h"
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+int main(int argc, char** argv) {
+    const size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000;
+    std::mt19937 rng(argc > 2 ? static_cast<unsigned>(std::strtoul(argv[2], nullptr, 10)) : 1u);
+    static const char alphabet[] = {'a', 'b', '_', '1', '9', '[', ']', '/', '.', '\xe9'};
+    static const int32_t indices[] = {0, 1, 2, 9, 10, 11, 19, 20, 99, 100, 101, 1000, 12345, -1, -10, INT32_MAX};
+
+    std::vector<NetName> names;
+    std::vector<std::string> texts;
+    for (size_t i = 0; i < count; ++i) {
+        std::string base(1, "ab"[rng() % 2]);
+        for (size_t n = rng() % 4; n > 0; --n) base += alphabet[rng() % sizeof(alphabet)];
+        const int32_t bit = rng() % 3 == 0 ? NetName::Scalar : indices[rng() % (sizeof(indices) / sizeof(indices[0]))];
+        names.emplace_back(base, bit);
+        texts.push_back(bit == NetName::Scalar ? base : base + "[" + std::to_string(bit) + "]");
+    }
+
+    size_t failures = 0;
+    auto fail = [&](const std::string& what) {
+        if (++failures <= 10) std::cerr << "FAIL: " << what << std::endl;
+    };
+    for (size_t i = 0; i < count; ++i) {
+        std::ostringstream streamed;
+        streamed << names[i];
+        if (names[i].str() != texts[i] || streamed.str() != texts[i] || names[i].size() != texts[i].size()) {
+            fail("text of " + texts[i] + " is " + names[i].str());
+        }
+        // Texts that parse as a bit may have been built as a scalar with
+        // brackets; both must compare equal to their text.
+        const NetName parsed(texts[i]);
+        if (parsed.str() != texts[i]) fail("NetName(" + texts[i] + ") is " + parsed.str());
+        for (size_t j = 0; j < count; j += 1 + rng() % 4) {
+            const bool less = names[i] < names[j], textLess = texts[i] < texts[j];
+            if (less != textLess) fail(texts[i] + " < " + texts[j] + " is " + (less ? "true" : "false"));
+            if ((names[i] == names[j]) != (texts[i] == texts[j]) && names[i].isBit() == names[j].isBit()) {
+                fail(texts[i] + " == " + texts[j] + " disagrees with the text");
+            }
+        }
+    }
+    if (failures) {
+        std::cerr << failures << " net name checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All net name checks passed." << std::endl;
+    return 0;
+}